@@ -64,6 +64,15 @@ void set_random_weights(NNLayer &layer, R &rng, float min = -1.f, float max = 1.
 	layer.biases = sp::generate(sp::len(layer.biases), frng);
 }
 
+// weights are drawn from counter based generator, so they are the same for every evaluation
+// order, layers initialized with the same seed get the same weights
+void set_random_weights(NNLayer &layer, uint32_t seed, float min = -1.f, float max = 1.f){
+	sp::par_assign(
+		layer.weights, sp::random_uniform(sp::rows(layer.weights), sp::cols(layer.weights), seed, min, max)
+	);
+	layer.biases = sp::random_uniform(sp::len(layer.biases), seed ^ 0x5bd1e995, min, max);
+}
+
 
 void feed_forward(NNLayer &layer){
 	layer.sums = layer.weights * *layer.inputs + layer.biases;
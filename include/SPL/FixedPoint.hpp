@@ -1,3 +1,5 @@
+#pragma once
+
 #include "SPL/Utils.hpp"
 
 namespace sp{
@@ -72,7 +74,7 @@ struct FixedPoint{
 // ASSIGN
 	template<size_t BR, class TR>
 	SP_CI const auto &operator =(FixedPoint<BR, TR> rhs) noexcept{
-		constexpr ssize_t points_distance = BR - B;
+		constexpr int64_t points_distance = (int64_t)BR - (int64_t)B;
 		if constexpr (points_distance >= 0)
 			this->data = rhs.data >> points_distance;
 		else
@@ -82,8 +84,8 @@ struct FixedPoint{
 
 // CONVERSIONS
 	template<size_t BR, class TR>
-	SP_CI operator FixedPoint() const noexcept{
-		constexpr ssize_t points_distance = B - BR;
+	SP_CI operator FixedPoint<BR, TR>() const noexcept{
+		constexpr int64_t points_distance = (int64_t)B - (int64_t)BR;
 		if constexpr (points_distance >= 0)
 			return FixedPoint<BR, TR>{this->data >> points_distance};
 		else
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "Utils.hpp"
+
+namespace sp{
+
+// HALF PRECISION FLOATS
+// Storage types, arithmetic converts operands to float and rounds the result back.
+// Float16 is ieee binary16 with 5 exponent and 10 mantissa bits, its largest value is 65504.
+// BFloat16 is the upper half of float, it has the range of float with 7 mantissa bits.
+// Conversions from float round to nearest even.
+
+namespace priv__{
+
+SP_CSI uint16_t float_to_half_bits(float x) noexcept{
+	uint32_t f = std::bit_cast<uint32_t>(x);
+	uint16_t sign = (f >> 16) & 0x8000;
+	uint32_t a = f & 0x7fffffff;
+	if (a > 0x7f800000) return sign | 0x7e00 | ((a >> 13) & 0x3ff);	// nan stays quiet
+	if (a >= 0x47800000) return sign | 0x7c00;	// infinity and values rounded to it
+	if (a < 0x38800000){	// subnormal half
+		if (a < 0x33000000) return sign;
+		uint32_t shift = 126 - (a >> 23);
+		uint32_t mant = (a & 0x7fffff) | 0x800000;
+		uint32_t res = mant >> shift;
+		uint32_t rem = mant & ((1u << shift) - 1);
+		uint32_t half = 1u << (shift - 1);
+		if (rem > half || (rem == half && (res & 1))) ++res;
+		return sign | res;
+	}
+	uint32_t res = (a - 0x38000000) >> 13;
+	uint32_t rem = a & 0x1fff;
+	if (rem > 0x1000 || (rem == 0x1000 && (res & 1))) ++res;	// carry may give infinity
+	return sign | res;
+}
+
+SP_CSI float half_bits_to_float(uint16_t h) noexcept{
+	uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+	uint32_t exp = (h >> 10) & 0x1f;
+	uint32_t mant = h & 0x3ff;
+	if (exp == 0x1f) return std::bit_cast<float>(sign | 0x7f800000 | (mant << 13));
+	if (exp == 0){
+		float res = (float)mant * 5.9604644775390625e-8f;	// 2^-24
+		return sign ? -res : res;
+	}
+	return std::bit_cast<float>(sign | ((exp + 112) << 23) | (mant << 13));
+}
+
+SP_CSI uint16_t float_to_bfloat_bits(float x) noexcept{
+	uint32_t f = std::bit_cast<uint32_t>(x);
+	if ((f & 0x7fffffff) > 0x7f800000) return (f >> 16) | 0x40;
+	return (f + 0x7fff + ((f >> 16) & 1)) >> 16;
+}
+
+SP_CSI float bfloat_bits_to_float(uint16_t h) noexcept{
+	return std::bit_cast<float>((uint32_t)h << 16);
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+
+
+template<bool Brain>
+struct HalfFloat{
+	uint16_t bits;
+
+	constexpr HalfFloat() noexcept = default;
+
+	SP_CI HalfFloat(float x) noexcept :
+		bits{Brain ? priv__::float_to_bfloat_bits(x) : priv__::float_to_half_bits(x)}
+	{}
+
+// CONVERSIONS
+	SP_CI explicit operator float() const noexcept{
+		return Brain ? priv__::bfloat_bits_to_float(bits) : priv__::half_bits_to_float(bits);
+	}
+
+	SP_CI explicit operator double() const noexcept{ return (double)(float)*this; }
+
+	SP_CI explicit operator bool() const noexcept{ return bits & 0x7fff; }
+
+// ARITHMETIC
+	SP_CI HalfFloat &operator +=(HalfFloat rhs) noexcept{
+		return *this = HalfFloat{(float)*this + (float)rhs};
+	}
+
+	SP_CI HalfFloat &operator -=(HalfFloat rhs) noexcept{
+		return *this = HalfFloat{(float)*this - (float)rhs};
+	}
+
+	SP_CI HalfFloat &operator *=(HalfFloat rhs) noexcept{
+		return *this = HalfFloat{(float)*this * (float)rhs};
+	}
+
+	SP_CI HalfFloat &operator /=(HalfFloat rhs) noexcept{
+		return *this = HalfFloat{(float)*this / (float)rhs};
+	}
+};
+
+
+
+template<bool B>
+SP_CSI HalfFloat<B> operator +(HalfFloat<B> lhs, HalfFloat<B> rhs) noexcept{
+	return HalfFloat<B>{(float)lhs + (float)rhs};
+}
+
+template<bool B>
+SP_CSI HalfFloat<B> operator -(HalfFloat<B> lhs, HalfFloat<B> rhs) noexcept{
+	return HalfFloat<B>{(float)lhs - (float)rhs};
+}
+
+template<bool B>
+SP_CSI HalfFloat<B> operator *(HalfFloat<B> lhs, HalfFloat<B> rhs) noexcept{
+	return HalfFloat<B>{(float)lhs * (float)rhs};
+}
+
+template<bool B>
+SP_CSI HalfFloat<B> operator /(HalfFloat<B> lhs, HalfFloat<B> rhs) noexcept{
+	return HalfFloat<B>{(float)lhs / (float)rhs};
+}
+
+template<bool B>
+SP_CSI HalfFloat<B> operator -(HalfFloat<B> x) noexcept{
+	x.bits ^= 0x8000;
+	return x;
+}
+
+// floats on either side are converted
+template<bool B> SP_CSI HalfFloat<B> operator +(HalfFloat<B> lhs, float rhs) noexcept{ return lhs + HalfFloat<B>{rhs}; }
+template<bool B> SP_CSI HalfFloat<B> operator -(HalfFloat<B> lhs, float rhs) noexcept{ return lhs - HalfFloat<B>{rhs}; }
+template<bool B> SP_CSI HalfFloat<B> operator *(HalfFloat<B> lhs, float rhs) noexcept{ return lhs * HalfFloat<B>{rhs}; }
+template<bool B> SP_CSI HalfFloat<B> operator /(HalfFloat<B> lhs, float rhs) noexcept{ return lhs / HalfFloat<B>{rhs}; }
+template<bool B> SP_CSI HalfFloat<B> operator +(float lhs, HalfFloat<B> rhs) noexcept{ return HalfFloat<B>{lhs} + rhs; }
+template<bool B> SP_CSI HalfFloat<B> operator -(float lhs, HalfFloat<B> rhs) noexcept{ return HalfFloat<B>{lhs} - rhs; }
+template<bool B> SP_CSI HalfFloat<B> operator *(float lhs, HalfFloat<B> rhs) noexcept{ return HalfFloat<B>{lhs} * rhs; }
+template<bool B> SP_CSI HalfFloat<B> operator /(float lhs, HalfFloat<B> rhs) noexcept{ return HalfFloat<B>{lhs} / rhs; }
+
+template<bool B> SP_CSI bool operator ==(HalfFloat<B> lhs, HalfFloat<B> rhs) noexcept{ return (float)lhs == (float)rhs; }
+template<bool B> SP_CSI bool operator !=(HalfFloat<B> lhs, HalfFloat<B> rhs) noexcept{ return (float)lhs != (float)rhs; }
+template<bool B> SP_CSI bool operator <(HalfFloat<B> lhs, HalfFloat<B> rhs) noexcept{ return (float)lhs < (float)rhs; }
+template<bool B> SP_CSI bool operator >(HalfFloat<B> lhs, HalfFloat<B> rhs) noexcept{ return (float)lhs > (float)rhs; }
+template<bool B> SP_CSI bool operator <=(HalfFloat<B> lhs, HalfFloat<B> rhs) noexcept{ return (float)lhs <= (float)rhs; }
+template<bool B> SP_CSI bool operator >=(HalfFloat<B> lhs, HalfFloat<B> rhs) noexcept{ return (float)lhs >= (float)rhs; }
+
+template<bool B> SP_CSI bool operator ==(HalfFloat<B> lhs, float rhs) noexcept{ return (float)lhs == rhs; }
+template<bool B> SP_CSI bool operator !=(HalfFloat<B> lhs, float rhs) noexcept{ return (float)lhs != rhs; }
+template<bool B> SP_CSI bool operator <(HalfFloat<B> lhs, float rhs) noexcept{ return (float)lhs < rhs; }
+template<bool B> SP_CSI bool operator >(HalfFloat<B> lhs, float rhs) noexcept{ return (float)lhs > rhs; }
+template<bool B> SP_CSI bool operator <=(HalfFloat<B> lhs, float rhs) noexcept{ return (float)lhs <= rhs; }
+template<bool B> SP_CSI bool operator >=(HalfFloat<B> lhs, float rhs) noexcept{ return (float)lhs >= rhs; }
+template<bool B> SP_CSI bool operator ==(float lhs, HalfFloat<B> rhs) noexcept{ return lhs == (float)rhs; }
+template<bool B> SP_CSI bool operator !=(float lhs, HalfFloat<B> rhs) noexcept{ return lhs != (float)rhs; }
+template<bool B> SP_CSI bool operator <(float lhs, HalfFloat<B> rhs) noexcept{ return lhs < (float)rhs; }
+template<bool B> SP_CSI bool operator >(float lhs, HalfFloat<B> rhs) noexcept{ return lhs > (float)rhs; }
+template<bool B> SP_CSI bool operator <=(float lhs, HalfFloat<B> rhs) noexcept{ return lhs <= (float)rhs; }
+template<bool B> SP_CSI bool operator >=(float lhs, HalfFloat<B> rhs) noexcept{ return lhs >= (float)rhs; }
+
+typedef HalfFloat<false> Float16;
+typedef HalfFloat<true> BFloat16;
+
+} // END OF NAMESPACE ///////////////////////////////////////////////////////////////////
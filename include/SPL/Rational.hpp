@@ -10,37 +10,44 @@ namespace sp{
 
 template<class Base>
 struct Rational{
-	constexpr Rational(const Rational &) noexcept = default;
-	constexpr Rational &operator =(const Rational &) noexcept = default;
-	
 	constexpr Rational &operator +=(const Rational rhs) noexcept{
 		nom = nom*rhs.den + rhs.nom*den;
 		den *= rhs.den;
+		return *this;
 	}
 	constexpr Rational &operator -=(const Rational rhs) noexcept{
 		nom = nom*rhs.den	- rhs.nom*den;
 		den *= rhs.den;
+		return *this;
 	}
 	constexpr Rational &operator *=(const Rational rhs) noexcept{
 		nom *= rhs.nom;
 		den *= rhs.den;
+		return *this;
 	}
 	constexpr Rational &operator /=(const Rational rhs) noexcept{
 		nom *= rhs.den;
 		den *= rhs.nom;
+		return *this;
 	}
 
-	constexpr Rational &operator +=(const Base rhs) noexcept{ nom += rhs * den; }
-	constexpr Rational &operator -=(const Base rhs) noexcept{ nom -= rhs * den; }
-	constexpr Rational &operator *=(const Base rhs) noexcept{ nom *= rhs; }
-	constexpr Rational &operator /=(const Base rhs) noexcept{ den *= rhs; }
+	constexpr Rational &operator +=(const Base rhs) noexcept{ nom += rhs * den; return *this; }
+	constexpr Rational &operator -=(const Base rhs) noexcept{ nom -= rhs * den; return *this; }
+	constexpr Rational &operator *=(const Base rhs) noexcept{ nom *= rhs; return *this; }
+	constexpr Rational &operator /=(const Base rhs) noexcept{ den *= rhs; return *this; }
 
 	constexpr void simplify() noexcept{
-		const Base divider = sp::gcd(nom, den);
-		if (divider != 1){
+		typedef std::make_unsigned_t<Base> UnsB;
+		const Base divider = (Base)sp::gcd((UnsB)sp::abs(nom), (UnsB)sp::abs(den));
+		if (divider > 1){
 			nom /= divider;
 			den /= divider;
 		}
+		if constexpr (std::is_signed_v<Base>)
+			if (den < 0){
+				nom = -nom;
+				den = -den;
+			}
 	}
 
 	operator float() const noexcept{ return (float)nom / (float)den; }
@@ -459,33 +459,38 @@ template<class Signature> struct Delegate;
 
 template<class Res, class... Args>
 struct Delegate<Res(Args...)>{
+	template<class Proc>
+	static Res invoke_object(const void *obj, Args... args) noexcept{
+		return (*(Proc *)obj)(args...);
+	}
+
 	template<class Proc>
 	SP_CI Delegate(const Proc *proc) noexcept{
 		static_assert(std::is_function_v<Proc>);
 		
-		procedure = (void *)&proc;
+		procedure = (void *)proc;
 		object = nullptr;
 	}
 	template<class Proc>
 	SP_CI Delegate(Proc *proc) noexcept{
 		static_assert(std::is_function_v<Proc>);
 		
-		procedure = (void *)&proc;
+		procedure = (void *)proc;
 		object = nullptr;
 	}
 
 	template<class Proc>
 	SP_CI Delegate(const Proc &proc) noexcept{
-		static_assert(std::is_invocable_v<Proc>);
+		static_assert(std::is_invocable_r_v<Res, const Proc &, Args...>);
 
-		procedure = (void *)(Res (Proc::*)(Args...))&Proc::operator();
+		procedure = (void *)&invoke_object<const Proc>;
 		object = &proc;
 	}
 	template<class Proc>
 	SP_CI Delegate(Proc &proc) noexcept{
-		static_assert(std::is_invocable_v<Proc>);
+		static_assert(std::is_invocable_r_v<Res, Proc &, Args...>);
 
-		procedure = (void *)(Res (Proc::*)(Args...))&Proc::operator();
+		procedure = (void *)&invoke_object<Proc>;
 		object = &proc;
 	}
 	
@@ -493,7 +498,7 @@ struct Delegate<Res(Args...)>{
 	SP_CI Delegate &operator =(const Proc *proc) noexcept{
 		static_assert(std::is_function_v<Proc>);
 		
-		procedure = (void *)&proc;
+		procedure = (void *)proc;
 		object = nullptr;
 		return *this;
 	}
@@ -501,24 +506,24 @@ struct Delegate<Res(Args...)>{
 	SP_CI Delegate &operator =(Proc *proc) noexcept{
 		static_assert(std::is_function_v<Proc>);
 		
-		procedure = (void *)&proc;
+		procedure = (void *)proc;
 		object = nullptr;
 		return *this;
 	}
 
 	template<class Proc>
 	SP_CI Delegate &operator =(const Proc &proc) noexcept{
-		static_assert(std::is_invocable_v<Proc>);
+		static_assert(std::is_invocable_r_v<Res, const Proc &, Args...>);
 
-		procedure = (void *)(Res (Proc::*)(Args...))&Proc::operator();
+		procedure = (void *)&invoke_object<const Proc>;
 		object = &proc;
 		return *this;
 	}
 	template<class Proc>
 	SP_CI Delegate &operator =(Proc &proc) noexcept{
-		static_assert(std::is_invocable_v<Proc>);
+		static_assert(std::is_invocable_r_v<Res, Proc &, Args...>);
 
-		procedure = (void *)(Res (Proc::*)(Args...))&Proc::operator();
+		procedure = (void *)&invoke_object<Proc>;
 		object = &proc;
 		return *this;
 	}
@@ -565,6 +570,47 @@ SP_CSI uint32_t min_val(Rand32) noexcept{ return 0; }
 SP_CSI uint32_t max_val(Rand32) noexcept{ return UINT32_MAX; }
 
 
+// counter based generator (philox 2x32 with 10 rounds), the output depends only on the key and
+// the counter, so values can be generated in any order and by any number of threads, the
+// rounds use only 32 bit multiplications, so loops over counters are vectorized
+struct Philox32{
+	SP_CI uint64_t operator ()(uint64_t counter) const noexcept{
+		// halves are kept in 64 bit lanes, so vectorized loop doesn't repack them every round
+		uint64_t lo = counter & 0xffffffff;
+		uint64_t hi = counter >> 32;
+		uint32_t k = key;
+		for (uint32_t i=0; i!=10; ++i){
+			uint64_t prod = lo * 0xd256d193u;
+			lo = (prod >> 32) ^ hi ^ k;
+			hi = prod & 0xffffffff;
+			k += 0x9e3779b9;
+		}
+		return hi << 32 | lo;
+	}
+
+	SP_CI uint64_t operator ()(uint32_t row, uint32_t col) const noexcept{
+		return (*this)(((uint64_t)row << 32) | col);
+	}
+
+	typedef uint64_t ValueType;
+
+	uint32_t key;
+};
+
+SP_CSI uint64_t min_val(Philox32) noexcept{ return 0; }
+SP_CSI uint64_t max_val(Philox32) noexcept{ return UINT64_MAX; }
+
+// maps random bits to [0, 1), all bits of the mantissa are random
+template<class T>
+SP_CSI T unit_real(uint64_t bits) noexcept{
+	static_assert(std::is_floating_point_v<T>, "unit real must be a floating point type");
+	if constexpr (sizeof(T) <= 4)
+		return (T)(uint32_t)(bits >> 40) * (T)0x1p-24;
+	else
+		return (T)(bits >> 11) * (T)0x1p-53;
+}
+
+
 
 
 
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Operations.hpp"
+
+#include <time.h>
+
+namespace sp{
+
+// AUTOTUNING
+// Kernels are timed on square double matrices for candidate block sizes, starting from the
+// current matrixTuning, and the fastest sizes are kept. Tile of product is tuned first, so the
+// panel of lu decomposition is tuned with the product it will run with. The result should be
+// saved with save_tuning into default_tuning_path(), so later programs read it at startup.
+
+namespace priv__{
+
+inline double tune_now() noexcept{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+// the shortest of several runs in seconds
+template<class S, class F>
+double tune_time(S &&setup, F &&kernel, size_t repetitions) noexcept{
+	double best = 1e300;
+	for (size_t i=0; i!=repetitions; ++i){
+		setup();
+		double begin = tune_now();
+		kernel();
+		double time = tune_now() - begin;
+		if (time < best) best = time;
+	}
+	return best;
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+
+
+// finds block sizes for this machine and puts them into the destination and into matrixTuning,
+// size of the matrices is given, it takes a few seconds for the default one, returns true if the
+// allocation failed
+inline bool autotune(MatrixTuning &dest, size_t size = 512) noexcept{
+	typedef MatrixWrapper<MatrixDynamic<double, true, MallocAllocator<>>> TuneMatrix;
+	constexpr size_t MulCandidates[] = {16, 24, 32, 48, 64, 96, 128, 192, 256};
+	constexpr size_t TraverseCandidates[] = {8, 16, 32, 64, 128};
+	constexpr size_t PanelCandidates[] = {16, 32, 48, 64, 96, 128};
+	constexpr size_t Repetitions = 3;
+	if (size < 2*PanelCandidates[0]) size = 2*PanelCandidates[0];
+
+	TuneMatrix A, B, C;
+	DynamicArray<uint32_t, MallocAllocator<>> permuts = {{nullptr, 0}, 0, nullptr};
+	bool failed = resize(A, size, size) || resize(B, size, size) || resize(C, size, size);
+	if (failed || resize(permuts, size)){
+		free(MallocAllocator<>{}, A.data);
+		free(MallocAllocator<>{}, B.data);
+		free(MallocAllocator<>{}, C.data);
+		free(MallocAllocator<>{}, permuts.data);
+		return true;
+	}
+	for (size_t i=0; i!=size; ++i)
+		for (size_t j=0; j!=size; ++j){
+			A(i, j) = (double)((i*7 + j*13) % 17) / 17.0 - 0.5 + (i==j ? (double)size : 0.0);
+			B(i, j) = (double)((i*5 + j*3) % 11) / 11.0;
+		}
+	double *a = beg(A), *b = beg(B), *c = beg(C);
+	auto none = [](){};
+
+	MatrixTuning res = matrixTuning;
+	double best = 1e300;
+	for (size_t len : MulCandidates){
+		size_t bytes = 3*len*len * sizeof(double);
+		if (bytes > res.cacheL2 && len != MulCandidates[0]) break;
+		matrixTuning.mulBytes = bytes;
+		double time = priv__::tune_time(
+			none, [&](){ priv__::gemm_block(c, size, a, size, b, size, size, size, size); }, Repetitions
+		);
+		if (time < best){
+			best = time;
+			res.mulBytes = bytes;
+		}
+	}
+	matrixTuning.mulBytes = res.mulBytes;
+
+	best = 1e300;
+	for (size_t len : TraverseCandidates){
+		matrixTuning.traverseBytes = 2*len*len * sizeof(double);
+		double time = priv__::tune_time(none, [&](){ transpose(C, A); }, Repetitions);
+		if (time < best){
+			best = time;
+			res.traverseBytes = matrixTuning.traverseBytes;
+		}
+	}
+	matrixTuning.traverseBytes = res.traverseBytes;
+
+	// the blocked kernel is called directly, the matrix may fit into cache on some machines
+	best = 1e300;
+	for (size_t panel : PanelCandidates){
+		if (2*panel > size) break;
+		double time = priv__::tune_time(
+			[&](){
+				for (size_t i=0; i!=size*size; ++i) c[i] = a[i];
+				for (size_t i=0; i!=size; ++i) permuts[i] = i;
+			},
+			[&](){ priv__::blocked_lup(c, size, size, size, permuts, panel); },
+			Repetitions
+		);
+		if (time < best){
+			best = time;
+			res.luPanel = panel;
+		}
+	}
+
+	matrixTuning = res;
+	dest = res;
+	free(MallocAllocator<>{}, A.data);
+	free(MallocAllocator<>{}, B.data);
+	free(MallocAllocator<>{}, C.data);
+	free(MallocAllocator<>{}, permuts.data);
+	return false;
+}
+
+} // END OF NAMESPACE ///////////////////////////////////////////////////////////////////////////////////////
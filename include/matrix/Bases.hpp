@@ -12,6 +12,8 @@
 	#define SP_MATRIX_ERROR(cond, msg)
 #endif
 
+#include "Profile.hpp"
+
 namespace sp{
 
 
@@ -22,9 +24,32 @@ enum class StupidVectorFlagType{};
 #define SP_VECTOR_T(V) class V, ::sp::StupidVectorFlagType = ::std::decay_t<V>::VectorFlag
 
 
+template<class Base> struct Rational;
+
+template<class T> constexpr bool IsRational = false;
+template<class B> constexpr bool IsRational<Rational<B>> = true;
+
+// element types for which the operations use fraction-free elimination instead of division
+template<class T> constexpr bool IsExact = std::is_integral_v<T> || IsRational<T>;
+
+
+template<class T> struct Complex;
+template<size_t B, class T> struct FixedPoint;
+
+// multiplicative identity, aggregate element types get every field initialized
+template<class T> struct UnitOf{ static constexpr T value = (T)1; };
+template<class T> struct UnitOf<Complex<T>>{ static constexpr Complex<T> value{UnitOf<T>::value, T{}}; };
+template<class B> struct UnitOf<Rational<B>>{ static constexpr Rational<B> value{(B)1, (B)1}; };
+template<size_t B, class T> struct UnitOf<FixedPoint<B, T>>{
+	static constexpr FixedPoint<B, T> value{(T)((T)1 << B)};
+};
+
+template<class T> SP_CSI T unit() noexcept{ return UnitOf<T>::value; }
+
+
 
 struct DDAJSLdjsaldjaslkdjashdlDASLJD{
-	DynamicArray<uint64_t, sp::MallocAllocator<>> data = {{nullptr, 0}, 0, nullptr};
+	DynamicArray<uint64_t, TempStorageAllocator> data = {{nullptr, 0}, 0, nullptr};
 	size_t stack_pos = 0;
 } MatrixTempStorage;
 
@@ -40,6 +65,8 @@ struct MatrixFixed{
 	constexpr static bool RowMajor = rowMaj;
 	constexpr static bool UndefMajor = false;
 	constexpr static bool UsesBuffer = false;
+	constexpr static size_t StaticRows = rows;
+	constexpr static size_t StaticCols = cols;
 
 	SP_CI T &operator ()(size_t r, size_t c) noexcept{
 		SP_MATRIX_ERROR(r>=rows || c>=cols, "out of bounds matrix indecies");
@@ -72,6 +99,9 @@ SP_CSI size_t len(const MatrixFixed<T, rowMaj, R, C> &m) noexcept{ return R * C;
 template<class T, bool rowMaj, size_t R, size_t C>
 SP_CSI size_t cap(const MatrixFixed<T, rowMaj, R, C> &m) noexcept{ return 0; }
 
+template<class T, bool rowMaj, size_t R, size_t C>
+SP_CSI size_t lead_dim(const MatrixFixed<T, rowMaj, R, C> &m) noexcept{ return rowMaj ? C : R; }
+
 template<class T, bool rowMaj, size_t R, size_t C>
 SP_CSI T *beg(const MatrixFixed<T, rowMaj, R, C> &m) noexcept{ return (T *)m.data; }
 
@@ -131,6 +161,9 @@ SP_CSI size_t len(const MatrixFinite<T, rowMaj, C> &m) noexcept{ return m.rows *
 template<class T, bool rowMaj, size_t C>
 SP_CSI size_t cap(const MatrixFinite<T, rowMaj, C> &m) noexcept{ return C; }
 
+template<class T, bool rowMaj, size_t C>
+SP_CSI size_t lead_dim(const MatrixFinite<T, rowMaj, C> &m) noexcept{ return rowMaj ? m.cols : m.rows; }
+
 template<class T, bool rowMaj, size_t C>
 SP_CSI T *beg(const MatrixFinite<T, rowMaj, C> &m) noexcept{ return (T *)m.data; }
 
@@ -148,69 +181,150 @@ SP_SI void resize(MatrixFinite<T, rowMaj, C> &m, size_t r, size_t c) noexcept{
 
 
 
-template<class T, bool rowMaj, class A>
+// padded matrices start every row (column if column major) at cache line boundary and skip
+// leading dimensions that are multiples of the page size, since rows that far apart
+// fall into the same cache sets
+constexpr size_t PaddedLineAlign = 64;
+constexpr size_t PaddedAliasStride = 4096;
+
+struct MatrixNoLeadDim{};
+
+namespace priv__{
+
+template<class T>
+SP_CSI size_t padded_lead_dim(size_t n) noexcept{
+	size_t bytes = (n*sizeof(T) + PaddedLineAlign - 1) & ~(PaddedLineAlign - 1);
+	if (bytes % PaddedAliasStride == 0) bytes += PaddedLineAlign;
+	return bytes / sizeof(T);
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+template<class T, bool rowMaj, class A, bool padded = false>
 struct MatrixDynamic{
 	typedef T ValueType;
 	static constexpr StupidMatrixFlagType MatrixFlag{};
 	constexpr static bool RowMajor = rowMaj;
 	constexpr static bool UndefMajor = false;
 	constexpr static bool UsesBuffer = false;
+	constexpr static bool Padded = padded;
+
+	static_assert(!padded || PaddedLineAlign%sizeof(T)==0, "padded matrix element must divide a cache line");
+
+	SP_CI T *first() const noexcept{
+		if constexpr (Padded && A::Alignment < PaddedLineAlign)
+			return (T *)align(data.ptr, PaddedLineAlign);
+		else
+			return (T *)data.ptr;
+	}
 
 	SP_CI T &operator ()(size_t r, size_t c) noexcept{
 		SP_MATRIX_ERROR(r>=rows || c>=cols, "out of bounds matrix indecies");
-		if constexpr (RowMajor)
-			return *((T *)data.ptr + r*cols + c);
-		else
-			return *((T *)data.ptr + r + c*rows);
+		if constexpr (Padded){
+			if constexpr (RowMajor)
+				return *(first() + r*lead_dim + c);
+			else
+				return *(first() + r + c*lead_dim);
+		} else{
+			if constexpr (RowMajor)
+				return *((T *)data.ptr + r*cols + c);
+			else
+				return *((T *)data.ptr + r + c*rows);
+		}
 	}
 	
 	SP_CI const T &operator ()(size_t r, size_t c) const noexcept{
 		SP_MATRIX_ERROR(r>=rows || c>=cols, "out of bounds matrix indecies");
-		if constexpr (RowMajor)
-			return *((const T *)data.ptr + r*cols + c);
-		else
-			return *((const T *)data.ptr + r + c*rows);
+		if constexpr (Padded){
+			if constexpr (RowMajor)
+				return *(first() + r*lead_dim + c);
+			else
+				return *(first() + r + c*lead_dim);
+		} else{
+			if constexpr (RowMajor)
+				return *((const T *)data.ptr + r*cols + c);
+			else
+				return *((const T *)data.ptr + r + c*rows);
+		}
 	}
 
 	Memblock data = {nullptr, 0};
 	uint32_t rows = 0;
 	uint32_t cols = 0;
 	A *allocator = nullptr;
+	[[no_unique_address]] std::conditional_t<padded, uint32_t, MatrixNoLeadDim> lead_dim{};
 };
 
-template<class T, bool rowMaj, class A>
-SP_CSI size_t rows(const MatrixDynamic<T, rowMaj, A> &m) noexcept{ return m.rows; }
+template<class T, bool rowMaj, class A, bool P>
+SP_CSI size_t rows(const MatrixDynamic<T, rowMaj, A, P> &m) noexcept{ return m.rows; }
+
+template<class T, bool rowMaj, class A, bool P>
+SP_CSI size_t cols(const MatrixDynamic<T, rowMaj, A, P> &m) noexcept{ return m.cols; }
 
-template<class T, bool rowMaj, class A>
-SP_CSI size_t cols(const MatrixDynamic<T, rowMaj, A> &m) noexcept{ return m.cols; }
+template<class T, bool rowMaj, class A, bool P>
+SP_CSI size_t len(const MatrixDynamic<T, rowMaj, A, P> &m) noexcept{ return m.rows * m.cols; }
 
-template<class T, bool rowMaj, class A>
-SP_CSI size_t len(const MatrixDynamic<T, rowMaj, A> &m) noexcept{ return m.rows * m.cols; }
+template<class T, bool rowMaj, class A, bool P>
+SP_CSI size_t cap(const MatrixDynamic<T, rowMaj, A, P> &m) noexcept{ return m.data.size / sizeof(T); }
 
-template<class T, bool rowMaj, class A>
-SP_CSI size_t cap(const MatrixDynamic<T, rowMaj, A> &m) noexcept{ return m.data.size / sizeof(T); }
+template<class T, bool rowMaj, class A, bool P>
+SP_CSI size_t lead_dim(const MatrixDynamic<T, rowMaj, A, P> &m) noexcept{
+	if constexpr (P)
+		return m.lead_dim;
+	else
+		return rowMaj ? m.cols : m.rows;
+}
 
-template<class T, bool rowMaj, class A>
-SP_CSI T *beg(const MatrixDynamic<T, rowMaj, A> &m) noexcept{ return (T *)m.data.ptr; }
+template<class T, bool rowMaj, class A, bool P>
+SP_CSI T *beg(const MatrixDynamic<T, rowMaj, A, P> &m) noexcept{ return m.first(); }
 
-template<class T, bool rowMaj, class A>
-SP_CSI T *end(const MatrixDynamic<T, rowMaj, A> &m) noexcept{
-	return (T *)m.data.ptr + m.rows*m.cols - 1;
+template<class T, bool rowMaj, class A, bool P>
+SP_CSI T *end(const MatrixDynamic<T, rowMaj, A, P> &m) noexcept{
+	if constexpr (P){
+		if (!m.rows || !m.cols) return m.first() - 1;
+		if constexpr (rowMaj)
+			return m.first() + (m.rows-1)*(size_t)m.lead_dim + m.cols - 1;
+		else
+			return m.first() + (m.cols-1)*(size_t)m.lead_dim + m.rows - 1;
+	} else{
+		return (T *)m.data.ptr + m.rows*m.cols - 1;
+	}
 }
 
-template<class T, bool rowMaj, class A>
+template<class T, bool rowMaj, class A, bool P>
 SP_SI bool resize(
-	MatrixDynamic<T, rowMaj, A> &m, size_t r, size_t c
+	MatrixDynamic<T, rowMaj, A, P> &m, size_t r, size_t c
 ) noexcept{
-	size_t size = r * c * sizeof(T);
-	if (m.data.size < size){
-		Memblock blk;
-		if constexpr (A::Alignment)
-			blk = realloc(*m.allocator, m.data, size);
-		else
-			blk = realloc(*m.allocator, m.data, size, alignof(T));
-		if (blk.ptr == nullptr) return true;
-		m.data = blk;
+	if constexpr (P){
+		size_t ld = priv__::padded_lead_dim<T>(rowMaj ? c : r);
+		size_t size = (rowMaj ? r : c) * ld * sizeof(T);
+		constexpr size_t extra = A::Alignment && A::Alignment<PaddedLineAlign ? PaddedLineAlign : 0;
+		if (m.data.size < size + extra){	// old contents are not preserved, so there is no need to copy them
+			if (m.data.ptr) free(*m.allocator, m.data);
+			Memblock blk;
+			if constexpr (A::Alignment)
+				blk = alloc(*m.allocator, size + extra);
+			else
+				blk = alloc(*m.allocator, size, PaddedLineAlign);
+			m.data = blk;
+			if (blk.ptr == nullptr){
+				m.rows = 0;
+				m.cols = 0;
+				return true;
+			}
+		}
+		m.lead_dim = ld;
+	} else{
+		size_t size = r * c * sizeof(T);
+		if (m.data.size < size){
+			Memblock blk;
+			if constexpr (A::Alignment)
+				blk = realloc(*m.allocator, m.data, size);
+			else
+				blk = realloc(*m.allocator, m.data, size, alignof(T));
+			if (blk.ptr == nullptr) return true;
+			m.data = blk;
+		}
 	}
 	
 	m.rows = r;
@@ -248,6 +362,7 @@ struct VectorFixed{
 	typedef T ValueType;
 	static constexpr StupidVectorFlagType VectorFlag{};
 	constexpr static bool UsesBuffer = false;
+	constexpr static size_t StaticLen = size;
 
 	SP_CI T &operator [](size_t i) noexcept{
 		SP_MATRIX_ERROR(i >= size, "out of bounds vector index");
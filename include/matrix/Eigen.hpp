@@ -0,0 +1,551 @@
+#pragma once
+
+#include "Expr.hpp"
+#include <math.h>
+#include <limits>
+
+namespace sp{
+
+// SYMMETRIC EIGEN DECOMPOSITION
+// The matrix is reduced to tridiagonal form by householder reflections and the tridiagonal
+// matrix is diagonalized by QL iterations with implicit shifts. Both phases work on row major
+// workspace taken from the allocator, the eigenvectors are accumulated as rows, so every
+// reflection and rotation only touches contiguous memory.
+//
+// SINGULAR VALUE DECOMPOSITION
+// The columns of matrix (or its rows when it's wide) are compressed by householder QR into
+// square triangle, whose columns are orthogonalized by one sided jacobi rotations. The left
+// singular vectors are the rotated columns mapped back through the reflections, so the thin
+// decomposition of m x n matrix needs only O(m*n) memory.
+
+
+
+namespace priv__{
+
+// dot product with independent accumulators, so it's vectorized without reassociation
+template<class T>
+SP_SI T lane_dot(const T *lhs, const T *rhs, size_t len) noexcept{
+	constexpr size_t Lanes = 64 / sizeof(T);
+	T acc[Lanes] = {};
+	size_t i = 0;
+	for (; i+Lanes<=len; i+=Lanes)
+		for (size_t l=0; l!=Lanes; ++l) acc[l] += lhs[i+l] * rhs[i+l];
+	T res = (T)0;
+	for (size_t l=0; l!=Lanes; ++l) res += acc[l];
+	for (; i!=len; ++i) res += lhs[i] * rhs[i];
+	return res;
+}
+
+constexpr size_t TridiagonalBlockLen = 32;	// reflections applied to trailing block at once
+constexpr size_t TridiagonalChunkLen = 128;	// columns of trailing block updated at once
+constexpr size_t ReflectionRowsLen = 8;		// rows of orthogonal matrix built at once
+
+// reduces symmetric row major n x n matrix W to tridiagonal matrix with diagonal d and
+// off diagonal e (e[i] is at (i, i+1), e[n-1] is 0), householder vector of k-th step is left
+// in row k right of the diagonal and its scale in beta[k], panel is 2*TridiagonalBlockLen*n
+// elements of scratch
+// reflections are gathered in panels, the trailing block is read once per reflection for the
+// product with householder vector and updated once per panel (like lapack's sytrd)
+template<class T>
+void tridiagonalize(T *W, size_t n, T *d, T *e, T *beta, T *panel) noexcept{
+	constexpr size_t BlockLen = TridiagonalBlockLen;
+	T *Vp = panel;	// householder vectors of the panel
+	T *Wp = panel + BlockLen*n;	// their updates, the block is A - Vp*Wp^T - Wp*Vp^T
+	T coefV[BlockLen], coefW[BlockLen];
+
+	for (size_t k0=0; k0+2<n; k0+=BlockLen){
+		size_t panelLen = k0+BlockLen < n-2 ? BlockLen : n-2-k0;
+		for (size_t j=0; j!=panelLen; ++j){
+			size_t k = k0 + j;
+			T *row = W + k*n;
+			for (size_t t=0; t!=j; ++t){
+				const T *vt = Vp + t*n;
+				const T *wt = Wp + t*n;
+				T a = wt[k], b = vt[k];
+				for (size_t i=k; i!=n; ++i) row[i] -= vt[i]*a + wt[i]*b;
+			}
+
+			T *vj = Vp + j*n;
+			T *wj = Wp + j*n;
+			for (size_t i=0; i!=n; ++i){
+				vj[i] = (T)0;
+				wj[i] = (T)0;
+			}
+			T *v = row + k+1;
+			size_t m = n - k - 1;
+
+			T norm = sqrt(lane_dot(v, v, m));
+			d[k] = row[k];
+			if (norm == (T)0){
+				e[k] = (T)0;
+				beta[k] = (T)0;
+				continue;
+			}
+			T alpha = v[0] > (T)0 ? -norm : norm;
+			e[k] = alpha;
+			v[0] -= alpha;
+			beta[k] = (T)1 / (norm * (v[0] > (T)0 ? v[0] : -v[0]));	// 2 / (v^T v)
+			for (size_t i=0; i!=m; ++i) vj[k+1 + i] = v[i];
+
+			// p = beta*S*v, w = p - (beta/2 * v^T p)*v, where S is the current trailing block
+			const T *S = W + (k+1)*n + k+1;
+			T *w = wj + k+1;
+			for (size_t i=0; i!=m; ++i){
+				w[i] = lane_dot(S + i*n, v, m);
+			}
+			for (size_t t=0; t!=j; ++t){
+				const T *vt = Vp + t*n + k+1;
+				const T *wt = Wp + t*n + k+1;
+				coefV[t] = lane_dot(vt, v, m);
+				coefW[t] = lane_dot(wt, v, m);
+			}
+			for (size_t t=0; t!=j; ++t){
+				const T *vt = Vp + t*n + k+1;
+				const T *wt = Wp + t*n + k+1;
+				for (size_t i=0; i!=m; ++i) w[i] -= vt[i]*coefW[t] + wt[i]*coefV[t];
+			}
+			T vp = (T)0;
+			for (size_t i=0; i!=m; ++i){
+				w[i] *= beta[k];
+				vp += v[i] * w[i];
+			}
+			T K = beta[k] * vp / (T)2;
+			for (size_t i=0; i!=m; ++i) w[i] -= K * v[i];
+		}
+
+		size_t kb = k0 + panelLen;
+		for (size_t i=kb; i!=n; ++i){
+			T *row = W + i*n;
+			for (size_t cb=kb; cb<n; cb+=TridiagonalChunkLen){
+				size_t ce = cb+TridiagonalChunkLen < n ? cb+TridiagonalChunkLen : n;
+				for (size_t t=0; t!=panelLen; ++t){
+					const T *vt = Vp + t*n;
+					const T *wt = Wp + t*n;
+					T a = vt[i], b = wt[i];
+					for (size_t c=cb; c!=ce; ++c) row[c] -= a*wt[c] + b*vt[c];
+				}
+			}
+		}
+	}
+	if (n > 1){
+		d[n-2] = W[(n-2)*n + n-2];
+		e[n-2] = W[(n-2)*n + n-1];
+	}
+	d[n-1] = W[(n-1)*n + n-1];
+	e[n-1] = (T)0;
+}
+
+// builds transposed orthogonal matrix of the reduction in Z, its rows are the columns of Q,
+// row i is e_i^T * H_(n-3) * ... * H_0, so a few rows are built at once and stay in cache
+template<class T>
+void accumulate_reflections(T *Z, size_t n, const T *W, const T *beta) noexcept{
+	for (size_t i=0; i!=n*n; ++i) Z[i] = (T)0;
+	for (size_t i=0; i!=n; ++i) Z[i*n + i] = (T)1;
+	for (size_t i0=1; i0<n; i0+=ReflectionRowsLen){
+		size_t i1 = i0+ReflectionRowsLen < n ? i0+ReflectionRowsLen : n;
+		for (size_t k=(i1-2 < n-2 ? i1-2 : n-3); k!=(size_t)-1; --k){
+			if (beta[k] == (T)0) continue;
+			const T *v = W + k*n + k+1;
+			size_t m = n - k - 1;
+			for (size_t i=(i0 > k+1 ? i0 : k+1); i<i1; ++i){
+				T *row = Z + i*n + k+1;
+				T sum = beta[k] * lane_dot(row, v, m);
+				for (size_t j=0; j!=m; ++j) row[j] -= sum * v[j];
+			}
+		}
+	}
+}
+
+// diagonalizes symmetric tridiagonal matrix by QL iterations with implicit wilkinson shifts,
+// the rotations are applied to rows of Z if it isn't nullptr, returns true if an eigenvalue
+// didn't converge in 30 iterations
+template<class T>
+bool tridiagonal_ql(T *d, T *e, size_t n, T *Z) noexcept{
+	const T eps = std::numeric_limits<T>::epsilon();
+	T f = (T)0, tst1 = (T)0;
+	for (size_t l=0; l!=n; ++l){
+		T mag = (d[l] < (T)0 ? -d[l] : d[l]) + (e[l] < (T)0 ? -e[l] : e[l]);
+		if (mag > tst1) tst1 = mag;
+		size_t m = l;
+		while (m+1 < n && (e[m] < (T)0 ? -e[m] : e[m]) > eps*tst1) ++m;
+
+		if (m > l){
+			size_t iter = 0;
+			do{
+				if (++iter > 30) return true;
+				T g = d[l];
+				T p = (d[l+1] - g) / ((T)2 * e[l]);
+				T r = hypot(p, (T)1);
+				if (p < (T)0) r = -r;
+				d[l] = e[l] / (p + r);
+				d[l+1] = e[l] * (p + r);
+				T dl1 = d[l+1];
+				T h = g - d[l];
+				for (size_t i=l+2; i<n; ++i) d[i] -= h;
+				f += h;
+
+				p = d[m];
+				T c = (T)1, c2 = (T)1, c3 = (T)1;
+				T el1 = e[l+1];
+				T s = (T)0, s2 = (T)0;
+				for (size_t i=m-1; i!=l-1; --i){
+					c3 = c2;
+					c2 = c;
+					s2 = s;
+					g = c * e[i];
+					h = c * p;
+					r = hypot(p, e[i]);
+					e[i+1] = s * r;
+					s = e[i] / r;
+					c = p / r;
+					p = c*d[i] - s*g;
+					d[i+1] = h + s*(c*g + s*d[i]);
+					if (Z){
+						T *zi = Z + i*n;
+						T *zi1 = zi + n;
+						for (size_t k=0; k!=n; ++k){
+							T zh = zi1[k];
+							zi1[k] = s*zi[k] + c*zh;
+							zi[k] = c*zi[k] - s*zh;
+						}
+					}
+				}
+				p = -s * s2 * c3 * el1 * e[l] / dl1;
+				e[l] = s * p;
+				d[l] = c * p;
+			} while ((e[l] < (T)0 ? -e[l] : e[l]) > eps*tst1);
+		}
+		d[l] += f;
+		e[l] = (T)0;
+	}
+	return false;
+}
+
+template<bool withVectors, class V, class M1, class M2, class Al>
+bool symmetric_eigen_impl(V &values, M1 *vectors, const M2 &A, Al &allocator) noexcept{
+	SP_MATRIX_ERROR(rows(A) != cols(A), "only square matrix can be eigen decomposed");
+	typedef typename std::decay_t<V>::ValueType T;
+	size_t n = rows(A);
+	resize(values, n);
+	if (n == 0) return false;
+
+	size_t totalLen = n*n + 3*n + 2*TridiagonalBlockLen*n + (withVectors ? n*n : 0);
+	Memblock blk;
+	if constexpr (Al::Alignment)
+		blk = alloc(allocator, totalLen * sizeof(T));
+	else
+		blk = alloc(allocator, totalLen * sizeof(T), alignof(T));
+	if (blk.ptr == nullptr) return true;
+	T *W = (T *)blk.ptr;
+	T *d = W + n*n;
+	T *e = d + n;
+	T *beta = e + n;
+	T *panel = beta + n;
+	T *Z = withVectors ? panel + 2*TridiagonalBlockLen*n : nullptr;
+
+	for (size_t i=0; i!=n; ++i)	// only the lower triangle is read
+		for (size_t j=0; j<=i; ++j)
+			W[i*n + j] = W[j*n + i] = (T)A(i, j);
+
+	tridiagonalize(W, n, d, e, beta, panel);
+	if constexpr (withVectors) accumulate_reflections(Z, n, W, beta);
+	bool failed = tridiagonal_ql(d, e, n, Z);
+
+	for (size_t i=0; i!=n; ++i){	// sort ascending
+		size_t k = i;
+		for (size_t j=i+1; j!=n; ++j)
+			if (d[j] < d[k]) k = j;
+		if (k == i) continue;
+		swap(d[i], d[k]);
+		if constexpr (withVectors)
+			for (size_t j=0; j!=n; ++j) swap(Z[i*n + j], Z[k*n + j]);
+	}
+
+	for (size_t i=0; i!=n; ++i) values[i] = d[i];
+	if constexpr (withVectors){
+		resize(*vectors, n, n);
+		for (size_t i=0; i!=n; ++i)
+			for (size_t j=0; j!=n; ++j)
+				(*vectors)(i, j) = Z[j*n + i];
+	}
+
+	free(allocator, blk);
+	return failed;
+}
+
+constexpr size_t JacobiMaxSweeps = 60;
+
+// computes the thin svd of matrix whose p columns of length q (p <= q) are rows of G, on return
+// sigma holds descending singular values, rows of U the left singular vectors (if U isn't
+// nullptr) and rows of Vt the right singular vectors (if Vt isn't nullptr), G is destroyed,
+// R is p*p and scale p elements of scratch, returns true if jacobi sweeps didn't converge
+template<class T>
+bool thin_svd(T *G, size_t p, size_t q, T *sigma, T *U, T *Vt, T *R, T *scale) noexcept{
+	// householder QR, the reflector of k-th column is left in G[k][k..q), columns of R are
+	// kept as rows of R
+	for (size_t k=0; k!=p; ++k){
+		T *v = G + k*q + k;
+		size_t m = q - k;
+		T norm = sqrt(lane_dot(v, v, m));
+		T alpha = v[0] > (T)0 ? -norm : norm;
+		scale[k] = (T)0;
+		if (norm != (T)0){
+			v[0] -= alpha;
+			scale[k] = (T)1 / (norm * (v[0] > (T)0 ? v[0] : -v[0]));
+			for (size_t j=k+1; j!=p; ++j){
+				T *col = G + j*q + k;
+				T f = scale[k] * lane_dot(v, col, m);
+				for (size_t i=0; i!=m; ++i) col[i] -= f * v[i];
+			}
+		}
+		for (size_t i=0; i!=p; ++i) R[k*p + i] = i < k ? G[k*q + i] : (T)0;
+		R[k*p + k] = alpha;
+	}
+
+	if (Vt){
+		for (size_t i=0; i!=p*p; ++i) Vt[i] = (T)0;
+		for (size_t i=0; i!=p; ++i) Vt[i*p + i] = (T)1;
+	}
+
+	// one sided jacobi, columns i and j are rotated until they are orthogonal
+	const T eps = std::numeric_limits<T>::epsilon();
+	bool failed = true;
+	for (size_t sweep=0; sweep!=JacobiMaxSweeps; ++sweep){
+		bool rotated = false;
+		for (size_t i=0; i+1<p; ++i)
+			for (size_t j=i+1; j!=p; ++j){
+				T *ri = R + i*p;
+				T *rj = R + j*p;
+				T alpha = lane_dot(ri, ri, p);
+				T beta = lane_dot(rj, rj, p);
+				T gamma = lane_dot(ri, rj, p);
+				if (alpha == (T)0 || beta == (T)0) continue;
+				if ((gamma < (T)0 ? -gamma : gamma) <= eps * sqrt(alpha * beta)) continue;
+				rotated = true;
+
+				T zeta = (beta - alpha) / ((T)2 * gamma);
+				T t = (T)1 / ((zeta < (T)0 ? -zeta : zeta) + sqrt((T)1 + zeta*zeta));
+				if (zeta < (T)0) t = -t;
+				T c = (T)1 / sqrt((T)1 + t*t);
+				T s = c * t;
+				for (size_t k=0; k!=p; ++k){
+					T a = ri[k], b = rj[k];
+					ri[k] = c*a - s*b;
+					rj[k] = s*a + c*b;
+				}
+				if (Vt){
+					T *vi = Vt + i*p;
+					T *vj = Vt + j*p;
+					for (size_t k=0; k!=p; ++k){
+						T a = vi[k], b = vj[k];
+						vi[k] = c*a - s*b;
+						vj[k] = s*a + c*b;
+					}
+				}
+			}
+		if (!rotated){
+			failed = false;
+			break;
+		}
+	}
+
+	for (size_t i=0; i!=p; ++i){
+		T *ri = R + i*p;
+		sigma[i] = sqrt(lane_dot(ri, ri, p));
+		if (sigma[i] != (T)0)
+			for (size_t k=0; k!=p; ++k) ri[k] /= sigma[i];
+	}
+
+	for (size_t i=0; i!=p; ++i){	// sort descending
+		size_t k = i;
+		for (size_t j=i+1; j!=p; ++j)
+			if (sigma[j] > sigma[k]) k = j;
+		if (k == i) continue;
+		swap(sigma[i], sigma[k]);
+		for (size_t j=0; j!=p; ++j) swap(R[i*p + j], R[k*p + j]);
+		if (Vt)
+			for (size_t j=0; j!=p; ++j) swap(Vt[i*p + j], Vt[k*p + j]);
+	}
+
+	if (U){
+		// columns of zero singular values are completed to an orthonormal basis
+		for (size_t i=0, e=0; i!=p; ++i){
+			if (sigma[i] != (T)0) continue;
+			T *ri = R + i*p;
+			for (T norm=(T)0; norm < (T)0.5 && e!=p; ++e){
+				for (size_t k=0; k!=p; ++k) ri[k] = k==e ? (T)1 : (T)0;
+				for (size_t pass=0; pass!=2; ++pass)
+					for (size_t j=0; j!=p; ++j){
+						if (j == i || (sigma[j] == (T)0 && j > i)) continue;
+						const T *rj = R + j*p;
+						T f = lane_dot(ri, rj, p);
+						for (size_t k=0; k!=p; ++k) ri[k] -= f * rj[k];
+					}
+				norm = sqrt(lane_dot(ri, ri, p));
+				if (norm >= (T)0.5)
+					for (size_t k=0; k!=p; ++k) ri[k] /= norm;
+			}
+		}
+		for (size_t i=0; i!=p; ++i){
+			T *ui = U + i*q;
+			for (size_t k=0; k!=q; ++k) ui[k] = k < p ? R[i*p + k] : (T)0;
+		}
+		for (size_t k=p-1; k!=(size_t)-1; --k){
+			if (scale[k] == (T)0) continue;
+			const T *v = G + k*q + k;
+			size_t m = q - k;
+			for (size_t i=0; i!=p; ++i){
+				T *col = U + i*q + k;
+				T f = scale[k] * lane_dot(v, col, m);
+				for (size_t j=0; j!=m; ++j) col[j] -= f * v[j];
+			}
+		}
+	}
+	return failed;
+}
+
+template<bool withVectors, class V, class M1, class M2, class M3, class Al>
+bool svd_impl(V &values, M1 *Uout, M2 *Vout, const M3 &A, Al &allocator) noexcept{
+	typedef typename std::decay_t<V>::ValueType T;
+	size_t m = rows(A), n = cols(A);
+	bool wide = m < n;
+	size_t p = wide ? m : n;
+	size_t q = wide ? n : m;
+	resize(values, p);
+	if (p == 0) return false;
+
+	size_t totalLen = p*q + p*p + 2*p + (withVectors ? p*q + p*p : 0);
+	Memblock blk;
+	if constexpr (Al::Alignment)
+		blk = alloc(allocator, totalLen * sizeof(T));
+	else
+		blk = alloc(allocator, totalLen * sizeof(T), alignof(T));
+	if (blk.ptr == nullptr) return true;
+	T *G = (T *)blk.ptr;
+	T *R = G + p*q;
+	T *sigma = R + p*p;
+	T *scale = sigma + p;
+	T *U = withVectors ? scale + p : nullptr;
+	T *Vt = withVectors ? U + p*q : nullptr;
+
+	if constexpr (std::decay_t<M3>::RowMajor){	// G is filled in order of the source
+		for (size_t i=0; i!=m; ++i)
+			for (size_t j=0; j!=n; ++j)
+				(wide ? G[i*q + j] : G[j*q + i]) = (T)A(i, j);
+	} else{
+		for (size_t j=0; j!=n; ++j)
+			for (size_t i=0; i!=m; ++i)
+				(wide ? G[i*q + j] : G[j*q + i]) = (T)A(i, j);
+	}
+
+	bool failed = thin_svd(G, p, q, sigma, U, Vt, R, scale);
+	for (size_t i=0; i!=p; ++i) values[i] = sigma[i];
+
+	if constexpr (withVectors){
+		// for wide matrix the decomposition of transposition was computed, so U and V are swapped
+		resize(*Uout, m, p);
+		resize(*Vout, n, p);
+		const T *left = wide ? Vt : U;
+		const T *right = wide ? U : Vt;
+		for (size_t i=0; i!=m; ++i)
+			for (size_t j=0; j!=p; ++j) (*Uout)(i, j) = left[j*(wide ? p : q) + i];
+		for (size_t i=0; i!=n; ++i)
+			for (size_t j=0; j!=p; ++j) (*Vout)(i, j) = right[j*(wide ? q : p) + i];
+	}
+
+	free(allocator, blk);
+	return failed;
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+
+
+// puts ascending eigenvalues of symmetric matrix into the vector and corresponding orthonormal
+// eigenvectors into columns of the matrix, only the lower triangle of matrix is read, returns
+// true if the workspace couldn't be allocated or the iterations didn't converge
+template<SP_VECTOR_T(V), SP_MATRIX_T(M1), SP_MATRIX_T(M2), class Al>
+bool symmetric_eigen(V &&values, M1 &&vectors, M2 &&A, Al &allocator) noexcept{
+	return priv__::symmetric_eigen_impl<true>(values, &vectors, A, allocator);
+}
+
+// puts ascending eigenvalues of symmetric matrix into the vector, cheaper than symmetric_eigen
+// because the orthogonal transformations aren't accumulated
+template<SP_VECTOR_T(V), SP_MATRIX_T(M), class Al>
+bool symmetric_eigenvalues(V &&values, M &&A, Al &allocator) noexcept{
+	return priv__::symmetric_eigen_impl<false>(values, (std::decay_t<M> *)nullptr, A, allocator);
+}
+
+
+
+// puts descending singular values of m x n matrix into the vector, left singular vectors into
+// columns of m x min(m, n) matrix U and right singular vectors into columns of n x min(m, n)
+// matrix V, so A = U * diag(values) * tr(V), returns true if the workspace couldn't be
+// allocated or the jacobi sweeps didn't converge
+template<SP_VECTOR_T(V), SP_MATRIX_T(M1), SP_MATRIX_T(M2), SP_MATRIX_T(M3), class Al>
+bool svd(V &&values, M1 &&U, M2 &&Vm, M3 &&A, Al &allocator) noexcept{
+	return priv__::svd_impl<true>(values, &U, &Vm, A, allocator);
+}
+
+// puts descending singular values of matrix into the vector
+template<SP_VECTOR_T(V), SP_MATRIX_T(M), class Al>
+bool singular_values(V &&values, M &&A, Al &allocator) noexcept{
+	return priv__::svd_impl<false>(
+		values, (std::decay_t<M> *)nullptr, (std::decay_t<M> *)nullptr, A, allocator
+	);
+}
+
+// puts the pseudo inverse of matrix into the destination matrix, singular values not greater
+// than tolerance times the largest one are treated as zero, returns true if the workspace
+// couldn't be allocated or the jacobi sweeps didn't converge
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2), class Al>
+bool pinvert_svd(
+	M1 &&dest, M2 &&A, Al &allocator, typename std::decay_t<M1>::ValueType tolerance =
+		std::numeric_limits<typename std::decay_t<M1>::ValueType>::epsilon() * 16
+) noexcept{
+	typedef typename std::decay_t<M1>::ValueType T;
+	size_t m = rows(A), n = cols(A);
+	bool wide = m < n;
+	size_t p = wide ? m : n;
+	size_t q = wide ? n : m;
+	resize(dest, n, m);
+	if (p == 0) return false;
+
+	size_t totalLen = 2*p*q + 2*p*p + 2*p;
+	Memblock blk;
+	if constexpr (Al::Alignment)
+		blk = alloc(allocator, totalLen * sizeof(T));
+	else
+		blk = alloc(allocator, totalLen * sizeof(T), alignof(T));
+	if (blk.ptr == nullptr) return true;
+	T *G = (T *)blk.ptr;
+	T *U = G + p*q;
+	T *Vt = U + p*q;
+	T *R = Vt + p*p;
+	T *sigma = R + p*p;
+	T *scale = sigma + p;
+
+	for (size_t i=0; i!=m; ++i)
+		for (size_t j=0; j!=n; ++j)
+			(wide ? G[i*q + j] : G[j*q + i]) = (T)A(i, j);
+	bool failed = priv__::thin_svd(G, p, q, sigma, U, Vt, R, scale);
+
+	// A+ = V * inv(S) * tr(U), for wide matrix U and V are swapped
+	T cutoff = tolerance * sigma[0];
+	for (size_t i=0; i!=p; ++i) sigma[i] = sigma[i] > cutoff ? (T)1 / sigma[i] : (T)0;
+	const T *left = wide ? U : Vt;	// rows of length n
+	const T *right = wide ? Vt : U;	// rows of length m
+	for (size_t r=0; r!=n; ++r)
+		for (size_t c=0; c!=m; ++c){
+			T sum = (T)0;
+			for (size_t i=0; i!=p; ++i) sum += left[i*n + r] * sigma[i] * right[i*m + c];
+			dest(r, c) = sum;
+		}
+
+	free(allocator, blk);
+	return failed;
+}
+
+
+
+} // END OF NAMESPACE ///////////////////////////////////////////////////////////////////
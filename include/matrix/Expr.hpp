@@ -1,55 +1,241 @@
 #pragma once
 
-#include "Bases.hpp"
+#include "Tuning.hpp"
+
+#include <utility>
 
 namespace sp{
 
 
-constexpr size_t CacheSize = 32768;
-constexpr size_t CachePage = 64;
 
-constexpr size_t CacheAvalible = CacheSize / 2;
-constexpr size_t CacheBlockLen = int_sqrt(CacheAvalible);
+// extent of expression which is known only at runtime
+constexpr size_t DynamicSize = SIZE_MAX;
+
+// loops over fixed dimensions up to this length are unrolled
+constexpr size_t UnrollLen = 16;
+
+
+
+namespace priv__{
+
+template<class M, class = void>
+constexpr bool IsMixedMajor = false;
+
+template<class M>
+constexpr bool IsMixedMajor<M, std::void_t<decltype(M::MixedMajor)>> = M::MixedMajor;
+
+// true if some leaves of the expression are row major and others are column major
+template<class A, class B = void>
+constexpr bool MixedMajor = IsMixedMajor<A> || IsMixedMajor<B> ||
+		(!A::UndefMajor && !B::UndefMajor && A::RowMajor != B::RowMajor);
+
+template<class A>
+constexpr bool MixedMajor<A, void> = IsMixedMajor<A>;
+
+// dimensions known at compile time, nodes of expressions take them from their operands, so
+// sizes of fixed matrices are checked while compiling
+template<class M, class = void>
+constexpr size_t StaticRowsOf = DynamicSize;
+
+template<class M>
+constexpr size_t StaticRowsOf<M, std::void_t<decltype(M::StaticRows)>> = M::StaticRows;
+
+template<class M, class = void>
+constexpr size_t StaticColsOf = DynamicSize;
+
+template<class M>
+constexpr size_t StaticColsOf<M, std::void_t<decltype(M::StaticCols)>> = M::StaticCols;
+
+template<class V, class = void>
+constexpr size_t StaticLenOf = DynamicSize;
+
+template<class V>
+constexpr size_t StaticLenOf<V, std::void_t<decltype(V::StaticLen)>> = V::StaticLen;
+
+SP_CSI size_t merge_size(size_t a, size_t b) noexcept{ return a != DynamicSize ? a : b; }
+
+SP_CSI size_t mul_size(size_t a, size_t b) noexcept{
+	return a != DynamicSize && b != DynamicSize ? a*b : DynamicSize;
+}
+
+SP_CSI bool sizes_match(size_t a, size_t b) noexcept{
+	return a == DynamicSize || b == DynamicSize || a == b;
+}
+
+template<class A, class B>
+constexpr size_t MergedRows = merge_size(StaticRowsOf<A>, StaticRowsOf<B>);
+
+template<class A, class B>
+constexpr size_t MergedCols = merge_size(StaticColsOf<A>, StaticColsOf<B>);
+
+template<class A, class B>
+constexpr size_t MergedLen = merge_size(StaticLenOf<A>, StaticLenOf<B>);
+
+template<class A, class B>
+constexpr bool SameStaticDims =
+		sizes_match(StaticRowsOf<A>, StaticRowsOf<B>) && sizes_match(StaticColsOf<A>, StaticColsOf<B>);
+
+// destination and source of assignment have all dimensions known at compile time
+template<class D, class S>
+constexpr bool IsStaticAssign = !S::UsesBuffer &&
+		StaticRowsOf<D> != DynamicSize && StaticColsOf<D> != DynamicSize &&
+		StaticRowsOf<S> != DynamicSize && StaticColsOf<S> != DynamicSize;
+
+template<class D, class S>
+constexpr bool IsStaticVectorAssign = !S::UsesBuffer &&
+		StaticLenOf<D> != DynamicSize && StaticLenOf<S> != DynamicSize;
+
+// sum of products of pairs of elements, small sums of known length are unrolled
+template<size_t Len, class T, class F>
+SP_CI T static_dot(size_t len, F &&f) noexcept{
+	if constexpr (Len <= UnrollLen){
+		return [&]<size_t... I>(std::index_sequence<I...>){
+			return (T{} + ... + f(I));
+		}(std::make_index_sequence<Len>{});
+	} else{
+		T res{};
+		for (size_t i=0; i!=(Len != DynamicSize ? Len : len); ++i) res += f(i);
+		return res;
+	}
+}
+
+// visits every element of matrix with dimensions known at compile time, small ones are unrolled
+template<size_t R, size_t C, bool RowMaj, class F>
+SP_CI void static_traverse(F &&f) noexcept{
+	if constexpr (R*C <= UnrollLen){
+		[&]<size_t... I>(std::index_sequence<I...>){
+			if constexpr (RowMaj)
+				(f(I/C, I%C), ...);
+			else
+				(f(I%R, I/R), ...);
+		}(std::make_index_sequence<R*C>{});
+	} else if constexpr (RowMaj){
+		for (size_t i=0; i!=R; ++i)
+			for (size_t j=0; j!=C; ++j)
+				f(i, j);
+	} else{
+		for (size_t j=0; j!=C; ++j)
+			for (size_t i=0; i!=R; ++i)
+				f(i, j);
+	}
+}
+
+// visits every element of destination, when layouts of destination and source disagree square
+// tiles are walked, so neither of them is read with a full line stride
+template<class D, class S, class F>
+SP_SI void traverse(size_t height, size_t width, F &&f) noexcept{
+	if constexpr (MixedMajor<D, S>){
+		const size_t BlockLen = traverse_block_len<typename D::ValueType>();
+		if constexpr (D::RowMajor){
+			for (size_t ib=0; ib<height; ib+=BlockLen){
+				size_t ie = ib+BlockLen<height ? ib+BlockLen : height;
+				for (size_t jb=0; jb<width; jb+=BlockLen){
+					size_t je = jb+BlockLen<width ? jb+BlockLen : width;
+					for (size_t i=ib; i!=ie; ++i)
+						for (size_t j=jb; j!=je; ++j)
+							f(i, j);
+				}
+			}
+		} else{
+			for (size_t jb=0; jb<width; jb+=BlockLen){
+				size_t je = jb+BlockLen<width ? jb+BlockLen : width;
+				for (size_t ib=0; ib<height; ib+=BlockLen){
+					size_t ie = ib+BlockLen<height ? ib+BlockLen : height;
+					for (size_t j=jb; j!=je; ++j)
+						for (size_t i=ib; i!=ie; ++i)
+							f(i, j);
+				}
+			}
+		}
+	} else if constexpr (D::UndefMajor ? S::RowMajor : D::RowMajor){
+		for (size_t i=0; i!=height; ++i)
+			for (size_t j=0; j!=width; ++j)
+				f(i, j);
+	} else{
+		for (size_t j=0; j!=width; ++j)
+			for (size_t i=0; i!=height; ++i)
+				f(i, j);
+	}
+}
+
+} // END OF NAMESPACE PRIV //////////
 
 
 
 template<class Base>
 struct MatrixWrapper : Base{
 
+	// matrices of fixed size are assigned without any checks at runtime, also in constant
+	// expressions, other ones go through the functions below
 	template<SP_MATRIX_T(M)>
-	const MatrixWrapper &operator =(M &&rhs) noexcept{
-		resize(*this, rows(rhs), cols(rhs));
-		if constexpr (std::decay_t<M>::UndefMajor ? Base::RowMajor : std::decay_t<M>::RowMajor)
-			for (size_t i=0; i!=rows(*this); ++i)
-				for (size_t j=0; j!=cols(*this); ++j)
-					(*this)(i, j) = rhs(i, j);
+	constexpr const MatrixWrapper &operator =(M &&rhs) noexcept{
+		static_assert(priv__::SameStaticDims<Base, std::decay_t<M>>, "assigned matrix has different dimensions");
+		if constexpr (priv__::IsStaticAssign<Base, std::decay_t<M>>)
+			priv__::static_traverse<priv__::StaticRowsOf<Base>, priv__::StaticColsOf<Base>, Base::RowMajor>(
+				[&](size_t i, size_t j){ (*this)(i, j) = rhs(i, j); }
+			);
 		else
-			for (size_t i=0; i!=cols(*this); ++i)
-				for (size_t j=0; j!=rows(*this); ++j)
-					(*this)(j, i) = rhs(j, i);
-		if constexpr (std::decay_t<M>::UsesBuffer)
-			resize(MatrixTempStorage.data, MatrixTempStorage.stack_pos);
+			assign_dynamic(rhs);
 		return *this;
 	}
 
 	template<SP_MATRIX_T(M)>
-	const MatrixWrapper &operator +=(M &&rhs) noexcept{
-		for (size_t i=0; i!=rows(*this); ++i)
-			for (size_t j=0; j!=cols(*this); ++j)
-				(*this)(i, j) += rhs(i, j);
+	constexpr const MatrixWrapper &operator +=(M &&rhs) noexcept{
+		static_assert(priv__::SameStaticDims<Base, std::decay_t<M>>, "added matrix has different dimensions");
+		if constexpr (priv__::IsStaticAssign<Base, std::decay_t<M>>)
+			priv__::static_traverse<priv__::StaticRowsOf<Base>, priv__::StaticColsOf<Base>, Base::RowMajor>(
+				[&](size_t i, size_t j){ (*this)(i, j) += rhs(i, j); }
+			);
+		else
+			add_assign_dynamic(rhs);
 		return *this;
 	}
 
 	template<SP_MATRIX_T(M)>
-	const MatrixWrapper &operator -=(M &&rhs) noexcept{
-		for (size_t i=0; i!=rows(*this); ++i)
-			for (size_t j=0; j!=cols(*this); ++j)
-				(*this)(i, j) -= rhs(i, j);
+	constexpr const MatrixWrapper &operator -=(M &&rhs) noexcept{
+		static_assert(priv__::SameStaticDims<Base, std::decay_t<M>>, "subtracted matrix has different dimensions");
+		if constexpr (priv__::IsStaticAssign<Base, std::decay_t<M>>)
+			priv__::static_traverse<priv__::StaticRowsOf<Base>, priv__::StaticColsOf<Base>, Base::RowMajor>(
+				[&](size_t i, size_t j){ (*this)(i, j) -= rhs(i, j); }
+			);
+		else
+			sub_assign_dynamic(rhs);
 		return *this;
 	}
 
+	template<SP_MATRIX_T(M)>
+	void assign_dynamic(M &&rhs) noexcept{
+		SP_MATRIX_PROFILE_ASSIGN_BEGIN("= ", M, rows(rhs)*cols(rhs)*sizeof(typename Base::ValueType));
+		resize(*this, rows(rhs), cols(rhs));
+		priv__::traverse<Base, std::decay_t<M>>(
+			rows(*this), cols(*this), [&](size_t i, size_t j){ (*this)(i, j) = rhs(i, j); }
+		);
+		if constexpr (std::decay_t<M>::UsesBuffer)
+			resize(MatrixTempStorage.data, MatrixTempStorage.stack_pos);
+		SP_MATRIX_PROFILE_END();
+	}
+
+	template<SP_MATRIX_T(M)>
+	void add_assign_dynamic(M &&rhs) noexcept{
+		SP_MATRIX_PROFILE_ASSIGN_BEGIN("+= ", M, rows(rhs)*cols(rhs)*sizeof(typename Base::ValueType));
+		priv__::traverse<Base, std::decay_t<M>>(
+			rows(*this), cols(*this), [&](size_t i, size_t j){ (*this)(i, j) += rhs(i, j); }
+		);
+		SP_MATRIX_PROFILE_END();
+	}
+
+	template<SP_MATRIX_T(M)>
+	void sub_assign_dynamic(M &&rhs) noexcept{
+		SP_MATRIX_PROFILE_ASSIGN_BEGIN("-= ", M, rows(rhs)*cols(rhs)*sizeof(typename Base::ValueType));
+		priv__::traverse<Base, std::decay_t<M>>(
+			rows(*this), cols(*this), [&](size_t i, size_t j){ (*this)(i, j) -= rhs(i, j); }
+		);
+		SP_MATRIX_PROFILE_END();
+	}
+
 	template<SP_MATRIX_T(M)>
 	const MatrixWrapper &operator *=(M &&rhs) noexcept{
+		SP_MATRIX_PROFILE_ASSIGN_BEGIN("*= ", M, rows(rhs)*cols(rhs)*sizeof(typename Base::ValueType));
 		resize(*this, rows(*this), cols(rhs));
 
 		size_t oldSize = len(MatrixTempStorage.data);
@@ -75,6 +261,7 @@ struct MatrixWrapper : Base{
 		}
 			
 		resize(MatrixTempStorage.data, oldSize);
+		SP_MATRIX_PROFILE_END();
 		return *this;
 	}
 	
@@ -91,7 +278,10 @@ struct MatrixExprTranspose{
 	typedef typename Arg::ValueType ValueType;
 	constexpr static bool RowMajor = !Arg::RowMajor;
 	constexpr static bool UndefMajor = Arg::UndefMajor;
+	constexpr static bool MixedMajor = priv__::MixedMajor<Arg>;
 	constexpr static bool UsesBuffer = Arg::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::StaticColsOf<Arg>;
+	constexpr static size_t StaticCols = priv__::StaticRowsOf<Arg>;
 
 	SP_CI std::conditional_t<isLVal, ValueType &, ValueType> operator ()(
 		size_t r, size_t c
@@ -131,7 +321,10 @@ struct MatrixExprPermuteRows{
 	constexpr static bool IsExpr = Arg::IsExpr;
 	constexpr static bool RowMajor = Arg::RowMajor;
 	constexpr static bool UndefMajor = Arg::UndefMajor;
+	constexpr static bool MixedMajor = priv__::MixedMajor<Arg>;
 	constexpr static bool UsesBuffer = Arg::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::StaticRowsOf<Arg>;
+	constexpr static size_t StaticCols = priv__::StaticColsOf<Arg>;
 
 	SP_CI std::conditional_t<isLVal, ValueType &, ValueType> operator ()(
 		size_t r, size_t c
@@ -165,6 +358,39 @@ SP_SI size_t resize(MatrixExprPermuteRows<M, Cont, isLVal> &m, size_t r, size_t
 
 
 
+// rows permuted twice, the composed permutation is kept in the temporary storage
+template<class M>
+struct MatrixExprPermuteRowsComposed{
+	static constexpr StupidMatrixFlagType MatrixFlag{};
+	M arg;
+	size_t data_index;
+
+	typedef std::remove_reference_t<M> Arg;
+
+	typedef typename Arg::ValueType ValueType;
+	constexpr static bool RowMajor = Arg::RowMajor;
+	constexpr static bool UndefMajor = Arg::UndefMajor;
+	constexpr static bool MixedMajor = priv__::MixedMajor<Arg>;
+	constexpr static bool UsesBuffer = true;
+	constexpr static size_t StaticRows = priv__::StaticRowsOf<Arg>;
+	constexpr static size_t StaticCols = priv__::StaticColsOf<Arg>;
+
+	SP_CI ValueType operator ()(size_t r, size_t c) const noexcept{
+		return arg(((const uint32_t *)(beg(MatrixTempStorage.data) + data_index))[r], c);
+	}
+};
+
+template<class M>
+SP_CSI size_t rows(const MatrixExprPermuteRowsComposed<M> &m) noexcept{ return rows(m.arg); }
+
+template<class M>
+SP_CSI size_t cols(const MatrixExprPermuteRowsComposed<M> &m) noexcept{ return cols(m.arg); }
+
+template<class M>
+SP_CSI size_t len(const MatrixExprPermuteRowsComposed<M> &m) noexcept{ return len(m.arg); }
+
+
+
 template<class M, class Cont, bool isLVal>
 struct MatrixExprPermuteCols{
 	static constexpr StupidMatrixFlagType MatrixFlag{};
@@ -177,7 +403,10 @@ struct MatrixExprPermuteCols{
 	constexpr static bool IsExpr = Arg::IsExpr;
 	constexpr static bool RowMajor = Arg::RowMajor;
 	constexpr static bool UndefMajor = Arg::UndefMajor;
+	constexpr static bool MixedMajor = priv__::MixedMajor<Arg>;
 	constexpr static bool UsesBuffer = Arg::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::StaticRowsOf<Arg>;
+	constexpr static size_t StaticCols = priv__::StaticColsOf<Arg>;
 
 	SP_CI std::conditional_t<isLVal, ValueType &, ValueType> operator ()(
 		size_t r, size_t c
@@ -221,7 +450,10 @@ struct MatrixExprElStatUnaryOp{
 	typedef typename Arg::ValueType ValueType;
 	constexpr static bool RowMajor = Arg::RowMajor;
 	constexpr static bool UndefMajor = Arg::UndefMajor;
+	constexpr static bool MixedMajor = priv__::MixedMajor<Arg>;
 	constexpr static bool UsesBuffer = Arg::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::StaticRowsOf<Arg>;
+	constexpr static size_t StaticCols = priv__::StaticColsOf<Arg>;
 
 	template<class O = decltype(Operation)> SP_CI
 	std::enable_if_t<std::is_invocable_v<O, ValueType>, ValueType>
@@ -238,17 +470,17 @@ struct MatrixExprElStatUnaryOp{
 
 template<class M, auto Op>
 SP_CSI size_t rows(const MatrixExprElStatUnaryOp<M, Op> &m) noexcept{
-	return rows(m.arg.rows);
+	return rows(m.arg);
 }
 
 template<class M, auto Op>
 SP_CSI size_t cols(const MatrixExprElStatUnaryOp<M, Op> &m) noexcept{
-	return cols(m.arg.cols);
+	return cols(m.arg);
 }
 
 template<class M, auto Op>
 SP_CSI size_t len(const MatrixExprElStatUnaryOp<M, Op> &m) noexcept{
-	return len(m.arg.len);
+	return len(m.arg);
 }
 
 
@@ -264,7 +496,10 @@ struct MatrixExprElDynUnaryOp{
 	typedef typename Arg::ValueType ValueType;
 	constexpr static bool RowMajor = Arg::RowMajor;
 	constexpr static bool UndefMajor = Arg::UndefMajor;
+	constexpr static bool MixedMajor = priv__::MixedMajor<Arg>;
 	constexpr static bool UsesBuffer = Arg::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::StaticRowsOf<Arg>;
+	constexpr static size_t StaticCols = priv__::StaticColsOf<Arg>;
 
 	template<class O = Operation> SP_CI
 	std::enable_if_t<std::is_invocable_v<O, ValueType>, ValueType>
@@ -281,17 +516,17 @@ struct MatrixExprElDynUnaryOp{
 
 template<class M, class Operation>
 SP_CSI size_t rows(const MatrixExprElDynUnaryOp<M, Operation> &m) noexcept{
-	return rows(m.arg.rows);
+	return rows(m.arg);
 }
 
 template<class M, class Operation>
 SP_CSI size_t cols(const MatrixExprElDynUnaryOp<M, Operation> &m) noexcept{
-	return cols(m.arg.cols);
+	return cols(m.arg);
 }
 
 template<class M, class Operation>
 SP_CSI size_t len(const MatrixExprElDynUnaryOp<M, Operation> &m) noexcept{
-	return len(m.arg.len);
+	return len(m.arg);
 }
 
 
@@ -365,10 +600,13 @@ struct MatrixExprAdd{
 	typedef std::remove_reference_t<MR> Rhs;
 
 	typedef typename Lhs::ValueType ValueType;
-	constexpr static bool RowMajor = Lhs::RowMajor;
-	constexpr static bool UndefMajor =
-			Lhs::UndefMajor || Rhs::UndefMajor || Lhs::RowMajor==Rhs::RowMajor;
+	constexpr static bool RowMajor = Lhs::UndefMajor ? Rhs::RowMajor : Lhs::RowMajor;
+	constexpr static bool UndefMajor = Lhs::UndefMajor && Rhs::UndefMajor;
+	constexpr static bool MixedMajor = priv__::MixedMajor<Lhs, Rhs>;
 	constexpr static bool UsesBuffer = Lhs::UsesBuffer || Rhs::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::MergedRows<Lhs, Rhs>;
+	constexpr static size_t StaticCols = priv__::MergedCols<Lhs, Rhs>;
+	static_assert(priv__::SameStaticDims<Lhs, Rhs>, "matrices have different dimensions");
 
 	SP_CI ValueType operator ()(size_t r, size_t c) const noexcept{
 		return lhs(r, c) + rhs(r, c);
@@ -396,10 +634,13 @@ struct MatrixExprSubtract{
 	typedef std::remove_reference_t<MR> Rhs;
 
 	typedef typename Lhs::ValueType ValueType;
-	constexpr static bool RowMajor = Lhs::RowMajor;
-	constexpr static bool UndefMajor =
-			Lhs::UndefMajor || Rhs::UndefMajor || Lhs::RowMajor==Rhs::RowMajor;
+	constexpr static bool RowMajor = Lhs::UndefMajor ? Rhs::RowMajor : Lhs::RowMajor;
+	constexpr static bool UndefMajor = Lhs::UndefMajor && Rhs::UndefMajor;
+	constexpr static bool MixedMajor = priv__::MixedMajor<Lhs, Rhs>;
 	constexpr static bool UsesBuffer = Lhs::UsesBuffer || Rhs::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::MergedRows<Lhs, Rhs>;
+	constexpr static size_t StaticCols = priv__::MergedCols<Lhs, Rhs>;
+	static_assert(priv__::SameStaticDims<Lhs, Rhs>, "matrices have different dimensions");
 
 	SP_CI ValueType operator ()(size_t r, size_t c) const noexcept{
 		return lhs(r, c) - rhs(r, c);
@@ -427,10 +668,13 @@ struct MatrixExprElMul{
 	typedef std::remove_reference_t<MR> Rhs;
 
 	typedef typename Lhs::ValueType ValueType;
-	constexpr static bool RowMajor = Lhs::RowMajor;
-	constexpr static bool UndefMajor =
-			Lhs::UndefMajor || Rhs::UndefMajor || Lhs::RowMajor==Rhs::RowMajor;
+	constexpr static bool RowMajor = Lhs::UndefMajor ? Rhs::RowMajor : Lhs::RowMajor;
+	constexpr static bool UndefMajor = Lhs::UndefMajor && Rhs::UndefMajor;
+	constexpr static bool MixedMajor = priv__::MixedMajor<Lhs, Rhs>;
 	constexpr static bool UsesBuffer = Lhs::UsesBuffer || Rhs::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::MergedRows<Lhs, Rhs>;
+	constexpr static size_t StaticCols = priv__::MergedCols<Lhs, Rhs>;
+	static_assert(priv__::SameStaticDims<Lhs, Rhs>, "matrices have different dimensions");
 
 	SP_CI ValueType operator ()(size_t r, size_t c) const noexcept{
 		return lhs(r, c) * rhs(r, c);
@@ -459,10 +703,13 @@ struct MatrixExprElDiv{
 	typedef std::remove_reference_t<MR> Rhs;
 
 	typedef typename Lhs::ValueType ValueType;
-	constexpr static bool RowMajor = Lhs::RowMajor;
-	constexpr static bool UndefMajor =
-			Lhs::UndefMajor || Rhs::UndefMajor || Lhs::RowMajor==Rhs::RowMajor;
+	constexpr static bool RowMajor = Lhs::UndefMajor ? Rhs::RowMajor : Lhs::RowMajor;
+	constexpr static bool UndefMajor = Lhs::UndefMajor && Rhs::UndefMajor;
+	constexpr static bool MixedMajor = priv__::MixedMajor<Lhs, Rhs>;
 	constexpr static bool UsesBuffer = Lhs::UsesBuffer || Rhs::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::MergedRows<Lhs, Rhs>;
+	constexpr static size_t StaticCols = priv__::MergedCols<Lhs, Rhs>;
+	static_assert(priv__::SameStaticDims<Lhs, Rhs>, "matrices have different dimensions");
 
 	SP_CI ValueType operator ()(size_t r, size_t c) const noexcept{
 		return lhs(r, c) / rhs(r, c);
@@ -490,10 +737,13 @@ struct MatrixExprElStatOp{
 	typedef std::remove_reference_t<MR> Rhs;
 
 	typedef typename Lhs::ValueType ValueType;
-	constexpr static bool RowMajor = Lhs::RowMajor;
-	constexpr static bool UndefMajor =
-			Lhs::UndefMajor || Rhs::UndefMajor || Lhs::RowMajor==Rhs::RowMajor;
+	constexpr static bool RowMajor = Lhs::UndefMajor ? Rhs::RowMajor : Lhs::RowMajor;
+	constexpr static bool UndefMajor = Lhs::UndefMajor && Rhs::UndefMajor;
+	constexpr static bool MixedMajor = priv__::MixedMajor<Lhs, Rhs>;
 	constexpr static bool UsesBuffer = Lhs::UsesBuffer || Rhs::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::MergedRows<Lhs, Rhs>;
+	constexpr static size_t StaticCols = priv__::MergedCols<Lhs, Rhs>;
+	static_assert(priv__::SameStaticDims<Lhs, Rhs>, "matrices have different dimensions");
 
 	template<class O = decltype(Operation)> SP_CI
 	std::enable_if_t<std::is_invocable_v<O, ValueType>, ValueType>
@@ -530,10 +780,13 @@ struct MatrixExprElDynOp{
 	typedef std::remove_reference_t<MR> Rhs;
 
 	typedef typename Lhs::ValueType ValueType;
-	constexpr static bool RowMajor = Lhs::RowMajor;
-	constexpr static bool UndefMajor =
-			Lhs::UndefMajor || Rhs::UndefMajor || Lhs::RowMajor==Rhs::RowMajor;
+	constexpr static bool RowMajor = Lhs::UndefMajor ? Rhs::RowMajor : Lhs::RowMajor;
+	constexpr static bool UndefMajor = Lhs::UndefMajor && Rhs::UndefMajor;
+	constexpr static bool MixedMajor = priv__::MixedMajor<Lhs, Rhs>;
 	constexpr static bool UsesBuffer = Lhs::UsesBuffer || Rhs::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::MergedRows<Lhs, Rhs>;
+	constexpr static size_t StaticCols = priv__::MergedCols<Lhs, Rhs>;
+	static_assert(priv__::SameStaticDims<Lhs, Rhs>, "matrices have different dimensions");
 
 	
 	template<class O = Operation> SP_CI
@@ -573,12 +826,18 @@ struct MatrixExprMultiply{
 	constexpr static bool RowMajor = false;
 	constexpr static bool UndefMajor = true;
 	constexpr static bool UsesBuffer = Lhs::UsesBuffer || Rhs::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::StaticRowsOf<Lhs>;
+	constexpr static size_t StaticCols = priv__::StaticColsOf<Rhs>;
+	constexpr static size_t StaticInner = priv__::merge_size(priv__::StaticColsOf<Lhs>, priv__::StaticRowsOf<Rhs>);
+	static_assert(
+		priv__::sizes_match(priv__::StaticColsOf<Lhs>, priv__::StaticRowsOf<Rhs>),
+		"multiplied matrices have wrong dimensions"
+	);
 
 	SP_CI ValueType operator ()(size_t r, size_t c) const noexcept{
-		ValueType res = (ValueType)0;
-		for (size_t i=0; i!=cols(lhs); ++i)
-			res += lhs(r, i) * rhs(i, c);
-		return res;
+		return priv__::static_dot<StaticInner, ValueType>(
+			cols(lhs), [&](size_t i){ return lhs(r, i) * rhs(i, c); }
+		);
 	}
 };
 
@@ -595,18 +854,56 @@ SP_CSI size_t len(const MatrixExprMultiply<ML, MR> &m) noexcept{
 
 
 
+// kronecker product, elements are computed when they are read, so the product is never stored,
+// its product with a vector doesn't read the elements at all
+template<class ML, class MR>
+struct MatrixExprKron{
+	static constexpr StupidMatrixFlagType MatrixFlag{};
+	ML lhs;
+	MR rhs;
+
+	typedef std::remove_reference_t<ML> Lhs;
+	typedef std::remove_reference_t<MR> Rhs;
+
+	typedef typename Lhs::ValueType ValueType;
+	constexpr static bool RowMajor = false;
+	constexpr static bool UndefMajor = true;
+	constexpr static bool UsesBuffer = Lhs::UsesBuffer || Rhs::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::mul_size(priv__::StaticRowsOf<Lhs>, priv__::StaticRowsOf<Rhs>);
+	constexpr static size_t StaticCols = priv__::mul_size(priv__::StaticColsOf<Lhs>, priv__::StaticColsOf<Rhs>);
+
+	SP_CI ValueType operator ()(size_t r, size_t c) const noexcept{
+		size_t p = rows(rhs), q = cols(rhs);
+		return lhs(r/p, c/q) * rhs(r%p, c%q);
+	}
+};
+
+template<class ML, class MR>
+SP_CSI size_t rows(const MatrixExprKron<ML, MR> &m) noexcept{ return rows(m.lhs) * rows(m.rhs); }
+
+template<class ML, class MR>
+SP_CSI size_t cols(const MatrixExprKron<ML, MR> &m) noexcept{ return cols(m.lhs) * cols(m.rhs); }
+
+template<class ML, class MR>
+SP_CSI size_t len(const MatrixExprKron<ML, MR> &m) noexcept{ return len(m.lhs) * len(m.rhs); }
+
+
+
 template<class M>
 struct MatrixExprScalarMultiply{
 	static constexpr StupidMatrixFlagType MatrixFlag{};
 	typedef std::remove_reference_t<M> Arg;
-	typedef typename M::ValueType ValueType;
+	typedef typename Arg::ValueType ValueType;
 
 	M lhs;
-	typename M::ValueType rhs;
+	ValueType rhs;
 
 	constexpr static bool RowMajor = Arg::RowMajor;
 	constexpr static bool UndefMajor = Arg::UndefMajor;
+	constexpr static bool MixedMajor = priv__::MixedMajor<Arg>;
 	constexpr static bool UsesBuffer = Arg::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::StaticRowsOf<Arg>;
+	constexpr static size_t StaticCols = priv__::StaticColsOf<Arg>;
 
 	SP_CI ValueType operator ()(size_t r, size_t c) const noexcept{
 		return lhs(r, c) * rhs;
@@ -729,21 +1026,50 @@ SP_CSI size_t len(const MatrixExprUniformValue<T> &m) noexcept{ return m.rows *
 
 
 template<SP_MATRIX_T(M)>
-auto tr(M &&arg) noexcept{
+constexpr auto tr(M &&arg) noexcept{
 	return MatrixExprTranspose<CRemRRef<M>, false>{arg};
 }
 template<SP_MATRIX_T(M)>
-auto l_tr(M &&arg) noexcept{
+constexpr auto l_tr(M &&arg) noexcept{
 	return MatrixWrapper<MatrixExprTranspose<RemRRef<M>, true>>{{arg}};
 }
 
 
+namespace priv__{
+
+template<class M>
+constexpr bool IsRowsPermutation = false;
+
+template<class M, class Cont>
+constexpr bool IsRowsPermutation<MatrixExprPermuteRows<M, Cont, false>> = true;
+
+template<class M>
+constexpr bool IsRowsPermutation<MatrixExprPermuteRowsComposed<M>> = true;
+
+} // END OF NAMESPACE PRIV //////////
+
 template<SP_MATRIX_T(M), class Cont>
 auto perm_rows(M &&arg, const Cont &permuts) noexcept{
 	SP_MATRIX_ERROR(rows(arg) != len(permuts),
 		"permutation array must have the same length as number of permuted matrix's rows"
 	);
-	return MatrixExprPermuteRows<CRemRRef<M>, Cont, false>{arg, &permuts};
+	if constexpr (priv__::IsRowsPermutation<std::decay_t<M>>){
+		// perm_rows(perm_rows(A, p), q) reads A(p[q[r]], c), so p and q get composed once
+		size_t length = len(permuts);
+		size_t index = len(MatrixTempStorage.data);
+		expand_back(MatrixTempStorage.data, (length * sizeof(uint32_t) + 7) / 8);
+		uint32_t *composed = (uint32_t *)(beg(MatrixTempStorage.data) + index);
+		if constexpr (std::is_same_v<std::decay_t<M>, MatrixExprPermuteRowsComposed<decltype(arg.arg)>>){
+			const uint32_t *inner = (const uint32_t *)(beg(MatrixTempStorage.data) + arg.data_index);
+			for (size_t i=0; i!=length; ++i) composed[i] = inner[(size_t)permuts[i]];
+		} else{
+			for (size_t i=0; i!=length; ++i)
+				composed[i] = (uint32_t)(*arg.permuts)[(size_t)permuts[i]];
+		}
+		return MatrixExprPermuteRowsComposed<decltype(arg.arg)>{arg.arg, index};
+	} else{
+		return MatrixExprPermuteRows<CRemRRef<M>, Cont, false>{arg, &permuts};
+	}
 }
 template<SP_MATRIX_T(M), class Cont>
 auto l_perm_rows(M &&arg, const Cont &permuts) noexcept{
@@ -774,19 +1100,19 @@ auto cp(const M &arg) noexcept{
 }
 
 template<auto operation, SP_MATRIX_T(M)>
-auto apply(M &&arg) noexcept{
+constexpr auto apply(M &&arg) noexcept{
 	return MatrixExprElStatUnaryOp<CRemRRef<M>, operation>{arg};
 }
 
 template<SP_MATRIX_T(M), class Operation>
-auto apply(M &&arg, Operation &&operation) noexcept{
+constexpr auto apply(M &&arg, Operation &&operation) noexcept{
 	return MatrixExprElDynUnaryOp<
 		CRemRRef<M>, decltype((Operation &&)operation)
 	>{arg, (Operation &&)operation};
 }
 
 template<SP_MATRIX_T(ML), SP_MATRIX_T(MR)>
-auto elwise_mul(ML &&lhs, MR &&rhs) noexcept{
+constexpr auto elwise_mul(ML &&lhs, MR &&rhs) noexcept{
 	SP_MATRIX_ERROR(rows(lhs)!=rows(rhs) || cols(lhs)!=cols(rhs),
 		"element wise multiplied matrices cannot have different dimensions"
 	);
@@ -794,7 +1120,7 @@ auto elwise_mul(ML &&lhs, MR &&rhs) noexcept{
 }
 
 template<SP_MATRIX_T(ML), SP_MATRIX_T(MR)>
-auto elwise_div(ML &&lhs, MR &&rhs) noexcept{
+constexpr auto elwise_div(ML &&lhs, MR &&rhs) noexcept{
 	SP_MATRIX_ERROR(rows(lhs)!=rows(rhs) || cols(lhs)!=cols(rhs),
 		"element wise divided matrices cannot have different dimensions"
 	);
@@ -802,7 +1128,7 @@ auto elwise_div(ML &&lhs, MR &&rhs) noexcept{
 }
 
 template<SP_MATRIX_T(ML), SP_MATRIX_T(MR), class Operation>
-auto apply(ML &&lhs, MR &&rhs, Operation &&operation) noexcept{
+constexpr auto apply(ML &&lhs, MR &&rhs, Operation &&operation) noexcept{
 	SP_MATRIX_ERROR(rows(lhs)!=rows(rhs) || cols(lhs)!=cols(rhs),
 		"element wise operated matrices cannot have different dimensions"
 	);
@@ -813,17 +1139,41 @@ auto apply(ML &&lhs, MR &&rhs, Operation &&operation) noexcept{
 }
 
 template<auto operation, SP_MATRIX_T(ML), SP_MATRIX_T(MR)>
-auto apply(ML &&lhs, MR &&rhs) noexcept{
+constexpr auto apply(ML &&lhs, MR &&rhs) noexcept{
 	SP_MATRIX_ERROR(rows(lhs)!=rows(rhs) || cols(lhs)!=cols(rhs),
 		"element wise operated matrices cannot have different dimensions"
 	);
 	return MatrixExprElStatOp<CRemRRef<ML>, CRemRRef<MR>, operation>{lhs, rhs};
 }
 
+template<SP_MATRIX_T(ML), SP_MATRIX_T(MR)>
+constexpr auto kron(ML &&lhs, MR &&rhs) noexcept{
+	return MatrixExprKron<CRemRRef<ML>, CRemRRef<MR>>{lhs, rhs};
+}
+
+
 
 
 
 
+namespace priv__{
+
+// uniform random values indexed by position, so they don't depend on evaluation order
+template<class T>
+struct UniformRandom{
+	Philox32 rng;
+	T offset;
+	T scale;
+
+	SP_CI T operator ()(size_t r, size_t c) const noexcept{
+		return offset + scale*unit_real<T>(rng((uint32_t)r, (uint32_t)c));
+	}
+	SP_CI T operator ()(size_t i) const noexcept{
+		return offset + scale*unit_real<T>(rng((uint64_t)i));
+	}
+};
+
+} // END OF NAMESPACE PRIV //////////
 
 template<auto Operation>
 auto generate(uint32_t rows, uint32_t cols) noexcept{
@@ -844,9 +1194,16 @@ auto uniform(uint32_t rows, uint32_t cols, T value) noexcept{
 	return MatrixExprUniformValue<T>{rows, cols, value};
 }
 
+template<class T>
+auto random_uniform(uint32_t rows, uint32_t cols, uint32_t seed, T min, T max) noexcept{
+	return MatrixExprDynGenerator<priv__::UniformRandom<T>>{
+		rows, cols, priv__::UniformRandom<T>{Philox32{seed}, min, max - min}
+	};
+}
+
 
 template<SP_MATRIX_T(ML), SP_MATRIX_T(MR)>
-auto operator +(ML &&lhs, MR &&rhs) noexcept{
+constexpr auto operator +(ML &&lhs, MR &&rhs) noexcept{
 	SP_MATRIX_ERROR(
 		rows(lhs)!=rows(rhs) || cols(lhs)!=cols(rhs),
 		"added matrices cannot have different dimensions"
@@ -855,7 +1212,7 @@ auto operator +(ML &&lhs, MR &&rhs) noexcept{
 }
 
 template<SP_MATRIX_T(ML), SP_MATRIX_T(MR)>
-auto operator -(ML &&lhs, MR &&rhs) noexcept{
+constexpr auto operator -(ML &&lhs, MR &&rhs) noexcept{
 	SP_MATRIX_ERROR(
 		rows(lhs)!=rows(rhs) || cols(lhs)!=cols(rhs),
 		"subtracted matrices cannot have different dimensions"
@@ -864,7 +1221,7 @@ auto operator -(ML &&lhs, MR &&rhs) noexcept{
 }
 
 template<SP_MATRIX_T(ML), SP_MATRIX_T(MR)>
-auto operator *(ML &&lhs, MR &&rhs) noexcept{
+constexpr auto operator *(ML &&lhs, MR &&rhs) noexcept{
 	SP_MATRIX_ERROR(cols(lhs) != rows(rhs), "multiplied matrices have wrong dimensionss");
 	return MatrixExprMultiply<CRemRRef<ML>, CRemRRef<MR>>{lhs, rhs};
 }
@@ -872,16 +1229,16 @@ auto operator *(ML &&lhs, MR &&rhs) noexcept{
 
 
 template<SP_MATRIX_T(M)>
-auto operator *(M &&lhs, const typename std::decay_t<M>::ValueType &rhs) noexcept{
+constexpr auto operator *(M &&lhs, const typename std::decay_t<M>::ValueType &rhs) noexcept{
 	return MatrixExprScalarMultiply<CRemRRef<M>>{lhs, rhs};
 }
 template<SP_MATRIX_T(M)>
-auto operator *(const typename std::decay_t<M>::ValueType &lhs, M &&rhs) noexcept{
+constexpr auto operator *(const typename std::decay_t<M>::ValueType &lhs, M &&rhs) noexcept{
 	return MatrixExprScalarMultiply<CRemRRef<M>>{rhs, lhs};
 }
 
 template<SP_MATRIX_T(M)>
-auto operator /(M &&lhs, const typename std::decay_t<M>::ValueType &rhs) noexcept{
+constexpr auto operator /(M &&lhs, const typename std::decay_t<M>::ValueType &rhs) noexcept{
 	return MatrixExprScalarMultiply<CRemRRef<M>>{lhs, (typename std::decay_t<M>::ValueType)1 / rhs};
 }
 
@@ -898,26 +1255,76 @@ template<class Base>
 struct VectorWrapper : Base{
 
 	template<SP_VECTOR_T(V)>
-	const VectorWrapper &operator =(V &&rhs) noexcept{
+	constexpr const VectorWrapper &operator =(V &&rhs) noexcept{
+		static_assert(
+			priv__::sizes_match(priv__::StaticLenOf<Base>, priv__::StaticLenOf<std::decay_t<V>>),
+			"assigned vector has different length"
+		);
+		if constexpr (priv__::IsStaticVectorAssign<Base, std::decay_t<V>>)
+			priv__::static_traverse<priv__::StaticLenOf<Base>, 1, false>(
+				[&](size_t i, size_t){ (*this)[i] = rhs[i]; }
+			);
+		else
+			assign_dynamic(rhs);
+		return *this;
+	}
+
+	template<SP_VECTOR_T(V)>
+	constexpr const VectorWrapper &operator +=(V &&rhs) noexcept{
+		static_assert(
+			priv__::sizes_match(priv__::StaticLenOf<Base>, priv__::StaticLenOf<std::decay_t<V>>),
+			"added vector has different length"
+		);
+		if constexpr (priv__::IsStaticVectorAssign<Base, std::decay_t<V>>)
+			priv__::static_traverse<priv__::StaticLenOf<Base>, 1, false>(
+				[&](size_t i, size_t){ (*this)[i] += rhs[i]; }
+			);
+		else
+			add_assign_dynamic(rhs);
+		return *this;
+	}
+
+	template<SP_VECTOR_T(V)>
+	constexpr const VectorWrapper &operator -=(V &&rhs) noexcept{
+		static_assert(
+			priv__::sizes_match(priv__::StaticLenOf<Base>, priv__::StaticLenOf<std::decay_t<V>>),
+			"subtracted vector has different length"
+		);
+		if constexpr (priv__::IsStaticVectorAssign<Base, std::decay_t<V>>)
+			priv__::static_traverse<priv__::StaticLenOf<Base>, 1, false>(
+				[&](size_t i, size_t){ (*this)[i] -= rhs[i]; }
+			);
+		else
+			sub_assign_dynamic(rhs);
+		return *this;
+	}
+
+	template<SP_VECTOR_T(V)>
+	void assign_dynamic(V &&rhs) noexcept{
+		SP_MATRIX_PROFILE_ASSIGN_BEGIN("= ", V, len(rhs)*sizeof(typename Base::ValueType));
 		resize(*this, len(rhs));
 		for (size_t i=0; i!=len(*this); ++i)
 			(*this)[i] = rhs[i];
-		return *this;
+		if constexpr (std::decay_t<V>::UsesBuffer)
+			resize(MatrixTempStorage.data, MatrixTempStorage.stack_pos);
+		SP_MATRIX_PROFILE_END();
 	}
 
 	template<SP_VECTOR_T(V)>
-	const VectorWrapper &operator +=(V &&rhs) noexcept{
+	void add_assign_dynamic(V &&rhs) noexcept{
+		SP_MATRIX_PROFILE_ASSIGN_BEGIN("+= ", V, len(rhs)*sizeof(typename Base::ValueType));
 		for (size_t i=0; i!=len(*this); ++i)
 			(*this)[i] += rhs[i];
-		return *this;
+		SP_MATRIX_PROFILE_END();
 	}
+
 	template<SP_VECTOR_T(V)>
-	const VectorWrapper &operator -=(V &&rhs) noexcept{
+	void sub_assign_dynamic(V &&rhs) noexcept{
+		SP_MATRIX_PROFILE_ASSIGN_BEGIN("-= ", V, len(rhs)*sizeof(typename Base::ValueType));
 		for (size_t i=0; i!=len(*this); ++i)
 			(*this)[i] -= rhs[i];
-		return *this;
+		SP_MATRIX_PROFILE_END();
 	}
-	
 };
 
 
@@ -932,6 +1339,7 @@ struct VectorExprPermute{
 	typedef typename Arg::ValueType ValueType;
 	constexpr static bool IsExpr = Arg::IsExpr;
 	constexpr static bool UsesBuffer = Arg::UsesBuffer;
+	constexpr static size_t StaticLen = priv__::StaticLenOf<Arg>;
 
 	constexpr std::conditional_t<LV, ValueType &, ValueType>
 		operator [](size_t i) noexcept{ return arg[(*permuts)[i]]; }
@@ -966,6 +1374,7 @@ struct VectorExprElStatUnaryOp{
 
 	typedef typename Arg::ValueType ValueType;
 	constexpr static bool UsesBuffer = Arg::UsesBuffer;
+	constexpr static size_t StaticLen = priv__::StaticLenOf<Arg>;
 
 
 	constexpr ValueType operator [](size_t i) const noexcept{
@@ -990,6 +1399,7 @@ struct VectorExprElDynUnaryOp{
 
 	typedef typename Arg::ValueType ValueType;
 	constexpr static bool UsesBuffer = Arg::UsesBuffer;
+	constexpr static size_t StaticLen = priv__::StaticLenOf<Arg>;
 
 	constexpr ValueType operator [](size_t i) const noexcept{
 		return operation(arg[i]);
@@ -1043,6 +1453,8 @@ struct VectorExprAdd{
 
 	typedef typename Lhs::ValueType ValueType;
 	constexpr static bool UsesBuffer = Lhs::UsesBuffer || Rhs::UsesBuffer;
+	constexpr static size_t StaticLen = priv__::MergedLen<Lhs, Rhs>;
+	static_assert(priv__::sizes_match(priv__::StaticLenOf<Lhs>, priv__::StaticLenOf<Rhs>), "vectors have different lengths");
 
 	constexpr ValueType operator [](size_t i) const noexcept{
 		return lhs[i] + rhs[i];
@@ -1067,6 +1479,8 @@ struct VectorExprSubtract{
 
 	typedef typename Lhs::ValueType ValueType;
 	constexpr static bool UsesBuffer = Lhs::UsesBuffer || Rhs::UsesBuffer;
+	constexpr static size_t StaticLen = priv__::MergedLen<Lhs, Rhs>;
+	static_assert(priv__::sizes_match(priv__::StaticLenOf<Lhs>, priv__::StaticLenOf<Rhs>), "vectors have different lengths");
 
 	constexpr size_t len() const noexcept{ return len(lhs); }
 	constexpr size_t capacity() const noexcept{ return 0; }
@@ -1094,6 +1508,8 @@ struct VectorExprElMul{
 
 	typedef typename Lhs::ValueType ValueType;
 	constexpr static bool UsesBuffer = Lhs::UsesBuffer || Rhs::UsesBuffer;
+	constexpr static size_t StaticLen = priv__::MergedLen<Lhs, Rhs>;
+	static_assert(priv__::sizes_match(priv__::StaticLenOf<Lhs>, priv__::StaticLenOf<Rhs>), "vectors have different lengths");
 
 	constexpr ValueType operator [](size_t i) const noexcept{
 		return lhs[i] * rhs[i];
@@ -1118,6 +1534,8 @@ struct VectorExprElDiv{
 
 	typedef typename Lhs::ValueType ValueType;
 	constexpr static bool UsesBuffer = Lhs::UsesBuffer || Rhs::UsesBuffer;
+	constexpr static size_t StaticLen = priv__::MergedLen<Lhs, Rhs>;
+	static_assert(priv__::sizes_match(priv__::StaticLenOf<Lhs>, priv__::StaticLenOf<Rhs>), "vectors have different lengths");
 
 	constexpr ValueType operator [](size_t i) const noexcept{
 		return lhs[i] / rhs[i];
@@ -1142,6 +1560,8 @@ struct VectorExprElStatOp{
 
 	typedef typename Lhs::ValueType ValueType;
 	constexpr static bool UsesBuffer = Lhs::UsesBuffer || Rhs::UsesBuffer;
+	constexpr static size_t StaticLen = priv__::MergedLen<Lhs, Rhs>;
+	static_assert(priv__::sizes_match(priv__::StaticLenOf<Lhs>, priv__::StaticLenOf<Rhs>), "vectors have different lengths");
 
 	constexpr ValueType operator [](size_t i) const noexcept{
 		return Operation(lhs[i], rhs[i]);
@@ -1168,6 +1588,8 @@ struct VectorExprElDynOp{
 
 	typedef typename Lhs::ValueType ValueType;
 	constexpr static bool UsesBuffer = Lhs::UsesBuffer || Rhs::UsesBuffer;
+	constexpr static size_t StaticLen = priv__::MergedLen<Lhs, Rhs>;
+	static_assert(priv__::sizes_match(priv__::StaticLenOf<Lhs>, priv__::StaticLenOf<Rhs>), "vectors have different lengths");
 
 	constexpr ValueType operator [](size_t i) const noexcept{
 		return operation(lhs[i], rhs[i]);
@@ -1191,8 +1613,9 @@ struct VectorExprScalarMultiply{
 	ValueType rhs;
 
 	constexpr static bool UsesBuffer = Arg::UsesBuffer;
+	constexpr static size_t StaticLen = priv__::StaticLenOf<Arg>;
 
-	constexpr ValueType operator [](size_t i) noexcept{
+	constexpr ValueType operator [](size_t i) const noexcept{
 		return lhs[i] * rhs;
 	}
 };
@@ -1310,12 +1733,12 @@ auto cp(V &&arg) noexcept{
 }
 
 template<auto operation, SP_VECTOR_T(V)>
-auto apply(V &&arg) noexcept{
+constexpr auto apply(V &&arg) noexcept{
 	return VectorExprElStatUnaryOp<CRemRRef<V>, operation>{arg};
 }
 
 template<SP_VECTOR_T(V), class Operation>
-auto apply(V &&arg, Operation &&operation) noexcept{
+constexpr auto apply(V &&arg, Operation &&operation) noexcept{
 	return VectorExprElDynUnaryOp<CRemRRef<V>,
 			decltype((Operation &&)operation)>{
 				arg, (Operation &&)operation
@@ -1323,7 +1746,7 @@ auto apply(V &&arg, Operation &&operation) noexcept{
 }
 
 template<SP_VECTOR_T(VL), SP_VECTOR_T(VR)>
-auto elwise_mul(VL &&lhs, VR &&rhs) noexcept{
+constexpr auto elwise_mul(VL &&lhs, VR &&rhs) noexcept{
 	SP_MATRIX_ERROR(len(lhs) != len(rhs),
 		"element wise multiplied vectors cannot have different dimensions"
 	);
@@ -1331,7 +1754,7 @@ auto elwise_mul(VL &&lhs, VR &&rhs) noexcept{
 }
 
 template<SP_VECTOR_T(VL), SP_VECTOR_T(VR)>
-auto elwise_div(VL &&lhs, VR &&rhs) noexcept{
+constexpr auto elwise_div(VL &&lhs, VR &&rhs) noexcept{
 	SP_MATRIX_ERROR(rows(lhs)!=rows(rhs) || cols(lhs)!=cols(rhs),
 		"element wise divided vectors cannot have different dimensions"
 	);
@@ -1339,7 +1762,7 @@ auto elwise_div(VL &&lhs, VR &&rhs) noexcept{
 }
 
 template<SP_VECTOR_T(VL), SP_VECTOR_T(VR), class Operation>
-auto apply(VL &&lhs, VR &&rhs, Operation &&operation) noexcept{
+constexpr auto apply(VL &&lhs, VR &&rhs, Operation &&operation) noexcept{
 	SP_MATRIX_ERROR(len(lhs)!=len(rhs),
 		"element wise operated vectors cannot have different dimensions"
 	);
@@ -1351,7 +1774,7 @@ auto apply(VL &&lhs, VR &&rhs, Operation &&operation) noexcept{
 
 
 template<auto operation, SP_VECTOR_T(VL), SP_VECTOR_T(VR)>
-auto apply(VL &&lhs, VR &&rhs) noexcept{
+constexpr auto apply(VL &&lhs, VR &&rhs) noexcept{
 	SP_MATRIX_ERROR(len(lhs)!=len(rhs),
 		"element wise operated vectors cannot have different dimensions"
 	);
@@ -1379,6 +1802,12 @@ template<class T>
 auto uniform(uint32_t size, T value) noexcept{
 	return VectorExprUniformValue<T>{value, size};
 }
+template<class T>
+auto random_uniform(uint32_t size, uint32_t seed, T min, T max) noexcept{
+	return VectorExprDynGenerator<priv__::UniformRandom<T>>{
+		priv__::UniformRandom<T>{Philox32{seed}, min, max - min}, size
+	};
+}
 
 
 
@@ -1387,25 +1816,25 @@ auto uniform(uint32_t size, T value) noexcept{
 
 
 template<SP_VECTOR_T(VL), SP_VECTOR_T(VR)>
-auto operator +(VL &&lhs, VR &&rhs) noexcept{
+constexpr auto operator +(VL &&lhs, VR &&rhs) noexcept{
 	SP_MATRIX_ERROR(len(lhs)!=len(rhs), "added vectors cannot have different dimensions");
 	return VectorExprAdd<CRemRRef<VL>, CRemRRef<VR>>{lhs, rhs};
 }
 
 template<SP_VECTOR_T(VL), SP_VECTOR_T(VR)>
-auto operator -(VL &&lhs, VR &&rhs) noexcept{
+constexpr auto operator -(VL &&lhs, VR &&rhs) noexcept{
 	SP_MATRIX_ERROR(len(lhs)!=len(rhs), "subtracted vectors cannot have different dimensions");
 	return VectorExprSubtract<CRemRRef<VL>, CRemRRef<VR>>{lhs, rhs};
 }
 
 
 template<SP_VECTOR_T(V)>
-auto operator *(V &&lhs, const typename std::decay_t<V>::ValueType &rhs) noexcept{
+constexpr auto operator *(V &&lhs, const typename std::decay_t<V>::ValueType &rhs) noexcept{
 	return VectorExprScalarMultiply<CRemRRef<V>>{lhs, rhs};
 }
 
 template<SP_VECTOR_T(V)>
-auto operator /(V &&lhs, const typename std::decay_t<V>::ValueType &rhs) noexcept{
+constexpr auto operator /(V &&lhs, const typename std::decay_t<V>::ValueType &rhs) noexcept{
 	return VectorExprScalarMultiply<CRemRRef<V>>{lhs, (typename std::decay_t<V>::ValueType)1 / rhs};
 }
 
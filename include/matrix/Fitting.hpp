@@ -0,0 +1,151 @@
+#pragma once
+
+#include "Expr.hpp"
+#include "SPL/Polynomial.hpp"
+#include <math.h>
+#include <limits>
+
+namespace sp{
+
+// VANDERMONDE SYSTEMS
+// Square systems with vandermonde matrix are solved by bjorck-pereyra algorithm in O(n^2)
+// operations and without any workspace, the primal system gives coefficients of interpolating
+// polynomial and the dual one (transposed matrix) gives weights of interpolatory rules.
+//
+// POLYNOMIAL FITTING
+// The least squares fit streams the points through givens rotations into small triangle of
+// size (degree+1) x (degree+2), so the n x (degree+1) vandermonde matrix is never formed. The
+// abscissas are mapped to [-1, 1] before fitting and the polynomial is shifted back afterwards.
+
+
+
+// solves sum(dest[j] * x[i]^j) = y[i], so dest are coefficients of polynomial interpolating
+// the points, abscissas must be distinct
+template<SP_VECTOR_T(V1), SP_VECTOR_T(V2), SP_VECTOR_T(V3)>
+void vandermonde_solve(V1 &&dest, V2 &&x, V3 &&y) noexcept{
+	SP_MATRIX_ERROR(len(x) != len(y), "vandermonde system must have as many values as abscissas");
+	typedef typename std::decay_t<V1>::ValueType T;
+	size_t n = len(x);
+	resize(dest, n);
+	for (size_t i=0; i!=n; ++i) dest[i] = (T)y[i];
+	if (n < 2) return;
+
+	// newton divided differences
+	for (size_t k=0; k!=n-1; ++k)
+		for (size_t i=n-1; i!=k; --i)
+			dest[i] = (dest[i] - dest[i-1]) / ((T)x[i] - (T)x[i-k-1]);
+	// newton form to monomial form
+	for (size_t k=n-2; k!=(size_t)-1; --k){
+		T xk = (T)x[k];
+		for (size_t i=k; i!=n-1; ++i)
+			dest[i] -= xk * dest[i+1];
+	}
+}
+
+// solves sum(dest[j] * x[j]^i) = b[i], the transposed vandermonde system, abscissas must be
+// distinct
+template<SP_VECTOR_T(V1), SP_VECTOR_T(V2), SP_VECTOR_T(V3)>
+void vandermonde_tr_solve(V1 &&dest, V2 &&x, V3 &&b) noexcept{
+	SP_MATRIX_ERROR(len(x) != len(b), "vandermonde system must have as many values as abscissas");
+	typedef typename std::decay_t<V1>::ValueType T;
+	size_t n = len(x);
+	resize(dest, n);
+	for (size_t i=0; i!=n; ++i) dest[i] = (T)b[i];
+	if (n < 2) return;
+
+	for (size_t k=0; k!=n-1; ++k){
+		T xk = (T)x[k];
+		for (size_t i=n-1; i!=k; --i)
+			dest[i] -= xk * dest[i-1];
+	}
+	for (size_t k=n-2; k!=(size_t)-1; --k){
+		for (size_t i=k+1; i!=n; ++i)
+			dest[i] /= (T)x[i] - (T)x[i-k-1];
+		for (size_t i=k; i!=n-1; ++i)
+			dest[i] -= dest[i+1];
+	}
+}
+
+
+
+// puts the least squares polynomial of specified degree fitted to the points into destination,
+// returns true if there are less distinct abscissas than coefficients
+template<class B, SP_VECTOR_T(V1), SP_VECTOR_T(V2)>
+bool poly_fit(Polynomial<B> &dest, V1 &&x, V2 &&y, size_t degree) noexcept{
+	SP_MATRIX_ERROR(len(x) != len(y), "fitted points must have as many values as abscissas");
+	typedef typename B::ValueType T;
+	size_t n = len(x);
+	size_t m = degree + 1;
+	if (n < m) return true;
+
+	T lo = (T)x[0], hi = (T)x[0];
+	for (size_t i=1; i!=n; ++i){
+		if ((T)x[i] < lo) lo = (T)x[i];
+		if ((T)x[i] > hi) hi = (T)x[i];
+	}
+	if (lo == hi && degree) return true;
+	T center = (lo + hi) / (T)2;
+	T radius = lo == hi ? (T)1 : (hi - lo) / (T)2;
+
+	size_t oldSize = len(MatrixTempStorage.data);
+	expand_back(MatrixTempStorage.data, ((m*(m+1) + m+1) * sizeof(T) + 7) / 8);
+	T *R = (T *)(beg(MatrixTempStorage.data) + oldSize);	// [R | Q^T * y] stored by rows
+	T *row = R + m*(m+1);
+	for (size_t i=0; i!=m*(m+1); ++i) R[i] = (T)0;
+
+	for (size_t p=0; p!=n; ++p){
+		T t = ((T)x[p] - center) / radius;
+		T power = (T)1;
+		for (size_t j=0; j!=m; ++j){
+			row[j] = power;
+			power *= t;
+		}
+		row[m] = (T)y[p];
+
+		for (size_t j=0; j!=m; ++j){
+			if (row[j] == (T)0) continue;
+			T *Rj = R + j*(m+1);
+			T r = hypot(Rj[j], row[j]);
+			T c = Rj[j] / r;
+			T s = row[j] / r;
+			Rj[j] = r;
+			for (size_t k=j+1; k!=m+1; ++k){
+				T a = Rj[k], b = row[k];
+				Rj[k] = c*a + s*b;
+				row[k] = c*b - s*a;
+			}
+		}
+	}
+
+	T maxDiag = (T)0;
+	for (size_t j=0; j!=m; ++j)
+		if (abs(R[j*(m+1) + j]) > maxDiag) maxDiag = abs(R[j*(m+1) + j]);
+	for (size_t j=0; j!=m; ++j)
+		if (abs(R[j*(m+1) + j]) <= maxDiag * (T)m * std::numeric_limits<T>::epsilon()){
+			resize(MatrixTempStorage.data, oldSize);
+			return true;
+		}
+
+	// back substitution leaves coefficients in the variable t in the last column
+	for (size_t j=m-1; j!=(size_t)-1; --j){
+		T *Rj = R + j*(m+1);
+		T sum = Rj[m];
+		for (size_t k=j+1; k!=m; ++k) sum -= Rj[k] * R[k*(m+1) + m];
+		Rj[m] = sum / Rj[j];
+	}
+
+	// horner composition with t = (x - center) / radius
+	resize(dest, m);
+	for (size_t i=0; i!=m; ++i) dest[i] = (T)0;
+	T invRadius = (T)1 / radius;
+	for (size_t j=m-1; j!=(size_t)-1; --j){
+		for (size_t i=m-1-j; i!=0; --i)
+			dest[i] = (dest[i-1] - center*dest[i]) * invRadius;
+		dest[0] = -center*dest[0]*invRadius + R[j*(m+1) + m];
+	}
+
+	resize(MatrixTempStorage.data, oldSize);
+	return false;
+}
+
+} // END OF NAMESPACE ///////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "Operations.hpp"
+#include "SPL/Float16.hpp"
+
+#if defined(__AVX2__) || defined(__F16C__)
+	#include <immintrin.h>
+#endif
+
+namespace sp{
+
+// HALF PRECISION MATRICES
+// Float16 and BFloat16 matrices take half of the memory of float ones. Products widen their
+// elements to float and accumulate in float, the result is rounded once, when it's written.
+// Right hand side matrix of products is given transposed, so that both operands are read
+// along their rows, operands must be row major leaves. Operands can hold float, Float16 or
+// BFloat16 values, also different ones, like Float16 weights and float inputs.
+//
+// Vector instructions are used when the compiler targets them: AVX2 with FMA for products,
+// F16C for Float16 and AVX512-BF16 for rounding floats to BFloat16 and for products of two
+// BFloat16 operands. AVX512-BF16 instructions flush subnormal values to zero.
+
+
+template<class T> constexpr bool IsHalf = std::is_same_v<T, Float16> || std::is_same_v<T, BFloat16>;
+template<class T> constexpr bool IsHalfOperand = IsHalf<T> || std::is_same_v<T, float>;
+
+
+namespace priv__{
+
+template<class V, class = void>
+constexpr bool HasVectorData = false;
+
+template<class V>
+constexpr bool HasVectorData<V, std::void_t<decltype(beg(std::declval<const V &>()))>> = true;
+
+// types which are loaded as eight floats
+template<class T> constexpr bool HasWideLoad = false;
+
+#if defined(__AVX2__) && defined(__FMA__)
+template<> constexpr bool HasWideLoad<float> = true;
+template<> constexpr bool HasWideLoad<BFloat16> = true;
+
+SP_SI __m256 load_wide(const float *ptr) noexcept{ return _mm256_loadu_ps(ptr); }
+
+SP_SI __m256 load_wide(const BFloat16 *ptr) noexcept{
+	__m256i x = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)ptr));
+	return _mm256_castsi256_ps(_mm256_slli_epi32(x, 16));
+}
+
+#ifdef __F16C__
+template<> constexpr bool HasWideLoad<Float16> = true;
+
+SP_SI __m256 load_wide(const Float16 *ptr) noexcept{
+	return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)ptr));
+}
+#endif
+
+SP_SI float hsum(__m256 x) noexcept{
+	__m128 sum = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+	return _mm_cvtss_f32(sum);
+}
+
+#ifdef __AVX512BF16__
+SP_SI float hsum(__m512 x) noexcept{
+	alignas(64) float lanes[16];
+	_mm512_store_ps(lanes, x);
+	return hsum(_mm256_add_ps(_mm256_load_ps(lanes), _mm256_load_ps(lanes + 8)));
+}
+#endif
+#endif
+
+// dot products of one row with four other rows, the first row is loaded only once
+template<class EA, class EB>
+SP_SI void half_dot_1x4(
+	float *res, const EA *a, const EB *b0, const EB *b1, const EB *b2, const EB *b3, size_t len
+) noexcept{
+	size_t i = 0;
+	float r0 = 0.f, r1 = 0.f, r2 = 0.f, r3 = 0.f;
+#ifdef __AVX512BF16__
+	if constexpr (std::is_same_v<EA, BFloat16> && std::is_same_v<EB, BFloat16>){
+		__m512 acc0 = _mm512_setzero_ps();
+		__m512 acc1 = _mm512_setzero_ps();
+		__m512 acc2 = _mm512_setzero_ps();
+		__m512 acc3 = _mm512_setzero_ps();
+		for (; i+32<=len; i+=32){
+			__m512bh va = (__m512bh)_mm512_loadu_si512(a + i);
+			acc0 = _mm512_dpbf16_ps(acc0, va, (__m512bh)_mm512_loadu_si512(b0 + i));
+			acc1 = _mm512_dpbf16_ps(acc1, va, (__m512bh)_mm512_loadu_si512(b1 + i));
+			acc2 = _mm512_dpbf16_ps(acc2, va, (__m512bh)_mm512_loadu_si512(b2 + i));
+			acc3 = _mm512_dpbf16_ps(acc3, va, (__m512bh)_mm512_loadu_si512(b3 + i));
+		}
+		r0 = hsum(acc0);
+		r1 = hsum(acc1);
+		r2 = hsum(acc2);
+		r3 = hsum(acc3);
+	}
+#endif
+#if defined(__AVX2__) && defined(__FMA__)
+	if constexpr (HasWideLoad<EA> && HasWideLoad<EB>){
+		__m256 acc0 = _mm256_setzero_ps();
+		__m256 acc1 = _mm256_setzero_ps();
+		__m256 acc2 = _mm256_setzero_ps();
+		__m256 acc3 = _mm256_setzero_ps();
+		for (; i+8<=len; i+=8){
+			__m256 va = load_wide(a + i);
+			acc0 = _mm256_fmadd_ps(va, load_wide(b0 + i), acc0);
+			acc1 = _mm256_fmadd_ps(va, load_wide(b1 + i), acc1);
+			acc2 = _mm256_fmadd_ps(va, load_wide(b2 + i), acc2);
+			acc3 = _mm256_fmadd_ps(va, load_wide(b3 + i), acc3);
+		}
+		r0 += hsum(acc0);
+		r1 += hsum(acc1);
+		r2 += hsum(acc2);
+		r3 += hsum(acc3);
+	}
+#endif
+	for (; i!=len; ++i){
+		float va = (float)a[i];
+		r0 += va * (float)b0[i];
+		r1 += va * (float)b1[i];
+		r2 += va * (float)b2[i];
+		r3 += va * (float)b3[i];
+	}
+	res[0] = r0;
+	res[1] = r1;
+	res[2] = r2;
+	res[3] = r3;
+}
+
+template<class EA, class EB>
+SP_SI float half_dot(const EA *a, const EB *b, size_t len) noexcept{
+	size_t i = 0;
+	float res = 0.f;
+#ifdef __AVX512BF16__
+	if constexpr (std::is_same_v<EA, BFloat16> && std::is_same_v<EB, BFloat16>){
+		__m512 acc = _mm512_setzero_ps();
+		for (; i+32<=len; i+=32)
+			acc = _mm512_dpbf16_ps(
+				acc, (__m512bh)_mm512_loadu_si512(a + i), (__m512bh)_mm512_loadu_si512(b + i)
+			);
+		res = hsum(acc);
+	}
+#endif
+#if defined(__AVX2__) && defined(__FMA__)
+	if constexpr (HasWideLoad<EA> && HasWideLoad<EB>){
+		__m256 acc = _mm256_setzero_ps();
+		for (; i+8<=len; i+=8) acc = _mm256_fmadd_ps(load_wide(a + i), load_wide(b + i), acc);
+		res += hsum(acc);
+	}
+#endif
+	for (; i!=len; ++i) res += (float)a[i] * (float)b[i];
+	return res;
+}
+
+// converts contiguous elements, conversions between float and half types are vectorized
+template<class D, class S>
+SP_SI void convert_range(D *dest, const S *src, size_t len) noexcept{
+	size_t i = 0;
+#ifdef __F16C__
+	if constexpr (std::is_same_v<D, Float16> && std::is_same_v<S, float>)
+		for (; i+8<=len; i+=8)
+			_mm_storeu_si128(
+				(__m128i *)(dest + i),
+				_mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT)
+			);
+	if constexpr (std::is_same_v<D, float> && std::is_same_v<S, Float16>)
+		for (; i+8<=len; i+=8)
+			_mm256_storeu_ps(dest + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(src + i))));
+#endif
+#ifdef __AVX512BF16__
+	if constexpr (std::is_same_v<D, BFloat16> && std::is_same_v<S, float>)
+		for (; i+16<=len; i+=16)
+			_mm256_storeu_si256((__m256i *)(dest + i), (__m256i)_mm512_cvtneps_pbh(_mm512_loadu_ps(src + i)));
+#endif
+#if defined(__AVX2__) && defined(__FMA__)
+	if constexpr (std::is_same_v<D, float> && std::is_same_v<S, BFloat16>)
+		for (; i+8<=len; i+=8)
+			_mm256_storeu_ps(dest + i, load_wide(src + i));
+#endif
+	for (; i!=len; ++i) dest[i] = (D)src[i];
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+
+
+// dest = A * tr(Bt), accumulated in float
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2), SP_MATRIX_T(M3)>
+void half_mul(M1 &&dest, M2 &&A, M3 &&Bt) noexcept{
+	typedef typename std::decay_t<M1>::ValueType T;
+	typedef typename std::decay_t<M2>::ValueType EA;
+	typedef typename std::decay_t<M3>::ValueType EB;
+	static_assert(IsHalfOperand<EA> && IsHalfOperand<EB>, "operands must hold Float16, BFloat16 or float values");
+	static_assert(std::decay_t<M2>::RowMajor && std::decay_t<M3>::RowMajor, "operands must be row major");
+	static_assert(
+		priv__::HasLeadDim<std::decay_t<M2>> && priv__::HasLeadDim<std::decay_t<M3>>,
+		"operands must be leaves"
+	);
+	SP_MATRIX_ERROR(cols(A) != cols(Bt), "multiplied matrices must have matching inner dimensions");
+	SP_MATRIX_PROFILE_BEGIN(
+		"half_mul", 2.0*rows(A)*rows(Bt)*cols(A),
+		(rows(A)*sizeof(EA) + rows(Bt)*sizeof(EB))*cols(A) + rows(A)*rows(Bt)*sizeof(T)
+	);
+	size_t m = rows(A), n = rows(Bt), k = cols(A);
+	auto rowA = [&](size_t i){ return (const EA *)beg(A) + i*lead_dim(A); };
+	auto rowB = [&](size_t j){ return (const EB *)beg(Bt) + j*lead_dim(Bt); };
+
+	resize(dest, m, n);
+	size_t blockRows = max(matrixTuning.mulBytes / (k*sizeof(EB) + 1), (size_t)4) & ~(size_t)3;
+	for (size_t jj=0; jj<n; jj+=blockRows){	// block of Bt rows stays in cache for all rows of A
+		size_t jEnd = min(jj+blockRows, n);
+		for (size_t i=0; i!=m; ++i){
+			const EA *a = rowA(i);
+			size_t j = jj;
+			for (; j+4<=jEnd; j+=4){
+				float res[4];
+				priv__::half_dot_1x4(res, a, rowB(j), rowB(j+1), rowB(j+2), rowB(j+3), k);
+				for (size_t l=0; l!=4; ++l) dest(i, j+l) = (T)res[l];
+			}
+			for (; j!=jEnd; ++j)
+				dest(i, j) = (T)priv__::half_dot(a, rowB(j), k);
+		}
+	}
+	SP_MATRIX_PROFILE_END();
+}
+
+// dest = A * x, accumulated in float
+template<SP_VECTOR_T(V1), SP_MATRIX_T(M), SP_VECTOR_T(V2)>
+void half_mul(V1 &&dest, M &&A, V2 &&x) noexcept{
+	typedef typename std::decay_t<V1>::ValueType T;
+	typedef typename std::decay_t<M>::ValueType EA;
+	typedef typename std::decay_t<V2>::ValueType EX;
+	static_assert(IsHalfOperand<EA> && IsHalfOperand<EX>, "operands must hold Float16, BFloat16 or float values");
+	static_assert(std::decay_t<M>::RowMajor, "matrix must be row major");
+	static_assert(
+		priv__::HasLeadDim<std::decay_t<M>> && priv__::HasVectorData<std::decay_t<V2>>,
+		"operands must be leaves"
+	);
+	SP_MATRIX_ERROR(cols(A) != len(x), "vector's size must be equal to number of columns of the matrix");
+	SP_MATRIX_PROFILE_BEGIN(
+		"half_mul", 2.0*rows(A)*cols(A),
+		rows(A)*cols(A)*sizeof(EA) + len(x)*sizeof(EX) + rows(A)*sizeof(T)
+	);
+	size_t m = rows(A), k = cols(A);
+	const EX *vx = beg(x);
+	auto rowA = [&](size_t i){ return (const EA *)beg(A) + i*lead_dim(A); };
+
+	resize(dest, m);
+	size_t i = 0;
+	for (; i+4<=m; i+=4){	// the vector is loaded once for four rows
+		float res[4];
+		priv__::half_dot_1x4(res, vx, rowA(i), rowA(i+1), rowA(i+2), rowA(i+3), k);
+		for (size_t l=0; l!=4; ++l) dest[i+l] = (T)res[l];
+	}
+	for (; i!=m; ++i) dest[i] = (T)priv__::half_dot(rowA(i), vx, k);
+	SP_MATRIX_PROFILE_END();
+}
+
+
+
+// copies the matrix changing type of its elements, like float to Float16 and back
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2)>
+void convert(M1 &&dest, M2 &&src) noexcept{
+	typedef std::decay_t<M1> D;
+	typedef std::decay_t<M2> S;
+	typedef typename D::ValueType T;
+	SP_MATRIX_PROFILE_BEGIN(
+		"convert", 0, len(src)*(sizeof(T) + sizeof(typename S::ValueType))
+	);
+	size_t m = rows(src), n = cols(src);
+
+	resize(dest, m, n);
+	if constexpr (D::RowMajor && S::RowMajor && priv__::HasLeadDim<D> && priv__::HasLeadDim<S>){
+		for (size_t i=0; i!=m; ++i)
+			priv__::convert_range(beg(dest) + i*lead_dim(dest), beg(src) + i*lead_dim(src), n);
+	} else{
+		priv__::traverse<D, S>(m, n, [&](size_t i, size_t j){ dest(i, j) = (T)src(i, j); });
+	}
+	SP_MATRIX_PROFILE_END();
+}
+
+template<SP_VECTOR_T(V1), SP_VECTOR_T(V2)>
+void convert(V1 &&dest, V2 &&src) noexcept{
+	typedef typename std::decay_t<V1>::ValueType T;
+	size_t n = len(src);
+
+	resize(dest, n);
+	if constexpr (priv__::HasVectorData<std::decay_t<V1>> && priv__::HasVectorData<std::decay_t<V2>>)
+		priv__::convert_range(beg(dest), beg(src), n);
+	else
+		for (size_t i=0; i!=n; ++i) dest[i] = (T)src[i];
+}
+
+} // END OF NAMESPACE ///////////////////////////////////////////////////////////////////
@@ -0,0 +1,291 @@
+#pragma once
+
+#include "Operations.hpp"
+
+namespace sp{
+
+// INVERSE UPDATES
+// When one row (or column) of matrix A is replaced, the ratio of new and old determinant is a
+// dot product of the new row with a column of inverse of A, so it takes O(n) operations, and the
+// inverse is updated by a rank one correction in O(n^2) (sherman-morrison formula). Inverse can
+// be made from the lu decomposition with invert.
+//
+// Delayed replacements keep the inverse unchanged for up to k accepted replacements, ratios of
+// later ones are corrected for the earlier ones with a k x k matrix in O(n*k). All of them are
+// then applied as one rank k update (woodbury formula), which reads the inverse twice instead of
+// k times, the update is done by blocked matrix products. Delayed replacements need row major inverse.
+
+
+
+// returns det(A') / det(A), where A' is A with the row replaced by the vector
+template<SP_MATRIX_T(M), SP_VECTOR_T(V)>
+auto row_replace_ratio(const M &Ainv, size_t row, const V &u) noexcept{
+	SP_MATRIX_ERROR(rows(Ainv) != len(u), "replacing row must have the size of the matrix");
+	typedef typename std::decay_t<M>::ValueType T;
+	T res{};
+	for (size_t i=0; i!=len(u); ++i) res += u[i] * Ainv(i, row);
+	return res;
+}
+
+// returns det(A') / det(A), where A' is A with the column replaced by the vector
+template<SP_MATRIX_T(M), SP_VECTOR_T(V)>
+auto col_replace_ratio(const M &Ainv, size_t col, const V &v) noexcept{
+	SP_MATRIX_ERROR(cols(Ainv) != len(v), "replacing column must have the size of the matrix");
+	typedef typename std::decay_t<M>::ValueType T;
+	T res{};
+	for (size_t i=0; i!=len(v); ++i) res += Ainv(col, i) * v[i];
+	return res;
+}
+
+// turns the inverse of A into the inverse of A with the row replaced by the vector, ratio is
+// the one returned by row_replace_ratio and mustn't be zero
+template<SP_MATRIX_T(M), SP_VECTOR_T(V)>
+void row_replace_update(
+	M &&Ainv, size_t row, const V &u, typename std::decay_t<M>::ValueType ratio
+) noexcept{
+	typedef typename std::decay_t<M>::ValueType T;
+	SP_MATRIX_ERROR(rows(Ainv) != len(u), "replacing row must have the size of the matrix");
+	size_t n = rows(Ainv);
+	SP_MATRIX_PROFILE_BEGIN("row_replace_update", 4.0*n*n, 2*n*n*sizeof(T));
+
+	size_t oldSize = len(MatrixTempStorage.data);
+	expand_back(MatrixTempStorage.data, (2*n*sizeof(T) + 7) / 8);
+	T *w = (T *)(beg(MatrixTempStorage.data) + oldSize);
+	T *c = w + n;
+
+	// Ainv' = Ainv - Ainv*e_r * (u^T*Ainv - e_r^T) / ratio
+	for (size_t j=0; j!=n; ++j) w[j] = T{};
+	for (size_t i=0; i!=n; ++i){
+		T s = u[i];
+		for (size_t j=0; j!=n; ++j) w[j] += s * Ainv(i, j);
+	}
+	w[row] -= unit<T>();
+	T factor = unit<T>() / ratio;
+	for (size_t i=0; i!=n; ++i) c[i] = Ainv(i, row) * factor;
+	for (size_t i=0; i!=n; ++i){
+		T s = c[i];
+		for (size_t j=0; j!=n; ++j) Ainv(i, j) -= s * w[j];
+	}
+	resize(MatrixTempStorage.data, oldSize);
+	SP_MATRIX_PROFILE_END();
+}
+
+// turns the inverse of A into the inverse of A with the column replaced by the vector, ratio is
+// the one returned by col_replace_ratio and mustn't be zero
+template<SP_MATRIX_T(M), SP_VECTOR_T(V)>
+void col_replace_update(
+	M &&Ainv, size_t col, const V &v, typename std::decay_t<M>::ValueType ratio
+) noexcept{
+	typedef typename std::decay_t<M>::ValueType T;
+	SP_MATRIX_ERROR(cols(Ainv) != len(v), "replacing column must have the size of the matrix");
+	size_t n = rows(Ainv);
+	SP_MATRIX_PROFILE_BEGIN("col_replace_update", 4.0*n*n, 2*n*n*sizeof(T));
+
+	size_t oldSize = len(MatrixTempStorage.data);
+	expand_back(MatrixTempStorage.data, (2*n*sizeof(T) + 7) / 8);
+	T *z = (T *)(beg(MatrixTempStorage.data) + oldSize);
+	T *r = z + n;
+
+	// Ainv' = Ainv - (Ainv*v - e_c) * e_c^T*Ainv / ratio
+	T factor = unit<T>() / ratio;
+	for (size_t i=0; i!=n; ++i){
+		T sum{};
+		for (size_t j=0; j!=n; ++j) sum += Ainv(i, j) * v[j];
+		z[i] = (sum - (i == col ? unit<T>() : T{})) * factor;
+	}
+	for (size_t j=0; j!=n; ++j) r[j] = Ainv(col, j);
+	for (size_t i=0; i!=n; ++i){
+		T s = z[i];
+		for (size_t j=0; j!=n; ++j) Ainv(i, j) -= s * r[j];
+	}
+	resize(MatrixTempStorage.data, oldSize);
+	SP_MATRIX_PROFILE_END();
+}
+
+
+
+// pending replacements of rows (or columns) of the matrix, S is the k x k matrix of the woodbury
+// formula, S[i][j] = u_i . Ainv[:, r_j] for rows and Ainv[c_i, :] . v_j for columns
+template<class T, bool ByRows>
+struct DelayedReplacements{
+	T *vectors;     // new rows or columns, one per line of length size
+	T *lines;       // columns of inverse at replaced rows, or rows of inverse at replaced columns
+	T *work;        // k x size scratch of the final update
+	T *invS;        // inverse of S, count x count part of k x k array is used
+	T *x;           // invS * new column of S, of the last proposed replacement
+	T *y;           // new row of S * invS, of the last proposed replacement
+	uint32_t *positions;
+	size_t size;
+	uint32_t capacity;
+	uint32_t count;
+	uint32_t proposed;  // position of the last proposed replacement
+	T ratio;            // its determinant ratio
+};
+
+namespace priv__{
+
+template<class T>
+SP_CSI T dot_line(const T *lhs, const T *rhs, size_t n) noexcept{
+	T res{};
+	for (size_t i=0; i!=n; ++i) res += lhs[i] * rhs[i];
+	return res;
+}
+
+template<class T, bool ByRows, class Al>
+DelayedReplacements<T, ByRows> delayed_replacements_impl(size_t n, size_t k, Al &allocator) noexcept{
+	DelayedReplacements<T, ByRows> res = {};
+	if (!k) k = 1;
+	size_t bytes = (3*k*n + k*k + 4*k) * sizeof(T) + k * sizeof(uint32_t);
+	Memblock blk;
+	if constexpr (Al::Alignment)
+		blk = alloc(allocator, bytes);
+	else
+		blk = alloc(allocator, bytes, alignof(T));
+	if (blk.ptr == nullptr) return res;
+
+	res.vectors = (T *)blk.ptr;
+	res.lines = res.vectors + k*n;
+	res.work = res.lines + k*n;
+	res.invS = res.work + k*n;
+	res.x = res.invS + k*k;
+	res.y = res.x + k;
+	res.positions = (uint32_t *)(res.y + 3*k);	// 2*k elements after y are scratch
+	res.size = n;
+	res.capacity = k;
+	res.proposed = UINT32_MAX;
+	return res;
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+// returns the object of pending row replacements of matrix of specified size, at most k
+// replacements are delayed, its vectors are nullptr if the allocation failed
+template<class T, class Al>
+DelayedReplacements<T, true> delayed_row_replacements(size_t n, size_t k, Al &allocator) noexcept{
+	return priv__::delayed_replacements_impl<T, true>(n, k, allocator);
+}
+
+// returns the object of pending column replacements of matrix of specified size
+template<class T, class Al>
+DelayedReplacements<T, false> delayed_col_replacements(size_t n, size_t k, Al &allocator) noexcept{
+	return priv__::delayed_replacements_impl<T, false>(n, k, allocator);
+}
+
+template<class T, bool ByRows, class Al>
+void free(Al &allocator, const DelayedReplacements<T, ByRows> &upd) noexcept{
+	size_t k = upd.capacity, n = upd.size;
+	free(allocator, Memblock{
+		(uint8_t *)upd.vectors, (3*k*n + k*k + 4*k) * sizeof(T) + k * sizeof(uint32_t)
+	});
+}
+
+// applies the pending replacements to the inverse in one rank k update, inverse must be a row
+// major leaf
+template<class T, bool ByRows, SP_MATRIX_T(M)>
+void apply_replacements(DelayedReplacements<T, ByRows> &upd, M &&Ainv) noexcept{
+	static_assert(
+		std::decay_t<M>::RowMajor && priv__::HasLeadDim<std::decay_t<M>>,
+		"delayed replacements need row major inverse"
+	);
+	SP_MATRIX_ERROR(rows(Ainv) != upd.size || cols(Ainv) != upd.size, "inverse has different size");
+	size_t n = upd.size, k = upd.count, ld = lead_dim(Ainv);
+	upd.proposed = UINT32_MAX;
+	if (!k) return;
+	SP_MATRIX_PROFILE_BEGIN("apply_replacements", 4.0*n*n*k + 2.0*k*k*n, 3*n*n*sizeof(T));
+	T *a = beg(Ainv);
+
+	// rows: Ainv' = Ainv - C * invS*(U*Ainv - P^T), C are columns of Ainv at replaced rows
+	// columns: Ainv' = Ainv - (Ainv*V^T - P) * invS*R, R are rows of Ainv at replaced columns
+	// the left n x k factor is put into vectors, the right k x n one into lines or work
+	T *right;
+	if constexpr (ByRows){
+		priv__::gemm_block(upd.work, n, upd.vectors, n, (const T *)a, ld, k, n, n);
+		for (size_t i=0; i!=k; ++i) upd.work[i*n + upd.positions[i]] -= unit<T>();
+		for (size_t i=0; i!=k; ++i)
+			for (size_t t=0; t!=n; ++t) upd.vectors[t*k + i] = upd.lines[i*n + t];
+		priv__::gemm_block(upd.lines, n, (const T *)upd.invS, upd.capacity, (const T *)upd.work, n, k, k, n);
+		right = upd.lines;
+	} else{
+		for (size_t i=0; i!=k; ++i)
+			for (size_t t=0; t!=n; ++t) upd.work[t*k + i] = upd.vectors[i*n + t];
+		priv__::gemm_block(upd.vectors, k, (const T *)a, ld, (const T *)upd.work, k, n, n, k);
+		for (size_t i=0; i!=k; ++i) upd.vectors[upd.positions[i]*k + i] -= unit<T>();
+		priv__::gemm_block(upd.work, n, (const T *)upd.invS, upd.capacity, (const T *)upd.lines, n, k, k, n);
+		right = upd.work;
+	}
+	priv__::gemm_acc(a, ld, (const T *)upd.vectors, k, (const T *)right, n, n, k, n, -unit<T>());
+	upd.count = 0;
+	SP_MATRIX_PROFILE_END();
+}
+
+// returns det(A') / det(A) of replacing the row (or column) of A, as it is after the pending
+// replacements, takes O(n*k) operations, pending replacements are applied first if the same
+// position is replaced again, the replacement is kept until it's accepted or other one is proposed
+template<class T, bool ByRows, SP_MATRIX_T(M), SP_VECTOR_T(V)>
+T propose_replacement(DelayedReplacements<T, ByRows> &upd, M &&Ainv, size_t pos, const V &vec) noexcept{
+	SP_MATRIX_ERROR(rows(Ainv) != upd.size || cols(Ainv) != upd.size, "inverse has different size");
+	SP_MATRIX_ERROR(len(vec) != upd.size, "replacing vector must have the size of the matrix");
+	size_t n = upd.size;
+	for (size_t i=0; i!=upd.count; ++i)
+		if (upd.positions[i] == pos){
+			apply_replacements(upd, Ainv);
+			break;
+		}
+	size_t k = upd.count;
+	T *v = upd.vectors + k*n;
+	T *line = upd.lines + k*n;
+	for (size_t i=0; i!=n; ++i) v[i] = vec[i];
+	if constexpr (ByRows)
+		for (size_t i=0; i!=n; ++i) line[i] = Ainv(i, pos);
+	else
+		for (size_t i=0; i!=n; ++i) line[i] = Ainv(pos, i);
+
+	// S is bordered by new row g and column h, the ratio is its schur complement d - g*invS*h
+	const T *rowSide = ByRows ? upd.vectors : upd.lines;
+	const T *colSide = ByRows ? upd.lines : upd.vectors;
+	T *g = upd.y + upd.capacity;
+	T *h = g + upd.capacity;
+	for (size_t i=0; i!=k; ++i){
+		g[i] = priv__::dot_line(rowSide + k*n, colSide + i*n, n);
+		h[i] = priv__::dot_line(rowSide + i*n, colSide + k*n, n);
+	}
+	T res = priv__::dot_line(rowSide + k*n, colSide + k*n, n);
+	for (size_t i=0; i!=k; ++i){
+		T sumX{}, sumY{};
+		for (size_t j=0; j!=k; ++j){
+			sumX += upd.invS[i*upd.capacity + j] * h[j];
+			sumY += g[j] * upd.invS[j*upd.capacity + i];
+		}
+		upd.x[i] = sumX;
+		upd.y[i] = sumY;
+		res -= g[i] * sumX;
+	}
+	upd.proposed = pos;
+	upd.ratio = res;
+	return res;
+}
+
+// accepts the last proposed replacement, its ratio mustn't be zero, takes O(k^2) operations
+// and the rank k update when k replacements are pending
+template<class T, bool ByRows, SP_MATRIX_T(M)>
+void accept_replacement(DelayedReplacements<T, ByRows> &upd, M &&Ainv) noexcept{
+	SP_MATRIX_ERROR(upd.proposed == UINT32_MAX, "no replacement was proposed");
+	size_t k = upd.count, ld = upd.capacity;
+	T *invS = upd.invS;
+	T s = unit<T>() / upd.ratio;
+
+	// inverse of bordered matrix: [invS + x*y/s, -x/s; -y/s, 1/s]
+	for (size_t i=0; i!=k; ++i)
+		for (size_t j=0; j!=k; ++j) invS[i*ld + j] += upd.x[i] * upd.y[j] * s;
+	for (size_t i=0; i!=k; ++i){
+		invS[i*ld + k] = -upd.x[i] * s;
+		invS[k*ld + i] = -upd.y[i] * s;
+	}
+	invS[k*ld + k] = s;
+	upd.positions[k] = upd.proposed;
+	upd.proposed = UINT32_MAX;
+	upd.count = k + 1;
+	if (upd.count == upd.capacity) apply_replacements(upd, Ainv);
+}
+
+} // END OF NAMESPACE ///////////////////////////////////////////////////////////////////
@@ -0,0 +1,443 @@
+#pragma once
+
+#include "Expr.hpp"
+#include <math.h>
+
+namespace sp{
+
+// Iterative solvers of linear equations A*x = b. The matrix is never accessed directly, it's
+// given as a callable op(T *dest, const T *src) that puts A*src into dest, so the solvers work
+// with dense matrices (through dense_op), user defined sparse formats or a Delegate. The
+// preconditioners are callables of the same form that put M^-1 * src into dest.
+// All workspace is taken from the allocator once, before the first iteration.
+
+
+
+enum class IterativeStatus : uint8_t{
+	Converged,      // relative residual dropped below the tolerance
+	NotConverged,   // iteration limit was reached
+	Breakdown,      // a scalar of the method became zero (or the matrix isn't positive definite)
+	OutOfMemory     // the workspace couldn't be allocated
+};
+
+template<class T>
+struct IterativeSolveRes{
+	T residual;     // last ||b - A*x|| / ||b||
+	uint32_t iterations;
+	IterativeStatus status;
+};
+
+
+struct NoPreconditioner{};
+
+template<class T>
+struct JacobiPreconditioner{
+	T *inv_diagonal;
+	size_t size;
+
+	SP_CI void operator ()(T *dest, const T *src) const noexcept{
+		for (size_t i=0; i!=size; ++i) dest[i] = inv_diagonal[i] * src[i];
+	}
+};
+
+// applies (L*L^T)^-1, where L is the lower triangle of the matrix
+template<class M>
+struct CholeskyPreconditioner{
+	const M *factor;
+
+	template<class T>
+	void operator ()(T *dest, const T *src) const noexcept{
+		const M &L = *factor;
+		size_t length = rows(L);
+		for (size_t i=0; i!=length; ++i){
+			T sum = src[i];
+			for (size_t j=0; j!=i; ++j) sum -= L(i, j) * dest[j];
+			dest[i] = sum / L(i, i);
+		}
+		for (size_t i=length-1; i!=(size_t)-1; --i){
+			T sum = dest[i];
+			for (size_t j=i+1; j!=length; ++j) sum -= L(j, i) * dest[j];
+			dest[i] = sum / L(i, i);
+		}
+	}
+};
+
+
+
+// returns the operator of dense matrix
+template<SP_MATRIX_T(M)>
+auto dense_op(const M &A) noexcept{
+	typedef typename std::decay_t<M>::ValueType T;
+	return [&A](T *dest, const T *src) noexcept{
+		if constexpr (std::decay_t<M>::RowMajor){
+			for (size_t i=0; i!=rows(A); ++i){
+				T sum = (T)0;
+				for (size_t j=0; j!=cols(A); ++j) sum += A(i, j) * src[j];
+				dest[i] = sum;
+			}
+		} else{
+			for (size_t i=0; i!=rows(A); ++i) dest[i] = (T)0;
+			for (size_t j=0; j!=cols(A); ++j)
+				for (size_t i=0; i!=rows(A); ++i) dest[i] += A(i, j) * src[j];
+		}
+	};
+}
+
+// returns the jacobi preconditioner of matrix, its inv_diagonal is nullptr if allocation failed
+template<SP_MATRIX_T(M), class Al>
+auto jacobi_preconditioner(const M &A, Al &allocator) noexcept{
+	SP_MATRIX_ERROR(rows(A) != cols(A), "only square matrix can be preconditioned");
+	typedef typename std::decay_t<M>::ValueType T;
+	size_t length = rows(A);
+	Memblock blk;
+	if constexpr (Al::Alignment)
+		blk = alloc(allocator, length * sizeof(T));
+	else
+		blk = alloc(allocator, length * sizeof(T), alignof(T));
+	JacobiPreconditioner<T> res{(T *)blk.ptr, length};
+	if (blk.ptr != nullptr)
+		for (size_t i=0; i!=length; ++i) res.inv_diagonal[i] = (T)1 / A(i, i);
+	return res;
+}
+
+template<class T, class Al>
+void free(Al &allocator, const JacobiPreconditioner<T> &precond) noexcept{
+	free(allocator, Memblock{(uint8_t *)precond.inv_diagonal, precond.size * sizeof(T)});
+}
+
+// returns the preconditioner of cholesky or incomplete cholesky decomposed matrix,
+// the matrix is referenced and must outlive the preconditioner
+template<SP_MATRIX_T(M)>
+auto cholesky_preconditioner(const M &L) noexcept{
+	SP_MATRIX_ERROR(rows(L) != cols(L), "only square matrix can be used as preconditioner");
+	return CholeskyPreconditioner<M>{&L};
+}
+
+// in place incomplete cholesky decomposition with no fill, elements of the lower triangle that
+// are zero stay zero, returns true if a pivot wasn't positive
+template<SP_MATRIX_T(M)>
+bool ic0_decompose(M &&dest) noexcept{
+	SP_MATRIX_ERROR(rows(dest) != cols(dest), "only square matrix can be cholesky decomposed");
+	typedef typename std::decay_t<M>::ValueType T;
+	size_t length = rows(dest);
+	for (size_t i=0; i!=length; ++i){
+		for (size_t j=0; j!=i; ++j){
+			if (dest(i, j) == (T)0) continue;
+			T sum = (T)0;
+			for (size_t k=0; k!=j; ++k)
+				sum += dest(i, k) * dest(j, k);
+			dest(i, j) = (dest(i, j) - sum) / dest(j, j);
+		}
+		T sum = (T)0;
+		for (size_t k=0; k!=i; ++k)
+			sum += dest(i, k) * dest(i, k);
+		T pivot = dest(i, i) - sum;
+		if (!(pivot > (T)0)) return true;
+		dest(i, i) = sqrt(pivot);
+	}
+	return false;
+}
+
+
+
+namespace priv__{
+
+template<class T>
+SP_CSI T dot_n(const T *lhs, const T *rhs, size_t n) noexcept{
+	T res = (T)0;
+	for (size_t i=0; i!=n; ++i) res += lhs[i] * rhs[i];
+	return res;
+}
+
+template<class T, class Al>
+SP_SI T *alloc_workspace(Al &allocator, Memblock &blk, size_t count) noexcept{
+	if constexpr (Al::Alignment)
+		blk = alloc(allocator, count * sizeof(T));
+	else
+		blk = alloc(allocator, count * sizeof(T), alignof(T));
+	return (T *)blk.ptr;
+}
+
+template<class Pc, class T>
+SP_SI void apply_preconditioner(Pc &precond, T *dest, const T *src, size_t n) noexcept{
+	if constexpr (std::is_same_v<std::decay_t<Pc>, NoPreconditioner>)
+		for (size_t i=0; i!=n; ++i) dest[i] = src[i];
+	else
+		precond(dest, src);
+}
+
+// r = b - A*x, returns ||r||
+template<class Op, class V, class T>
+SP_SI T start_residual(Op &op, const V &b, const T *x, T *r, size_t n) noexcept{
+	op(r, x);
+	for (size_t i=0; i!=n; ++i) r[i] = (T)b[i] - r[i];
+	return sqrt(dot_n(r, r, n));
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+
+
+// conjugate gradient for symmetric positive definite A, x holds the initial guess on input
+template<SP_VECTOR_T(V1), class Op, SP_VECTOR_T(V2), class Pc, class Al>
+auto cg(
+	V1 &&x, Op &&op, const V2 &b, Pc &&precond, Al &allocator,
+	typename std::decay_t<V1>::ValueType tolerance, size_t maxIters
+) noexcept{
+	SP_MATRIX_ERROR(len(x) != len(b), "solution and right hand side must have the same size");
+	typedef typename std::decay_t<V1>::ValueType T;
+	constexpr bool Plain = std::is_same_v<std::decay_t<Pc>, NoPreconditioner>;
+	size_t n = len(b);
+	IterativeSolveRes<T> res{(T)0, 0, IterativeStatus::Converged};
+
+	Memblock blk;
+	T *xw = priv__::alloc_workspace<T>(allocator, blk, (Plain ? 4 : 5) * n);
+	if (xw == nullptr){
+		res.status = IterativeStatus::OutOfMemory;
+		return res;
+	}
+	T *r = xw + n;
+	T *p = r + n;
+	T *q = p + n;
+	T *z = Plain ? r : q + n;
+
+	for (size_t i=0; i!=n; ++i) xw[i] = x[i];
+	T normB = (T)0;
+	for (size_t i=0; i!=n; ++i) normB += (T)b[i] * (T)b[i];
+	normB = sqrt(normB);
+	if (normB == (T)0) normB = (T)1;
+
+	res.residual = priv__::start_residual(op, b, xw, r, n) / normB;
+	if constexpr (!Plain) precond(z, r);
+	for (size_t i=0; i!=n; ++i) p[i] = z[i];
+	T rz = priv__::dot_n(r, z, n);
+
+	while (res.residual > tolerance){
+		if (res.iterations == maxIters){
+			res.status = IterativeStatus::NotConverged;
+			break;
+		}
+		++res.iterations;
+		op(q, p);
+		T pq = priv__::dot_n(p, q, n);
+		if (!(pq > (T)0)){
+			res.status = IterativeStatus::Breakdown;
+			break;
+		}
+		T alpha = rz / pq;
+		for (size_t i=0; i!=n; ++i){
+			xw[i] += alpha * p[i];
+			r[i] -= alpha * q[i];
+		}
+		res.residual = sqrt(priv__::dot_n(r, r, n)) / normB;
+		if constexpr (!Plain) precond(z, r);
+		T rzNext = priv__::dot_n(r, z, n);
+		T beta = rzNext / rz;
+		rz = rzNext;
+		for (size_t i=0; i!=n; ++i) p[i] = z[i] + beta * p[i];
+	}
+
+	for (size_t i=0; i!=n; ++i) x[i] = xw[i];
+	free(allocator, blk);
+	return res;
+}
+
+// biconjugate gradient stabilized with right preconditioning for general A,
+// x holds the initial guess on input
+template<SP_VECTOR_T(V1), class Op, SP_VECTOR_T(V2), class Pc, class Al>
+auto bicgstab(
+	V1 &&x, Op &&op, const V2 &b, Pc &&precond, Al &allocator,
+	typename std::decay_t<V1>::ValueType tolerance, size_t maxIters
+) noexcept{
+	SP_MATRIX_ERROR(len(x) != len(b), "solution and right hand side must have the same size");
+	typedef typename std::decay_t<V1>::ValueType T;
+	constexpr bool Plain = std::is_same_v<std::decay_t<Pc>, NoPreconditioner>;
+	size_t n = len(b);
+	IterativeSolveRes<T> res{(T)0, 0, IterativeStatus::Converged};
+
+	Memblock blk;
+	T *xw = priv__::alloc_workspace<T>(allocator, blk, (Plain ? 6 : 8) * n);
+	if (xw == nullptr){
+		res.status = IterativeStatus::OutOfMemory;
+		return res;
+	}
+	T *r = xw + n;	// also holds s
+	T *rh = r + n;
+	T *p = rh + n;
+	T *v = p + n;
+	T *t = v + n;
+	T *ph = Plain ? p : t + n;
+	T *sh = Plain ? r : ph + n;
+
+	for (size_t i=0; i!=n; ++i) xw[i] = x[i];
+	T normB = (T)0;
+	for (size_t i=0; i!=n; ++i) normB += (T)b[i] * (T)b[i];
+	normB = sqrt(normB);
+	if (normB == (T)0) normB = (T)1;
+
+	res.residual = priv__::start_residual(op, b, xw, r, n) / normB;
+	for (size_t i=0; i!=n; ++i){
+		rh[i] = r[i];
+		p[i] = (T)0;
+		v[i] = (T)0;
+	}
+	T rho = (T)1, alpha = (T)1, omega = (T)1;
+
+	while (res.residual > tolerance){
+		if (res.iterations == maxIters){
+			res.status = IterativeStatus::NotConverged;
+			break;
+		}
+		++res.iterations;
+		T rhoNext = priv__::dot_n(rh, r, n);
+		if (rhoNext == (T)0){
+			res.status = IterativeStatus::Breakdown;
+			break;
+		}
+		T beta = (rhoNext / rho) * (alpha / omega);
+		rho = rhoNext;
+		for (size_t i=0; i!=n; ++i) p[i] = r[i] + beta * (p[i] - omega * v[i]);
+
+		if constexpr (!Plain) precond(ph, p);
+		op(v, ph);
+		T rhv = priv__::dot_n(rh, v, n);
+		if (rhv == (T)0){
+			res.status = IterativeStatus::Breakdown;
+			break;
+		}
+		alpha = rho / rhv;
+		for (size_t i=0; i!=n; ++i) r[i] -= alpha * v[i];
+		res.residual = sqrt(priv__::dot_n(r, r, n)) / normB;
+		if (res.residual <= tolerance){
+			for (size_t i=0; i!=n; ++i) xw[i] += alpha * ph[i];
+			break;
+		}
+
+		if constexpr (!Plain) precond(sh, r);
+		op(t, sh);
+		T tt = priv__::dot_n(t, t, n);
+		omega = tt == (T)0 ? (T)0 : priv__::dot_n(t, r, n) / tt;
+		for (size_t i=0; i!=n; ++i){
+			xw[i] += alpha * ph[i] + omega * sh[i];
+			r[i] -= omega * t[i];
+		}
+		res.residual = sqrt(priv__::dot_n(r, r, n)) / normB;
+		if (omega == (T)0 && res.residual > tolerance){
+			res.status = IterativeStatus::Breakdown;
+			break;
+		}
+	}
+
+	for (size_t i=0; i!=n; ++i) x[i] = xw[i];
+	free(allocator, blk);
+	return res;
+}
+
+// restarted generalized minimal residual with right preconditioning for general A,
+// the krylov basis is rebuilt after every restartLen iterations,
+// x holds the initial guess on input
+template<SP_VECTOR_T(V1), class Op, SP_VECTOR_T(V2), class Pc, class Al>
+auto gmres(
+	V1 &&x, Op &&op, const V2 &b, Pc &&precond, Al &allocator,
+	typename std::decay_t<V1>::ValueType tolerance, size_t maxIters, size_t restartLen = 30
+) noexcept{
+	SP_MATRIX_ERROR(len(x) != len(b), "solution and right hand side must have the same size");
+	SP_MATRIX_ERROR(restartLen == 0, "restart length must be positive");
+	typedef typename std::decay_t<V1>::ValueType T;
+	size_t n = len(b);
+	size_t m = restartLen;
+	IterativeSolveRes<T> res{(T)0, 0, IterativeStatus::Converged};
+
+	// workspace: xw, w, z [n each], V [(m+1)*n], H [(m+1)*m], cs, sn [m each], g [m+1]
+	Memblock blk;
+	T *xw = priv__::alloc_workspace<T>(allocator, blk, (m+4)*n + (m+1)*m + 3*m + 1);
+	if (xw == nullptr){
+		res.status = IterativeStatus::OutOfMemory;
+		return res;
+	}
+	T *w = xw + n;
+	T *z = w + n;
+	T *V = z + n;                 // m+1 basis vectors
+	T *H = V + (m+1)*n;           // hessenberg matrix, column major (m+1) x m
+	T *cs = H + (m+1)*m;
+	T *sn = cs + m;
+	T *g = sn + m;                // m+1 elements, transformed residual
+
+	for (size_t i=0; i!=n; ++i) xw[i] = x[i];
+	T normB = (T)0;
+	for (size_t i=0; i!=n; ++i) normB += (T)b[i] * (T)b[i];
+	normB = sqrt(normB);
+	if (normB == (T)0) normB = (T)1;
+
+	for (;;){
+		T beta = priv__::start_residual(op, b, xw, V, n);
+		res.residual = beta / normB;
+		if (res.residual <= tolerance) break;
+		if (res.iterations == maxIters){
+			res.status = IterativeStatus::NotConverged;
+			break;
+		}
+
+		for (size_t i=0; i!=n; ++i) V[i] /= beta;
+		g[0] = beta;
+		for (size_t i=1; i!=m+1; ++i) g[i] = (T)0;
+
+		size_t k = 0;
+		while (k != m && res.iterations != maxIters){
+			++res.iterations;
+			T *h = H + k*(m+1);
+			T *next = V + (k+1)*n;
+			priv__::apply_preconditioner(precond, z, V + k*n, n);
+			op(next, z);
+			for (size_t i=0; i!=k+1; ++i){	// modified gram-schmidt
+				h[i] = priv__::dot_n(next, V + i*n, n);
+				for (size_t j=0; j!=n; ++j) next[j] -= h[i] * V[i*n + j];
+			}
+			h[k+1] = sqrt(priv__::dot_n(next, next, n));
+			if (h[k+1] != (T)0)
+				for (size_t j=0; j!=n; ++j) next[j] /= h[k+1];
+
+			for (size_t i=0; i!=k; ++i){
+				T temp = cs[i]*h[i] + sn[i]*h[i+1];
+				h[i+1] = cs[i]*h[i+1] - sn[i]*h[i];
+				h[i] = temp;
+			}
+			T radius = sqrt(h[k]*h[k] + h[k+1]*h[k+1]);
+			if (radius == (T)0){
+				res.status = IterativeStatus::Breakdown;
+				break;
+			}
+			cs[k] = h[k] / radius;
+			sn[k] = h[k+1] / radius;
+			h[k] = radius;
+			h[k+1] = (T)0;
+			g[k+1] = -sn[k] * g[k];
+			g[k] = cs[k] * g[k];
+			++k;
+
+			res.residual = (g[k] < (T)0 ? -g[k] : g[k]) / normB;
+			if (res.residual <= tolerance) break;
+		}
+
+		for (size_t i=k-1; i!=(size_t)-1; --i){	// solve the triangular system in place of g
+			T sum = g[i];
+			for (size_t j=i+1; j!=k; ++j) sum -= H[j*(m+1) + i] * g[j];
+			g[i] = sum / H[i*(m+1) + i];
+		}
+		for (size_t j=0; j!=n; ++j) w[j] = (T)0;
+		for (size_t i=0; i!=k; ++i)
+			for (size_t j=0; j!=n; ++j) w[j] += g[i] * V[i*n + j];
+		priv__::apply_preconditioner(precond, z, w, n);
+		for (size_t j=0; j!=n; ++j) xw[j] += z[j];
+
+		if (res.status == IterativeStatus::Breakdown) break;
+	}
+
+	for (size_t i=0; i!=n; ++i) x[i] = xw[i];
+	free(allocator, blk);
+	return res;
+}
+
+
+
+} // END OF NAMESPACE ///////////////////////////////////////////////////////////////////
@@ -18,6 +18,12 @@ using FiniteMatrix = MatrixWrapper<MatrixFinite<T, RowMajor, C>>;
 template<class T, class A = sp::MallocAllocator<>, bool RowMajor = true>
 using DynamicMatrix = MatrixWrapper<MatrixDynamic<T, RowMajor, A>>;
 
+template<class T, bool RowMajor = true>
+using PaddedMatrix = MatrixWrapper<MatrixDynamic<T, RowMajor, sp::MallocAllocator<>, true>>;
+
+template<class T, class A = sp::MallocAllocator<>, bool RowMajor = true>
+using PaddedDynamicMatrix = MatrixWrapper<MatrixDynamic<T, RowMajor, A, true>>;
+
 
 
 
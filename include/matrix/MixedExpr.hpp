@@ -19,6 +19,8 @@ struct MatrixExprAsMatrix{
 	constexpr static bool RowMajor = CVec;
 	constexpr static bool UndefMajor = false;
 	constexpr static bool UsesBuffer = Arg::UsesBuffer;
+	constexpr static size_t StaticRows = CVec ? priv__::StaticLenOf<Arg> : 1;
+	constexpr static size_t StaticCols = CVec ? 1 : priv__::StaticLenOf<Arg>;
 
 	constexpr std::conditional_t<LV, ValueType &, ValueType> operator ()(
 		size_t r, size_t c
@@ -64,6 +66,8 @@ struct MatrixExprAsDiagonalMatrix{
 	constexpr static bool RowMajor = true;
 	constexpr static bool UndefMajor = true;
 	constexpr static bool UsesBuffer = Arg::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::StaticLenOf<Arg>;
+	constexpr static size_t StaticCols = priv__::StaticLenOf<Arg>;
 
 	constexpr std::enable_if_t<LV, ValueType &> operator ()(size_t r, size_t c) noexcept{
 		return arg[r];
@@ -107,6 +111,7 @@ struct VectorExprAsRowVector{
 	typedef typename Arg::ValueType ValueType;
 	constexpr static bool isExpr = Arg::isExpr;
 	constexpr static bool UsesBuffer = Arg::UsesBuffer;
+	constexpr static size_t StaticLen = priv__::StaticColsOf<Arg>;
 
 	constexpr std::conditional_t<LV, ValueType &, ValueType> operator [](size_t i) noexcept{
 		return arg(rowIndex, i);
@@ -130,6 +135,7 @@ struct VectorExprAsColumnVector{
 	typedef typename Arg::ValueType ValueType;
 	constexpr static bool isExpr = Arg::isExpr;
 	constexpr static bool UsesBuffer = Arg::UsesBuffer;
+	constexpr static size_t StaticLen = priv__::StaticRowsOf<Arg>;
 
 	constexpr std::conditional_t<LV, ValueType &, ValueType> operator [](size_t i) noexcept{ 
 		return arg(i, columnIndex);
@@ -153,12 +159,17 @@ struct VectorExprMatrixVertMultiply{
 
 	typedef typename Arg1::ValueType ValueType;
 	constexpr static bool UsesBuffer = Arg1::UsesBuffer || Arg2::UsesBuffer;
+	constexpr static size_t StaticLen = priv__::StaticRowsOf<Arg1>;
+	constexpr static size_t StaticInner = priv__::merge_size(priv__::StaticColsOf<Arg1>, priv__::StaticLenOf<Arg2>);
+	static_assert(
+		priv__::sizes_match(priv__::StaticColsOf<Arg1>, priv__::StaticLenOf<Arg2>),
+		"multiplied matrix and vector have wrong dimensions"
+	);
 
 	constexpr ValueType operator [](size_t i) const noexcept{
-		ValueType res = (ValueType)0;
-		for (size_t j=0; j!=len(arg2); ++j)
-			res += arg1(i, j) * arg2[j];
-		return res;
+		return priv__::static_dot<StaticInner, ValueType>(
+			len(arg2), [&](size_t j){ return arg1(i, j) * arg2[j]; }
+		);
 	}
 };
 
@@ -178,12 +189,17 @@ struct VectorExprMatrixHoriMultiply{
 
 	typedef typename Arg1::ValueType ValueType;
 	constexpr static bool UsesBuffer = Arg1::UsesBuffer || Arg2::UsesBuffer;
+	constexpr static size_t StaticLen = priv__::StaticColsOf<Arg2>;
+	constexpr static size_t StaticInner = priv__::merge_size(priv__::StaticLenOf<Arg1>, priv__::StaticRowsOf<Arg2>);
+	static_assert(
+		priv__::sizes_match(priv__::StaticLenOf<Arg1>, priv__::StaticRowsOf<Arg2>),
+		"multiplied vector and matrix have wrong dimensions"
+	);
 
 	constexpr ValueType operator [](size_t i) const noexcept{
-		ValueType res = (ValueType)0;
-		for (size_t j=0; j!=len(arg1); ++j)
-			res += arg1[j] * arg2(j, i);
-		return res;
+		return priv__::static_dot<StaticInner, ValueType>(
+			len(arg1), [&](size_t j){ return arg1[j] * arg2(j, i); }
+		);
 	}
 };
 
@@ -192,6 +208,85 @@ SP_CI size_t len(const VectorExprMatrixHoriMultiply<V, M> &m) noexcept{ return c
 
 
 
+namespace priv__{
+
+template<class M>
+constexpr bool IsKron = false;
+
+template<class ML, class MR>
+constexpr bool IsKron<MatrixExprKron<ML, MR>> = true;
+
+} // END OF NAMESPACE PRIV //////////
+
+// product of kronecker product and vector, (A (x) B)*x is computed as A*X*tr(B), where X is the
+// vector read as row major matrix with columns of B, so it takes m*n*p + n*p*q operations
+// instead of m*n*p*q, the result is computed into the temporary storage when the node is made
+template<class T>
+struct VectorExprKronMultiply{
+	static constexpr StupidVectorFlagType VectorFlag{};
+	size_t data_index;
+	size_t size;
+
+	template<class ML, class MR, class V>
+	VectorExprKronMultiply(const ML &A, const MR &B, const V &x) noexcept :
+		data_index(len(MatrixTempStorage.data)), size(rows(A)*rows(B))
+	{
+		size_t m = rows(A), n = cols(A), p = rows(B), q = cols(B);
+		SP_MATRIX_PROFILE_BEGIN(
+			"kron_mul", 2.0*min(m*n*p + n*p*q, m*n*q + m*p*q), (m*n + p*q + n*q + m*p)*sizeof(T)
+		);
+		// either B or A is applied first, whichever makes the intermediate matrix cheaper
+		bool rhsFirst = m*n*p + n*p*q <= m*n*q + m*p*q;
+		size_t resWords = (m*p*sizeof(T) + 7) / 8;
+		size_t tempLen = rhsFirst ? n*p : m*q;
+		expand_back(MatrixTempStorage.data, resWords + (tempLen*sizeof(T) + 7) / 8);
+		T *res = (T *)(beg(MatrixTempStorage.data) + data_index);
+		T *temp = (T *)(beg(MatrixTempStorage.data) + data_index + resWords);
+
+		if (rhsFirst){
+			for (size_t j=0; j!=n; ++j)	// temp = X * tr(B)
+				for (size_t k=0; k!=p; ++k){
+					T sum = (T)0;
+					for (size_t l=0; l!=q; ++l) sum += x[j*q+l] * B(k, l);
+					temp[j*p+k] = sum;
+				}
+			for (size_t i=0; i!=m*p; ++i) res[i] = (T)0;
+			for (size_t i=0; i!=m; ++i)	// res = A * temp
+				for (size_t j=0; j!=n; ++j){
+					T a = A(i, j);
+					for (size_t k=0; k!=p; ++k) res[i*p+k] += a * temp[j*p+k];
+				}
+		} else{
+			for (size_t i=0; i!=m*q; ++i) temp[i] = (T)0;
+			for (size_t i=0; i!=m; ++i)	// temp = A * X
+				for (size_t j=0; j!=n; ++j){
+					T a = A(i, j);
+					for (size_t l=0; l!=q; ++l) temp[i*q+l] += a * x[j*q+l];
+				}
+			for (size_t i=0; i!=m; ++i)	// res = temp * tr(B)
+				for (size_t k=0; k!=p; ++k){
+					T sum = (T)0;
+					for (size_t l=0; l!=q; ++l) sum += temp[i*q+l] * B(k, l);
+					res[i*p+k] = sum;
+				}
+		}
+		resize(MatrixTempStorage.data, data_index + resWords);
+		SP_MATRIX_PROFILE_END();
+	}
+
+	typedef T ValueType;
+	constexpr static bool UsesBuffer = true;
+
+	SP_CI ValueType operator [](size_t i) const noexcept{
+		return ((const T *)(beg(MatrixTempStorage.data) + data_index))[i];
+	}
+};
+
+template<class T>
+SP_CI size_t len(const VectorExprKronMultiply<T> &v) noexcept{ return v.size; }
+
+
+
 template<class V1, class V2>
 struct MatrixExprOuterProd{
 	static constexpr StupidMatrixFlagType MatrixFlag{};
@@ -205,6 +300,8 @@ struct MatrixExprOuterProd{
 	constexpr static bool RowMajor = false;
 	constexpr static bool UndefMajor = true;
 	constexpr static bool UsesBuffer = Arg1::UsesBuffer || Arg2::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::StaticLenOf<Arg1>;
+	constexpr static size_t StaticCols = priv__::StaticLenOf<Arg2>;
 
 	constexpr ValueType operator ()(size_t r, size_t c) const noexcept{
 		return arg1[r] * arg2[c];
@@ -235,6 +332,8 @@ struct MatrixExprOuterStatOp{
 	constexpr static bool RowMajor = false;
 	constexpr static bool UndefMajor = true;
 	constexpr static bool UsesBuffer = Arg1::UsesBuffer || Arg2::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::StaticLenOf<Arg1>;
+	constexpr static size_t StaticCols = priv__::StaticLenOf<Arg2>;
 
 	constexpr ValueType operator ()(size_t r, size_t c) const noexcept{ 
 		return Operation(arg1[r], arg2[c]);
@@ -272,6 +371,8 @@ struct MatrixExprOuterDynOp{
 	constexpr static bool RowMajor = false;
 	constexpr static bool UndefMajor = true;
 	constexpr static bool UsesBuffer = Arg1::UsesBuffer || Arg2::UsesBuffer;
+	constexpr static size_t StaticRows = priv__::StaticLenOf<Arg1>;
+	constexpr static size_t StaticCols = priv__::StaticLenOf<Arg2>;
 
 	constexpr ValueType operator ()(size_t r, size_t c) const noexcept{
 		return operation(arg1[r], arg2[c]);
@@ -296,67 +397,67 @@ SP_CI size_t len(const MatrixExprOuterDynOp<V1, V2, Operation> &m) noexcept{
 
 
 template<SP_VECTOR_T(V)>
-[[nodiscard]] auto as_col(V &&arg) noexcept{
+[[nodiscard]] constexpr auto as_col(V &&arg) noexcept{
 	return MatrixExprAsMatrix<CRemRRef<V>, true, false>{arg};
 }
 template<SP_VECTOR_T(V)>
-auto l_as_col(V &&arg) noexcept{
+constexpr auto l_as_col(V &&arg) noexcept{
 	return MatrixWrapper<MatrixExprAsMatrix<RemRRef<V>, true, true>>{{arg}};
 }
 
 template<SP_VECTOR_T(V)>
-[[nodiscard]] auto as_row(V &&arg) noexcept{
+[[nodiscard]] constexpr auto as_row(V &&arg) noexcept{
 	return MatrixExprAsMatrix<CRemRRef<V>, false, false>{arg};
 }
 template<SP_VECTOR_T(V)>
-auto l_as_row(V &&arg) noexcept{
+constexpr auto l_as_row(V &&arg) noexcept{
 	return MatrixWrapper<MatrixExprAsMatrix<RemRRef<V>, false, true>>{{arg}};
 }
 
 template<SP_VECTOR_T(V)>
-[[nodiscard]] auto as_diagonal(V &&arg) noexcept{
+[[nodiscard]] constexpr auto as_diagonal(V &&arg) noexcept{
 	return MatrixExprAsDiagonalMatrix<CRemRRef<V>, false>{arg};
 }
 template<SP_VECTOR_T(V)>
-auto l_as_diagonal(V &&arg) noexcept{
+constexpr auto l_as_diagonal(V &&arg) noexcept{
 	return MatrixWrapper<MatrixExprAsDiagonalMatrix<RemRRef<V>, true>>{{arg}};
 }
 
 template<SP_MATRIX_T(M)>
-[[nodiscard]] auto as_row(M &&arg, size_t rowIndex) noexcept{
+[[nodiscard]] constexpr auto as_row(M &&arg, size_t rowIndex) noexcept{
 	SP_MATRIX_ERROR(rowIndex >= rows(arg), "row index exceeds the scope matrix as vector reinterpretation");
 	return VectorExprAsRowVector<CRemRRef<M>, false>{arg, rowIndex};
 }
 template<SP_MATRIX_T(M)>
-auto l_as_row(M &&arg, size_t rowIndex) noexcept{
+constexpr auto l_as_row(M &&arg, size_t rowIndex) noexcept{
 	SP_MATRIX_ERROR(rowIndex >= rows(arg), "row index exceeds the scope matrix as vector reinterpretation");
 	return VectorWrapper<VectorExprAsRowVector<RemRRef<M>, true>>{{arg, rowIndex}};
 }
 
 template<SP_MATRIX_T(M)>
-[[nodiscard]] auto as_col(M &&arg, size_t columnIndex) noexcept{
+[[nodiscard]] constexpr auto as_col(M &&arg, size_t columnIndex) noexcept{
 	SP_MATRIX_ERROR(columnIndex >= rows(arg), "column index exceeds the scope matrix as vector reinterpretation");
 	return VectorExprAsColumnVector<CRemRRef<M>, false>{arg, columnIndex};
 }
 template<SP_MATRIX_T(M)>
-auto l_as_col(M &&arg, size_t columnIndex) noexcept{
+constexpr auto l_as_col(M &&arg, size_t columnIndex) noexcept{
 	SP_MATRIX_ERROR(columnIndex >= rows(arg), "column index exceeds the scope matrix as vector reinterpretation");
 	return VectorWrapper<VectorExprAsColumnVector<RemRRef<M>, true>>{{arg, columnIndex}};
 }
 
 
 template<SP_VECTOR_T(V1), SP_VECTOR_T(V2)>
-[[nodiscard]] auto outer_prod(V1 &&lhs, V2 &&rhs) noexcept{
+[[nodiscard]] constexpr auto outer_prod(V1 &&lhs, V2 &&rhs) noexcept{
 	return MatrixWrapper<MatrixExprOuterProd<CRemRRef<V1>, CRemRRef<V2>>>{{lhs, rhs}};
 }
 
 template<auto operation, SP_VECTOR_T(V1), SP_VECTOR_T(V2)>
-[[nodiscard]] auto outer_op(V1 &&lhs, V2 &&rhs) noexcept{
+[[nodiscard]] constexpr auto outer_op(V1 &&lhs, V2 &&rhs) noexcept{
 	return MatrixWrapper<MatrixExprOuterStatOp<CRemRRef<V1>, CRemRRef<V2>, operation>>{{lhs, rhs}};
 }
 
 template<SP_VECTOR_T(V1), SP_VECTOR_T(V2), class Operation>
-[[nodiscard]] auto outer_op(V1 &&lhs, V2 &&rhs, Operation &&operation) noexcept{
+[[nodiscard]] constexpr auto outer_op(V1 &&lhs, V2 &&rhs, Operation &&operation) noexcept{
 	return MatrixWrapper<MatrixExprOuterDynOp<CRemRRef<V1>, CRemRRef<V2>,
 			decltype((Operation &&)operation)>>{{
 				lhs, rhs, (Operation &&)operation
@@ -366,21 +467,29 @@ template<SP_VECTOR_T(V1), SP_VECTOR_T(V2), class Operation>
 
 
 template<SP_MATRIX_T(M), SP_VECTOR_T(V)>
-[[nodiscard]] auto operator *(M &&lhs, V &&rhs) noexcept{
+[[nodiscard]] constexpr auto operator *(M &&lhs, V &&rhs) noexcept{
 	SP_MATRIX_ERROR(cols(lhs) != len(rhs),
 		"vertically multipled vector must be of"
 		" the same size as number of columns of multiplicating matrix"
 	);
-	return VectorWrapper<VectorExprMatrixVertMultiply<CRemRRef<M>, CRemRRef<V>>>{{lhs, rhs}};
+	if constexpr (priv__::IsKron<std::decay_t<M>>)
+		return VectorWrapper<VectorExprKronMultiply<typename std::decay_t<M>::ValueType>>{{lhs.lhs, lhs.rhs, rhs}};
+	else
+		return VectorWrapper<VectorExprMatrixVertMultiply<CRemRRef<M>, CRemRRef<V>>>{{lhs, rhs}};
 }
 
 template<SP_VECTOR_T(V), SP_MATRIX_T(M)>
-[[nodiscard]] auto operator *(V &&lhs, M &&rhs) noexcept{
+[[nodiscard]] constexpr auto operator *(V &&lhs, M &&rhs) noexcept{
 	SP_MATRIX_ERROR(len(lhs) != rows(rhs),
 		"horizontally multipled vector must be of"
 		" the same size as number of columns of multiplicating matrix"
 	);
-	return VectorWrapper<VectorExprMatrixHoriMultiply<CRemRRef<V>, CRemRRef<M>>>{{lhs, rhs}};
+	if constexpr (priv__::IsKron<std::decay_t<M>>)	// x*(A (x) B) = (tr(A) (x) tr(B))*x
+		return VectorWrapper<VectorExprKronMultiply<typename std::decay_t<M>::ValueType>>{{
+			tr(rhs.lhs), tr(rhs.rhs), lhs
+		}};
+	else
+		return VectorWrapper<VectorExprMatrixHoriMultiply<CRemRRef<V>, CRemRRef<M>>>{{lhs, rhs}};
 }
 
 
@@ -9,6 +9,10 @@ namespace sp{
 
 template<SP_VECTOR_T(V1), SP_MATRIX_T(M), class Cont, SP_VECTOR_T(V2)>
 void lup_solve(V1 &&dest, M &&LU, const Cont permuts, V2 &&A) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"lup_solve", 2.0*rows(LU)*cols(LU),
+		(rows(LU)*cols(LU) + 2*len(A))*sizeof(typename std::decay_t<V1>::ValueType)
+	);
 	SP_MATRIX_ERROR(
 		rows(LU) != cols(LU),
 		"only square matrix can be used as set of linear equations"
@@ -27,7 +31,7 @@ void lup_solve(V1 &&dest, M &&LU, const Cont permuts, V2 &&A) noexcept{
 			dest[i] -= LU(i, j) * dest[j];
 	}
 
-	for (size_t i=length+1; i!=(size_t)-1; --i) {
+	for (size_t i=length-1; i!=(size_t)-1; --i){
 		typename std::decay_t<M>::ValueType factor = (
 			(typename std::decay_t<M>::ValueType)1 / LU(i, i)
 		);
@@ -36,83 +40,104 @@ void lup_solve(V1 &&dest, M &&LU, const Cont permuts, V2 &&A) noexcept{
 
 		dest[i] *= factor;
 	}
+	SP_MATRIX_PROFILE_END();
 }
 
 
-template<SP_VECTOR_T(V), SP_MATRIX_T(M)>
-void lin_solve(V &&dest, M &&A) noexcept{
-	SP_MATRIX_ERROR(rows(A) != cols(A), "only square matrix can hold a linear equations");
-	size_t length= rows(A);
+namespace priv__{
 
-	size_t oldSize = len(MatrixTempStorage.data);
-	expand_back(
-		MatrixTempStorage.data,
-		(length*length * sizeof(typename std::decay_t<V>::ValueType) + 7) / 8
-	);
-	size_t permutsIndex = len(MatrixTempStorage.data);
-	expand_back(MatrixTempStorage.data, (length* sizeof(uint32_t) + 7) / 8);
-	typename std::decay_t<V>::ValueType *TempStorage = (
-		(typename std::decay_t<V>::ValueType *)(
-			beg(MatrixTempStorage.data) + oldSize
-		)
-	);
-	uint32_t *permuts = (uint32_t *)(
-		beg(MatrixTempStorage.data) + permutsIndex
-	);
+template<class V, class M>
+void exact_lin_solve(V &dest, M &&A) noexcept{
+	typedef typename std::decay_t<V>::ValueType VT;
+	typedef typename ExactBase<VT>::Type T;
+	typedef std::make_unsigned_t<T> UnsT;
+	size_t length = rows(A);
+	size_t width = length + 1;
 
-	for (size_t i=0; i!=length; ++i) permuts[i] = i;
-	{
-		typename std::decay_t<M>::ValueType *I = TempStorage;
-		for (size_t i=0; i!=length; ++i)
-			for (size_t j=0; j!=length; ++j, ++I)
-				*I = A(i, j);
-	}
+	size_t oldSize = len(MatrixTempStorage.data);
+	expand_back(MatrixTempStorage.data, ((length*width + length) * sizeof(T) + 7) / 8);
+	T *TempStorage = (T *)(beg(MatrixTempStorage.data) + oldSize);
+	T *scales = TempStorage + length*width;
 
+	load_exact(TempStorage, width, A, scales);
 	for (size_t i=0; i!=length; ++i){
-		{
-			size_t j = i;
-			for (size_t k=i+1; k!=length; ++k)	// find row with max value
-				j = abs(TempStorage[k*length+i])>abs(TempStorage[j*length+i]) ? k : j;
-			if (j != i){
-				for (size_t k=0; k!=length; ++k)	// exchange top row with row with max value
-					std::swap(TempStorage[i*length+k], TempStorage[j*length+k]);
-				std::swap(permuts[i], permuts[j]);
-			}
-		}
-		typename std::decay_t<M>::ValueType factor1 = TempStorage[i*(length+1)];
-		for (size_t j=i+1; j!=length; ++j){
-			typename std::decay_t<M>::ValueType factor2 = TempStorage[j*length+i] / factor1;
-			TempStorage[j*length+i] = factor2;
-			for (size_t k=i+1; k!=length; ++k)
-				TempStorage[j*length+k] -= TempStorage[i*length+k] * factor2;
+		if constexpr (IsRational<VT>){	// clear the denominator of right hand side too
+			T divider = (T)gcd((UnsT)scales[i], (UnsT)abs(dest[i].den));
+			T factor = dest[i].den / divider;
+			for (size_t j=0; j!=length; ++j) TempStorage[i*width+j] *= factor;
+			TempStorage[i*width+length] = dest[i].nom * (scales[i] / divider);
+		} else{
+			TempStorage[i*width+length] = (T)dest[i];
 		}
 	}
 
-	resize(dest, length, length);
-	for (size_t i=0; i!=length; ++i){
-		for (size_t j=0; j!=length; ++j){
-			dest(j, i) = (
-				permuts[j]==i ?
-					(typename std::decay_t<V>::ValueType)1 :
-					(typename std::decay_t<V>::ValueType)0
-			);
-
-			for (size_t k=0; k!=j; ++k)
-				dest(j, i) -= TempStorage[j*length+k] * dest(k, i);
+	bool odd;
+	T det = bareiss_gauss_jordan(TempStorage, length, width, odd);
+	SP_MATRIX_ERROR(det == (T)0, "singular set of linear equations has no unique solution");
+	for (size_t i=0; i!=length; ++i)
+		dest[i] = make_exact<VT>(TempStorage[i*width+length], det);
+
+	resize(MatrixTempStorage.data, oldSize);
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+// right hand side is taken from the destination vector
+template<SP_VECTOR_T(V), SP_MATRIX_T(M)>
+void lin_solve(V &&dest, M &&A) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"lin_solve", 2.0/3.0*rows(A)*rows(A)*rows(A) + 2.0*rows(A)*rows(A),
+		(rows(A)*cols(A) + 2*len(dest))*sizeof(typename std::decay_t<V>::ValueType)
+	);
+	SP_MATRIX_ERROR(rows(A) != cols(A), "only square matrix can hold a linear equations");
+	SP_MATRIX_ERROR(rows(A) != len(dest), "vector's size must be equal to number of rows of the matrix");
+	typedef typename std::decay_t<V>::ValueType T;
+	size_t length= rows(A);
+
+	if constexpr (IsExact<T>){
+		priv__::exact_lin_solve(dest, A);
+	} else{
+		size_t oldSize = len(MatrixTempStorage.data);
+		expand_back(MatrixTempStorage.data, ((length*length + length) * sizeof(T) + 7) / 8);
+		T *TempStorage = (T *)(beg(MatrixTempStorage.data) + oldSize);
+		T *rhs = TempStorage + length*length;
+
+		for (size_t i=0; i!=length; ++i){
+			rhs[i] = dest[i];
+			for (size_t j=0; j!=length; ++j)
+				TempStorage[i*length+j] = A(i, j);
 		}
 
-		for (size_t j=length+1; j!=(size_t)-1; --j) {
-			typename std::decay_t<M>::ValueType factor = (
-				(typename std::decay_t<M>::ValueType)1 / TempStorage[j*(length+1)]
-			);
-			for (size_t k = j+1; k!=length; ++k)
-				dest(j, i) -= TempStorage[j*length+k] * dest(k, i);
+		for (size_t i=0; i!=length; ++i){
+			{
+				size_t j = i;
+				for (size_t k=i+1; k!=length; ++k)	// find row with max value
+					j = abs(TempStorage[k*length+i])>abs(TempStorage[j*length+i]) ? k : j;
+				if (j != i){
+					for (size_t k=i; k!=length; ++k)	// exchange top row with row with max value
+						swap(TempStorage[i*length+k], TempStorage[j*length+k]);
+					swap(rhs[i], rhs[j]);
+				}
+			}
+			T factor1 = TempStorage[i*(length+1)];
+			for (size_t j=i+1; j!=length; ++j){
+				T factor2 = TempStorage[j*length+i] / factor1;
+				for (size_t k=i+1; k!=length; ++k)
+					TempStorage[j*length+k] -= TempStorage[i*length+k] * factor2;
+				rhs[j] -= rhs[i] * factor2;
+			}
+		}
 
-			dest(j, i) *= factor;
+		for (size_t i=length-1; i!=(size_t)-1; --i){
+			T val = rhs[i];
+			for (size_t j=i+1; j!=length; ++j)
+				val -= TempStorage[i*length+j] * dest[j];
+			dest[i] = val / TempStorage[i*(length+1)];
 		}
-	}
 
-	resize(MatrixTempStorage.data, oldSize);
+		resize(MatrixTempStorage.data, oldSize);
+	}
+	SP_MATRIX_PROFILE_END();
 }
 
 
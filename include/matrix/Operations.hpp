@@ -1,59 +1,170 @@
 #pragma once
 
 #include "Expr.hpp"
+#include <math.h>
+#include <string.h>
+#include <thread>
+#include <limits>
 
 
 namespace sp{
 
+constexpr size_t MaxThreadCount = 256;
+constexpr size_t ParallelGrain = 1 << 16;	// minimal number of elements given to a thread
+
+namespace priv__{
+
+template<class M, class = void>
+constexpr bool HasLeadDim = false;
+
+template<class M>
+constexpr bool HasLeadDim<M, std::void_t<decltype(lead_dim(std::declval<const M &>()))>> = true;
+
+// runs the procedure for [begin, end) ranges covering [0, size) on specified number of threads,
+// the last range is run on calling thread, every line of range has specified number of elements
+// returns the number of threads used, which is capped so every thread gets ParallelGrain elements
+template<class F>
+size_t run_parallel(size_t size, size_t lineLen, size_t threadCount, F &&f) noexcept{
+	if (!threadCount) threadCount = std::thread::hardware_concurrency();
+	if (threadCount > MaxThreadCount) threadCount = MaxThreadCount;
+	if (threadCount > size*lineLen / ParallelGrain) threadCount = size*lineLen / ParallelGrain;
+	if (threadCount < 2){
+		f((size_t)0, size);
+		return 1;
+	}
+	std::thread threads[MaxThreadCount];
+	size_t step = size / threadCount;
+	size_t extra = size % threadCount;
+	size_t begin = 0;
+	for (size_t t=0; t!=threadCount-1; ++t){
+		size_t end = begin + step + (t < extra);
+		threads[t] = std::thread([&f, begin, end](){ f(begin, end); });
+		begin = end;
+	}
+	f(begin, size);
+	for (size_t t=0; t!=threadCount-1; ++t) threads[t].join();
+	return threadCount;
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+// evaluates the expression into destination matrix on specified number of threads (all hardware
+// threads when zero), every thread gets a band of rows (columns for column major destination),
+// the expression shouldn't have side effects, generators like random_uniform are indexed by
+// position, so the result doesn't depend on the number of threads, returns the number of threads used
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2)>
+size_t par_assign(M1 &&dest, M2 &&src, size_t threadCount = 0) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"par_assign", 0,
+		rows(src)*cols(src)*sizeof(typename std::decay_t<M1>::ValueType)
+	);
+	typedef std::decay_t<M1> D;
+	typedef std::decay_t<M2> S;
+	static_assert(!S::UsesBuffer, "expression using temporary storage cannot be evaluated in parallel");
+	resize(dest, rows(src), cols(src));
+	size_t used;
+	if constexpr (D::RowMajor){
+		used = priv__::run_parallel(rows(dest), cols(dest), threadCount, [&](size_t begin, size_t end){
+			priv__::traverse<D, S>(end-begin, cols(dest), [&](size_t i, size_t j){
+				dest(begin+i, j) = src(begin+i, j);
+			});
+		});
+	} else{
+		used = priv__::run_parallel(cols(dest), rows(dest), threadCount, [&](size_t begin, size_t end){
+			priv__::traverse<D, S>(rows(dest), end-begin, [&](size_t i, size_t j){
+				dest(i, begin+j) = src(i, begin+j);
+			});
+		});
+	}
+	SP_MATRIX_PROFILE_END();
+	return used;
+}
+
+// evaluates the expression into destination vector on specified number of threads, returns the
+// number of threads used
+template<SP_VECTOR_T(V1), SP_VECTOR_T(V2)>
+size_t par_assign(V1 &&dest, V2 &&src, size_t threadCount = 0) noexcept{
+	SP_MATRIX_PROFILE_BEGIN("par_assign", 0, len(src)*sizeof(typename std::decay_t<V1>::ValueType));
+	static_assert(
+		!std::decay_t<V2>::UsesBuffer, "expression using temporary storage cannot be evaluated in parallel"
+	);
+	resize(dest, len(src));
+	size_t used = priv__::run_parallel(len(dest), 1, threadCount, [&](size_t begin, size_t end){
+		for (size_t i=begin; i!=end; ++i) dest[i] = src[i];
+	});
+	SP_MATRIX_PROFILE_END();
+	return used;
+}
+
+
+
 template<SP_MATRIX_T(M1), SP_MATRIX_T(M2)>
 void transpose(M1 &&dest, M2 &&A) noexcept{
-	resize(dest, A.cols(), A.rows());
-	size_t blockSize = CacheBlockLen / sizeof(A(0, 0));
+	SP_MATRIX_PROFILE_BEGIN(
+		"transpose", 0,
+		2*rows(A)*cols(A)*sizeof(typename std::decay_t<M1>::ValueType)
+	);
+	resize(dest, cols(A), rows(A));
+	const size_t blockSize = traverse_block_len<typename std::decay_t<M1>::ValueType>();
 	
-	for (size_t i=0; i<rows(dest); i+=blockSize)
-		for (size_t j=0; j<cols(dest); j+=blockSize)
-			for (size_t ii=i; ii<i+blockSize; ++ii)
-				for (size_t jj=j; jj<j+blockSize; ++jj)
+	for (size_t i=0; i<rows(dest); i+=blockSize){
+		size_t iEnd = min(i+blockSize, rows(dest));
+		for (size_t j=0; j<cols(dest); j+=blockSize){
+			size_t jEnd = min(j+blockSize, cols(dest));
+			for (size_t ii=i; ii!=iEnd; ++ii)
+				for (size_t jj=j; jj!=jEnd; ++jj)
 					dest(ii, jj) = A(jj, ii);
+		}
+	}
+	SP_MATRIX_PROFILE_END();
+}
+
+namespace priv__{
+
+// writes the kronecker product line by line of the destination, so the output is streamed in
+// the order of memory, every line reads one line of both operands
+template<class M1, class M2, class M3, class F>
+void kron_write(M1 &dest, const M2 &A, const M3 &B, F &&f) noexcept{
+	size_t m = rows(A), n = cols(A), p = rows(B), q = cols(B);
+	resize(dest, m*p, n*q);
+
+	if constexpr (std::decay_t<M1>::RowMajor){
+		for (size_t i=0; i!=m; ++i)
+			for (size_t k=0; k!=p; ++k)
+				for (size_t j=0; j!=n; ++j){
+					auto a = A(i, j);
+					for (size_t l=0; l!=q; ++l) dest(i*p+k, j*q+l) = f(a, B(k, l));
+				}
+	} else{
+		for (size_t j=0; j!=n; ++j)
+			for (size_t l=0; l!=q; ++l)
+				for (size_t i=0; i!=m; ++i){
+					auto a = A(i, j);
+					for (size_t k=0; k!=p; ++k) dest(i*p+k, j*q+l) = f(a, B(k, l));
+				}
+	}
 }
 
+} // END OF NAMESPACE PRIV //////////
+
 template<SP_MATRIX_T(M1), SP_MATRIX_T(M2), SP_MATRIX_T(M3)>
 void kron_product(M1 &&dest, M2 &&A, M3 &&B) noexcept{
-	resize(dest, A.rows()*B.rows(), A.cols()*B.cols());
-	
-	for (size_t i=0; i!=rows(A); ++i)
-		for (size_t j=0; j!=cols(A); ++j){
-			typename std::decay_t<M2>::ValueType tempVal = A(i, j);
-			for (size_t k=0; k!=rows(B); ++k)
-				for (size_t l=0; l!=cols(B); ++l)
-					dest(i*rows(B)+k, j*cols(B)+l) = tempVal * B(k, l);
-		}
+	SP_MATRIX_PROFILE_BEGIN(
+		"kron_product", rows(A)*cols(A)*rows(B)*cols(B),
+		(rows(A)*cols(A) + rows(B)*cols(B) + rows(A)*cols(A)*rows(B)*cols(B))*sizeof(typename std::decay_t<M1>::ValueType)
+	);
+	priv__::kron_write(dest, A, B, [](const auto &a, const auto &b){ return a * b; });
+	SP_MATRIX_PROFILE_END();
 }
 
 template<auto operation, SP_MATRIX_T(M1), SP_MATRIX_T(M2), SP_MATRIX_T(B3)>
 void kron_apply(M1 &&dest, M2 &&A, B3 &&B) noexcept{
-	resize(dest, A.rows()*B.rows(), A.cols()*B.cols());
-	
-	for (size_t i=0; i!=rows(A); ++i)
-		for (size_t j=0; j!=cols(A); ++j){
-			typename std::decay_t<M2>::ValueType tempVal = A(i, j);
-			for (size_t k=0; k!=rows(B); ++k)
-				for (size_t l=0; l!=cols(B); ++l)
-					dest(i*rows(B)+k, j*cols(B)+l) = operation(tempVal, B(k, l));
-		}
+	priv__::kron_write(dest, A, B, [](const auto &a, const auto &b){ return operation(a, b); });
 }
 
 template<SP_MATRIX_T(M1), SP_MATRIX_T(M2), SP_MATRIX_T(M3), class Operation>
 void kron_apply(M1 &&dest, M2 &&A, M3 &&B, Operation &&operation) noexcept{
-	resize(dest, A.rows()*B.rows(), A.cols()*B.cols());
-	
-	for (size_t i=0; i!=rows(A); ++i)
-		for (size_t j=0; j!=cols(A); ++j){
-			typename std::decay_t<M2>::ValueType tempVal = A(i, j);
-			for (size_t k=0; k!=rows(B); ++k)
-				for (size_t l=0; l!=cols(B); ++l)
-					dest(i*rows(B)+k, j*cols(B)+l) = operation(tempVal, B(k, l));
-		}
+	priv__::kron_write(dest, A, B, operation);
 }
 
 
@@ -94,8 +205,441 @@ void add_cols(M &&dest, size_t colDest, size_t colSrc,
 }
 
 
+// dest must not alias any of the arguments
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2), SP_MATRIX_T(M3)>
+void mat_mul(M1 &&dest, M2 &&A, M3 &&B) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"mat_mul", 2.0*rows(A)*cols(A)*cols(B),
+		(rows(A)*cols(A) + rows(B)*cols(B) + rows(A)*cols(B))*sizeof(typename std::decay_t<M1>::ValueType)
+	);
+	SP_MATRIX_ERROR(cols(A) != rows(B), "multiplied matrices must have matching inner dimensions");
+	typedef typename std::decay_t<M1>::ValueType T;
+	const size_t blockSize = mul_block_len<T>();
+	size_t m = rows(A), k = cols(A), n = cols(B);
+
+	resize(dest, m, n);
+	for (size_t i=0; i!=m; ++i)
+		for (size_t j=0; j!=n; ++j)
+			dest(i, j) = T{};
+
+	for (size_t ii=0; ii<m; ii+=blockSize)
+		for (size_t pp=0; pp<k; pp+=blockSize)
+			for (size_t jj=0; jj<n; jj+=blockSize){
+				size_t iEnd = min(ii+blockSize, m);
+				size_t pEnd = min(pp+blockSize, k);
+				size_t jEnd = min(jj+blockSize, n);
+				if constexpr (std::decay_t<M1>::RowMajor){
+					for (size_t i=ii; i!=iEnd; ++i)
+						for (size_t p=pp; p!=pEnd; ++p){
+							T a = A(i, p);
+							for (size_t j=jj; j!=jEnd; ++j)
+								dest(i, j) += a * B(p, j);
+						}
+				} else{
+					for (size_t j=jj; j!=jEnd; ++j)
+						for (size_t p=pp; p!=pEnd; ++p){
+							T b = B(p, j);
+							for (size_t i=ii; i!=iEnd; ++i)
+								dest(i, j) += A(i, p) * b;
+						}
+				}
+			}
+	SP_MATRIX_PROFILE_END();
+}
+
+
+
+namespace priv__{
+
+// C += alpha*A*B for row major blocks with given leading dimensions
+template<class T>
+void gemm_acc(
+	T *C, size_t ldc, const T *A, size_t lda, const T *B, size_t ldb, size_t m, size_t k, size_t n,
+	T alpha = unit<T>()
+) noexcept{
+	const size_t blockSize = mul_block_len<T>();
+	for (size_t ii=0; ii<m; ii+=blockSize)
+		for (size_t pp=0; pp<k; pp+=blockSize)
+			for (size_t jj=0; jj<n; jj+=blockSize){
+				size_t iEnd = min(ii+blockSize, m);
+				size_t pEnd = min(pp+blockSize, k);
+				size_t jEnd = min(jj+blockSize, n);
+				for (size_t i=ii; i!=iEnd; ++i)
+					for (size_t p=pp; p!=pEnd; ++p){
+						T a = alpha * A[i*lda+p];
+						for (size_t j=jj; j!=jEnd; ++j)
+							C[i*ldc+j] += a * B[p*ldb+j];
+					}
+			}
+}
+
+// C = A*B for row major blocks with given leading dimensions
+template<class T>
+void gemm_block(
+	T *C, size_t ldc, const T *A, size_t lda, const T *B, size_t ldb, size_t m, size_t k, size_t n
+) noexcept{
+	for (size_t i=0; i!=m; ++i)
+		for (size_t j=0; j!=n; ++j)
+			C[i*ldc+j] = T{};
+	gemm_acc(C, ldc, A, lda, B, ldb, m, k, n);
+}
+
+template<class T>
+void block_add(T *D, size_t ldd, const T *P, size_t ldp, const T *Q, size_t ldq, size_t n) noexcept{
+	for (size_t i=0; i!=n; ++i)
+		for (size_t j=0; j!=n; ++j)
+			D[i*ldd+j] = P[i*ldp+j] + Q[i*ldq+j];
+}
+
+template<class T>
+void block_sub(T *D, size_t ldd, const T *P, size_t ldp, const T *Q, size_t ldq, size_t n) noexcept{
+	for (size_t i=0; i!=n; ++i)
+		for (size_t j=0; j!=n; ++j)
+			D[i*ldd+j] = P[i*ldp+j] - Q[i*ldq+j];
+}
+
+// winograd variant with two temporaries per level, the schedule of douglas et al. (1994)
+template<class T>
+void strassen_rec(
+	T *C, size_t ldc, const T *A, size_t lda, const T *B, size_t ldb,
+	size_t n, T *scratch, size_t crossover
+) noexcept{
+	if (n <= crossover){
+		gemm_block(C, ldc, A, lda, B, ldb, n, n, n);
+		return;
+	}
+	size_t h = n / 2;
+	const T *A11 = A, *A12 = A + h, *A21 = A + h*lda, *A22 = A + h*lda + h;
+	const T *B11 = B, *B12 = B + h, *B21 = B + h*ldb, *B22 = B + h*ldb + h;
+	T *C11 = C, *C12 = C + h, *C21 = C + h*ldc, *C22 = C + h*ldc + h;
+	T *X = scratch;
+	T *Y = scratch + h*h;
+	T *next = scratch + 2*h*h;
+
+	block_sub(X, h, A11, lda, A21, lda, h);                     // S3 = A11 - A21
+	block_sub(Y, h, B22, ldb, B12, ldb, h);                     // T3 = B22 - B12
+	strassen_rec(C21, ldc, X, h, Y, h, h, next, crossover);     // P7 = S3*T3
+	block_add(X, h, A21, lda, A22, lda, h);                     // S1 = A21 + A22
+	block_sub(Y, h, B12, ldb, B11, ldb, h);                     // T1 = B12 - B11
+	strassen_rec(C22, ldc, X, h, Y, h, h, next, crossover);     // P5 = S1*T1
+	block_sub(X, h, X, h, A11, lda, h);                         // S2 = S1 - A11
+	block_sub(Y, h, B22, ldb, Y, h, h);                         // T2 = B22 - T1
+	strassen_rec(C12, ldc, X, h, Y, h, h, next, crossover);     // P6 = S2*T2
+	block_sub(X, h, A12, lda, X, h, h);                         // S4 = A12 - S2
+	strassen_rec(C11, ldc, X, h, B22, ldb, h, next, crossover); // P3 = S4*B22
+	strassen_rec(X, h, A11, lda, B11, ldb, h, next, crossover); // P1 = A11*B11
+	block_add(C12, ldc, X, h, C12, ldc, h);                     // U2 = P1 + P6
+	block_add(C21, ldc, C12, ldc, C21, ldc, h);                 // U3 = U2 + P7
+	block_add(C12, ldc, C12, ldc, C22, ldc, h);                 // U4 = U2 + P5
+	block_add(C22, ldc, C21, ldc, C22, ldc, h);                 // U7 = U3 + P5
+	block_add(C12, ldc, C12, ldc, C11, ldc, h);                 // U5 = U4 + P3
+	block_sub(Y, h, Y, h, B21, ldb, h);                         // T4 = T2 - B21
+	strassen_rec(C11, ldc, A22, lda, Y, h, h, next, crossover); // P4 = A22*T4
+	block_sub(C21, ldc, C21, ldc, C11, ldc, h);                 // U6 = U3 - P4
+	strassen_rec(C11, ldc, A12, lda, B21, ldb, h, next, crossover); // P2 = A12*B21
+	block_add(C11, ldc, X, h, C11, ldc, h);                     // U1 = P1 + P2
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+// strassen-winograd product, every level of recursion needs 7 half sized products and 15
+// additions, blocks not larger than crossover are multiplied by the conventional kernel
+// the matrices are zero padded to size m*2^d, where m <= crossover, scratch of about
+// (3 + 2/3)*(m*2^d)^2 elements is taken from the allocator as a single block
+// returns true if the allocation failed, dest must not alias any of the arguments
+//
+// error bound (higham, accuracy and stability of numerical algorithms, sec. 23.2.3), for n x n
+// matrices with recursion stopping at size n0 and u being the unit roundoff:
+//   max|C - fl(C)| <= ((n/n0)^log2(18) * (n0*n0 + 6*n0) - 6*n) * u * max|A| * max|B| + O(u^2)
+// the bound is only normwise, unlike componentwise n*u*|A|*|B| of conventional product, so
+// elements much smaller than the norm of the result can lose all of their relative accuracy
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2), SP_MATRIX_T(M3), class Al>
+bool strassen_mul(
+	M1 &&dest, M2 &&A, M3 &&B, Al &allocator, size_t crossover = StrassenCrossover
+) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"strassen_mul", 2.0*rows(A)*cols(A)*cols(B),
+		(rows(A)*cols(A) + rows(B)*cols(B) + rows(A)*cols(B))*sizeof(typename std::decay_t<M1>::ValueType)
+	);
+	SP_MATRIX_ERROR(cols(A) != rows(B), "multiplied matrices must have matching inner dimensions");
+	SP_MATRIX_ERROR(crossover == 0, "crossover size must be positive");
+	typedef typename std::decay_t<M1>::ValueType T;
+	size_t m = rows(A), k = cols(A), n = cols(B);
+	size_t maxLen = max(max(m, k), n);
+
+	size_t base = maxLen;
+	size_t levels = 0;
+	while (base > crossover){
+		base = (base + 1) / 2;
+		++levels;
+	}
+	if (levels == 0){
+		mat_mul(dest, A, B);
+		SP_MATRIX_PROFILE_END();
+		return false;
+	}
+	size_t padded = base << levels;
+
+	size_t scratchLen = 0;
+	for (size_t s=padded; s>base; s/=2) scratchLen += 2 * (s/2)*(s/2);
+	size_t totalLen = 3*padded*padded + scratchLen;
+
+	Memblock blk;
+	if constexpr (Al::Alignment)
+		blk = alloc(allocator, totalLen * sizeof(T));
+	else
+		blk = alloc(allocator, totalLen * sizeof(T), alignof(T));
+	if (blk.ptr == nullptr){
+		SP_MATRIX_PROFILE_END();
+		return true;
+	}
+
+	T *padA = (T *)blk.ptr;
+	T *padB = padA + padded*padded;
+	T *padC = padB + padded*padded;
+	T *scratch = padC + padded*padded;
+
+	for (size_t i=0; i!=padded; ++i)
+		for (size_t j=0; j!=padded; ++j){
+			padA[i*padded+j] = i<m && j<k ? (T)A(i, j) : T{};
+			padB[i*padded+j] = i<k && j<n ? (T)B(i, j) : T{};
+		}
+
+	priv__::strassen_rec(padC, padded, padA, padded, padB, padded, padded, scratch, base);
+
+	resize(dest, m, n);
+	for (size_t i=0; i!=m; ++i)
+		for (size_t j=0; j!=n; ++j)
+			dest(i, j) = padC[i*padded+j];
+
+	free(allocator, blk);
+	SP_MATRIX_PROFILE_END();
+	return false;
+}
+
+
+
+// puts A^power into the destination matrix by binary exponentiation, the products are done by
+// blocked kernel ping-ponging between buffers taken once from temporary storage
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2)>
+void mat_pow(M1 &&dest, M2 &&A, size_t power) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"mat_pow", 0,
+		2*rows(A)*cols(A)*sizeof(typename std::decay_t<M1>::ValueType)
+	);
+	SP_MATRIX_ERROR(rows(A) != cols(A), "only square matrix can be raised to a power");
+	typedef typename std::decay_t<M1>::ValueType T;
+	size_t n = rows(A);
+
+	size_t oldSize = len(MatrixTempStorage.data);
+	expand_back(MatrixTempStorage.data, (3*n*n * sizeof(T) + 7) / 8);
+	T *base = (T *)(beg(MatrixTempStorage.data) + oldSize);
+	T *res = base + n*n;
+	T *temp = res + n*n;
+
+	for (size_t i=0; i!=n; ++i)
+		for (size_t j=0; j!=n; ++j)
+			base[i*n + j] = (T)A(i, j);
+
+	bool started = false;
+	for (; power; power>>=1){
+		if (power & 1){
+			if (started){
+				priv__::gemm_block(temp, n, res, n, base, n, n, n, n);
+				SP_MATRIX_PROFILE_FLOPS(2.0*n*n*n);
+				T *t = res; res = temp; temp = t;
+			} else{
+				for (size_t i=0; i!=n*n; ++i) res[i] = base[i];
+				started = true;
+			}
+		}
+		if (power > 1){
+			priv__::gemm_block(temp, n, base, n, base, n, n, n, n);
+			SP_MATRIX_PROFILE_FLOPS(2.0*n*n*n);
+			T *t = base; base = temp; temp = t;
+		}
+	}
+
+	resize(dest, n, n);
+	for (size_t i=0; i!=n; ++i)
+		for (size_t j=0; j!=n; ++j)
+			dest(i, j) = started ? res[i*n + j] : (i == j ? unit<T>() : T{});
+
+	resize(MatrixTempStorage.data, oldSize);
+	SP_MATRIX_PROFILE_END();
+}
+
+
+
+namespace priv__{
+
+// solves A*X = B for row major n x n blocks by gaussian elimination with partial pivoting,
+// A is destroyed and X is put into B
+template<class T>
+void block_solve(T *A, T *B, size_t n) noexcept{
+	for (size_t k=0; k!=n; ++k){
+		size_t pivot = k;
+		for (size_t i=k+1; i!=n; ++i)
+			if (abs(A[i*n + k]) > abs(A[pivot*n + k])) pivot = i;
+		if (pivot != k)
+			for (size_t j=0; j!=n; ++j){
+				swap(A[k*n + j], A[pivot*n + j]);
+				swap(B[k*n + j], B[pivot*n + j]);
+			}
+		T inv = (T)1 / A[k*n + k];
+		for (size_t i=k+1; i!=n; ++i){
+			T f = A[i*n + k] * inv;
+			if (f == (T)0) continue;
+			for (size_t j=k+1; j!=n; ++j) A[i*n + j] -= f * A[k*n + j];
+			for (size_t j=0; j!=n; ++j) B[i*n + j] -= f * B[k*n + j];
+		}
+	}
+	for (size_t k=n-1; k!=(size_t)-1; --k){
+		T inv = (T)1 / A[k*n + k];
+		for (size_t j=0; j!=n; ++j) B[k*n + j] *= inv;
+		for (size_t i=0; i!=k; ++i){
+			T f = A[i*n + k];
+			if (f == (T)0) continue;
+			for (size_t j=0; j!=n; ++j) B[i*n + j] -= f * B[k*n + j];
+		}
+	}
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+// puts the exponential of matrix into the destination matrix, uses [m/m] pade approximant with
+// m in {3, 5, 7, 9, 13} chosen from the 1-norm and scaling and squaring when m = 13 isn't
+// enough (higham, the scaling and squaring method for the matrix exponential revisited, 2005),
+// all products are done by blocked kernel on buffers taken once from temporary storage
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2)>
+void expm(M1 &&dest, M2 &&A) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"expm", 0,
+		2*rows(A)*cols(A)*sizeof(typename std::decay_t<M1>::ValueType)
+	);
+	SP_MATRIX_ERROR(rows(A) != cols(A), "only exponential of square matrix can be computed");
+	typedef typename std::decay_t<M1>::ValueType T;
+	constexpr double Theta[] = {
+		1.495585217958292e-2, 2.539398330063230e-1, 9.504178996162932e-1,
+		2.097847961257068e0, 5.371920351148152e0
+	};
+	constexpr double Coefs[][14] = {
+		{120.0, 60.0, 12.0, 1.0},
+		{30240.0, 15120.0, 3360.0, 420.0, 30.0, 1.0},
+		{17297280.0, 8648640.0, 1995840.0, 277200.0, 25200.0, 1512.0, 56.0, 1.0},
+		{
+			17643225600.0, 8821612800.0, 2075673600.0, 302702400.0, 30270240.0,
+			2162160.0, 110880.0, 3960.0, 90.0, 1.0
+		},
+		{
+			64764752532480000.0, 32382376266240000.0, 7771770303897600.0,
+			1187353796428800.0, 129060195264000.0, 10559470521600.0, 670442572800.0,
+			33522128640.0, 1323241920.0, 40840800.0, 960960.0, 16380.0, 182.0, 1.0
+		}
+	};
+	size_t n = rows(A);
+
+	size_t oldSize = len(MatrixTempStorage.data);
+	expand_back(MatrixTempStorage.data, (7*n*n * sizeof(T) + 7) / 8);
+	T *X = (T *)(beg(MatrixTempStorage.data) + oldSize);
+	T *P[4] = {X + n*n, X + 2*n*n, X + 3*n*n, X + 4*n*n};	// A^2, A^4, A^6, A^8
+	T *U = X + 5*n*n;
+	T *V = X + 6*n*n;
+
+	double norm = 0.0;
+	for (size_t j=0; j!=n; ++j){
+		double sum = 0.0;
+		for (size_t i=0; i!=n; ++i) sum += (double)abs((T)A(i, j));
+		if (sum > norm) norm = sum;
+	}
+	size_t degree = 0;
+	while (degree != 4 && norm > Theta[degree]) ++degree;
+	size_t squarings = 0;
+	if (norm > Theta[4]) squarings = (size_t)ceil(log2(norm / Theta[4]));
+	T scale = (T)ldexp(1.0, -(int32_t)squarings);
+	SP_MATRIX_PROFILE_FLOPS(2.0*n*n*n*((degree == 4 ? 6 : degree+2) + squarings) + 8.0/3.0*n*n*n);
+
+	for (size_t i=0; i!=n; ++i)
+		for (size_t j=0; j!=n; ++j)
+			X[i*n + j] = (T)A(i, j) * scale;
+	const double *b = Coefs[degree];
+
+	priv__::gemm_block(P[0], n, X, n, X, n, n, n, n);
+	if (degree == 4){
+		T *A2 = P[0], *A4 = P[1], *A6 = P[2];
+		priv__::gemm_block(A4, n, A2, n, A2, n, n, n, n);
+		priv__::gemm_block(A6, n, A4, n, A2, n, n, n, n);
+		// U = A*(A6*(b13*A6 + b11*A4 + b9*A2) + b7*A6 + b5*A4 + b3*A2 + b1*I)
+		// V = A6*(b12*A6 + b10*A4 + b8*A2) + b6*A6 + b4*A4 + b2*A2 + b0*I
+		T *W = P[3];
+		for (size_t i=0; i!=n*n; ++i)
+			W[i] = (T)b[13]*A6[i] + (T)b[11]*A4[i] + (T)b[9]*A2[i];
+		priv__::gemm_block(V, n, A6, n, W, n, n, n, n);
+		for (size_t i=0; i!=n*n; ++i)
+			V[i] += (T)b[7]*A6[i] + (T)b[5]*A4[i] + (T)b[3]*A2[i];
+		for (size_t i=0; i!=n; ++i) V[i*n + i] += (T)b[1];
+		priv__::gemm_block(U, n, X, n, V, n, n, n, n);
+
+		for (size_t i=0; i!=n*n; ++i)
+			W[i] = (T)b[12]*A6[i] + (T)b[10]*A4[i] + (T)b[8]*A2[i];
+		priv__::gemm_block(V, n, A6, n, W, n, n, n, n);
+		for (size_t i=0; i!=n*n; ++i)
+			V[i] += (T)b[6]*A6[i] + (T)b[4]*A4[i] + (T)b[2]*A2[i];
+		for (size_t i=0; i!=n; ++i) V[i*n + i] += (T)b[0];
+	} else{
+		size_t m = 2*degree + 3;
+		for (size_t k=1; 2*k+2<m; ++k)
+			priv__::gemm_block(P[k], n, P[k-1], n, P[0], n, n, n, n);
+		// U = A*(sum of b[2k+1]*A^2k), V = sum of b[2k]*A^2k
+		for (size_t i=0; i!=n*n; ++i){
+			T odd = (T)0, even = (T)0;
+			for (size_t k=1; 2*k<m; ++k){
+				odd += (T)b[2*k+1] * P[k-1][i];
+				even += (T)b[2*k] * P[k-1][i];
+			}
+			U[i] = odd;
+			V[i] = even;
+		}
+		for (size_t i=0; i!=n; ++i){
+			U[i*n + i] += (T)b[1];
+			V[i*n + i] += (T)b[0];
+		}
+		priv__::gemm_block(P[0], n, X, n, U, n, n, n, n);
+		swap(U, P[0]);
+	}
+
+	// (V - U) * R = V + U
+	for (size_t i=0; i!=n*n; ++i){
+		T u = U[i], v = V[i];
+		U[i] = v - u;
+		V[i] = v + u;
+	}
+	priv__::block_solve(U, V, n);
+
+	T *R = V;
+	T *temp = U;
+	for (size_t i=0; i!=squarings; ++i){
+		priv__::gemm_block(temp, n, R, n, R, n, n, n, n);
+		T *t = R; R = temp; temp = t;
+	}
+
+	resize(dest, n, n);
+	for (size_t i=0; i!=n; ++i)
+		for (size_t j=0; j!=n; ++j)
+			dest(i, j) = R[i*n + j];
+
+	resize(MatrixTempStorage.data, oldSize);
+	SP_MATRIX_PROFILE_END();
+}
+
+
+
 template<SP_MATRIX_T(M)>
 void lu_decompose(M &&dest) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"lu_decompose", 2.0/3.0*rows(dest)*cols(dest)*min(rows(dest), cols(dest)),
+		2*rows(dest)*cols(dest)*sizeof(typename std::decay_t<M>::ValueType)
+	);
 	size_t length = min(rows(dest), cols(dest));
 
 	typename std::decay_t<M>::ValueType factor1, factor2;
@@ -138,15 +682,72 @@ void lu_decompose(M &&dest) noexcept{
 			}
 		}
 	}
+	SP_MATRIX_PROFILE_END();
+}
+
+namespace priv__{
+
+// right looking blocked lu decomposition of row major matrix, panel of columns is factorized
+// with partial pivoting, rows of upper triangle right of it are solved and the rest of the matrix
+// is updated by one product, the result is the same as of unblocked elimination up to rounding
+template<class T, class Cont>
+void blocked_lup(T *a, size_t ld, size_t m, size_t n, Cont &permuts, size_t panel) noexcept{
+	size_t length = min(m, n);
+	for (size_t j0=0; j0<length; j0+=panel){
+		size_t w = min(panel, length-j0);
+		size_t next = j0 + w;
+		for (size_t i=j0; i!=next; ++i){
+			size_t p = i;
+			for (size_t k=i+1; k!=m; ++k)	// find row with max value
+				p = abs(a[k*ld + i])>abs(a[p*ld + i]) ? k : p;
+			if (p != i){
+				for (size_t k=0; k!=n; ++k) swap(a[i*ld + k], a[p*ld + k]);
+				swap(permuts[i], permuts[p]);
+			}
+			T pivot = a[i*ld + i];
+			for (size_t r=i+1; r!=m; ++r){
+				T l = a[r*ld + i] / pivot;
+				a[r*ld + i] = l;
+				for (size_t c=i+1; c!=next; ++c) a[r*ld + c] -= l * a[i*ld + c];
+			}
+		}
+		if (next == n) continue;
+
+		for (size_t r=j0+1; r!=next; ++r)
+			for (size_t q=j0; q!=r; ++q){
+				T l = a[r*ld + q];
+				for (size_t c=next; c!=n; ++c) a[r*ld + c] -= l * a[q*ld + c];
+			}
+		if (next != m)
+			gemm_acc(a + next*ld + next, ld, a + next*ld + j0, ld, a + j0*ld + next, ld, m-next, w, n-next, -unit<T>());
+	}
 }
 
+} // END OF NAMESPACE PRIV //////////
+
+// row major matrices stored in memory which don't fit into level 2 cache are decomposed by blocks,
+// with panel width taken from matrixTuning
 template<SP_MATRIX_T(M), class Cont>
 void lup_decompose(M &&dest, Cont &permuts) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"lup_decompose", 2.0/3.0*rows(dest)*cols(dest)*min(rows(dest), cols(dest)),
+		2*rows(dest)*cols(dest)*sizeof(typename std::decay_t<M>::ValueType)
+	);
 	resize(permuts, rows(dest));
 	for (size_t i=0; i!=rows(dest); ++i) permuts[i] = i;
 
 	size_t length = min(rows(dest), cols(dest));
 
+	typedef std::decay_t<M> D;
+	if constexpr (D::RowMajor && priv__::HasLeadDim<D> && !IsExact<typename D::ValueType>){
+		size_t bytes = rows(dest) * cols(dest) * sizeof(typename D::ValueType);
+		if (bytes > matrixTuning.cacheL2 && length >= 2*matrixTuning.luPanel){
+			priv__::blocked_lup(beg(dest), lead_dim(dest), rows(dest), cols(dest), permuts, matrixTuning.luPanel);
+			SP_MATRIX_PROFILE_END();
+			return;
+		}
+	}
+
 	typename std::decay_t<M>::ValueType factor1, factor2;
 	if constexpr (std::decay_t<M>::RowMajor){
 		for (size_t i=0; i!=length; ++i){
@@ -189,6 +790,7 @@ void lup_decompose(M &&dest, Cont &permuts) noexcept{
 			}
 		}
 	}
+	SP_MATRIX_PROFILE_END();
 }
 
 template<SP_MATRIX_T(M1), SP_MATRIX_T(M2)>
@@ -229,6 +831,10 @@ void extract_upper(M1 &&dest, M2 &&src) noexcept{
 
 template<SP_MATRIX_T(M)>
 void cholesky_decompose(M &&dest) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"cholesky_decompose", 1.0/3.0*rows(dest)*rows(dest)*rows(dest),
+		rows(dest)*cols(dest)*sizeof(typename std::decay_t<M>::ValueType)
+	);
 	SP_MATRIX_ERROR(rows(dest) != cols(dest), "only square matrix can be cholesky decomposed");
 	size_t length = rows(dest);
 	if (std::decay_t<M>::RowMajor){
@@ -266,10 +872,15 @@ void cholesky_decompose(M &&dest) noexcept{
 			}
 		}
 	}
+	SP_MATRIX_PROFILE_END();
 }
 
 template<SP_MATRIX_T(M1), SP_MATRIX_T(M2)>
 void cholesky_update(M1 &&dest, M2 &&A) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"cholesky_update", 4.0*rows(dest)*rows(dest),
+		rows(dest)*cols(dest)*sizeof(typename std::decay_t<M1>::ValueType)
+	);
 	SP_MATRIX_ERROR(rows(dest)!=size(A) || cols(dest)!=size(A),
 		"non square matrices cannot be cholesky decomposed"
 	);
@@ -284,88 +895,532 @@ void cholesky_update(M1 &&dest, M2 &&A) noexcept{
 			A[j] = c * A[j] - s * dest(j, i);
 		}
 	}
+	SP_MATRIX_PROFILE_END();
 }
 
 
+namespace priv__{
+
+// moves line i of the matrix to line permuts[i] by following the cycles of permutation,
+// lines contiguous in memory are moved with memcpy, otherwise element by element
+template<bool byRows, class M, class Cont>
+void permute_lines(M &dest, const Cont &permuts) noexcept{
+	typedef typename std::decay_t<M>::ValueType T;
+	constexpr bool Contiguous = HasLeadDim<std::decay_t<M>> &&
+		std::decay_t<M>::RowMajor == byRows && std::is_trivially_copyable_v<T>;
+
+	size_t length = len(permuts);
+	size_t lineLen = byRows ? cols(dest) : rows(dest);
+	size_t words = (length + 63) / 64;
+	size_t oldSize = len(MatrixTempStorage.data);
+	expand_back(MatrixTempStorage.data, words + ((Contiguous ? 2 : 1)*lineLen*sizeof(T) + 7) / 8);
+	uint64_t *visited = beg(MatrixTempStorage.data) + oldSize;
+	T *buffer = (T *)(visited + words);
+	for (size_t i=0; i!=words; ++i) visited[i] = 0;
+
+	for (size_t i=0; i!=length; ++i){
+		if (visited[i/64] >> (i%64) & 1) continue;
+		visited[i/64] |= (uint64_t)1 << (i%64);
+		if ((size_t)permuts[i] == i) continue;
+
+		if constexpr (Contiguous){
+			size_t bytes = lineLen * sizeof(T);
+			T *held = buffer;
+			T *spare = buffer + lineLen;
+			memcpy(held, beg(dest) + i*lead_dim(dest), bytes);
+			for (size_t j=(size_t)permuts[i]; j!=i; j=(size_t)permuts[j]){
+				visited[j/64] |= (uint64_t)1 << (j%64);
+				T *line = beg(dest) + j*lead_dim(dest);
+				memcpy(spare, line, bytes);
+				memcpy(line, held, bytes);
+				T *temp = held; held = spare; spare = temp;
+			}
+			memcpy(beg(dest) + i*lead_dim(dest), held, bytes);
+		} else{
+			auto at = [&](size_t line, size_t k) -> decltype(auto){
+				if constexpr (byRows) return dest(line, k); else return dest(k, line);
+			};
+			for (size_t k=0; k!=lineLen; ++k) buffer[k] = at(i, k);
+			for (size_t j=(size_t)permuts[i]; j!=i; j=(size_t)permuts[j]){
+				visited[j/64] |= (uint64_t)1 << (j%64);
+				for (size_t k=0; k!=lineLen; ++k) swap(buffer[k], at(j, k));
+			}
+			for (size_t k=0; k!=lineLen; ++k) at(i, k) = buffer[k];
+		}
+	}
+
+	resize(MatrixTempStorage.data, oldSize);
+}
+
+} // END OF NAMESPACE PRIV //////////
+
 template<SP_MATRIX_T(M), class Cont>
 void permute_rows(M &&dest, const Cont &permuts) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"permute_rows", 0,
+		2*rows(dest)*cols(dest)*sizeof(typename std::decay_t<M>::ValueType)
+	);
 	static_assert(std::is_integral_v<typename Cont::ValueType>,
 		"permutation array must contain integral values"
 	);
 	SP_MATRIX_ERROR(rows(dest) != len(permuts),
 		"row count of permuted matrix must be the same as size of permutation array"
 	);
+	priv__::permute_lines<true>(dest, permuts);
+	SP_MATRIX_PROFILE_END();
+}
+
+template<SP_MATRIX_T(M), class Cont>
+void permute_cols(M &&dest, const Cont &permuts) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"permute_cols", 0,
+		2*rows(dest)*cols(dest)*sizeof(typename std::decay_t<M>::ValueType)
+	);
+	static_assert(std::is_integral_v<typename Cont::ValueType>,
+		"permutation array must contain integral values"
+	);
+	SP_MATRIX_ERROR(cols(dest) != len(permuts),
+		"columns count of permuted matrix must be the same as size of permutation array"
+	);
+	priv__::permute_lines<false>(dest, permuts);
+	SP_MATRIX_PROFILE_END();
+}
+
+
+
+namespace priv__{
 
+// returns true if the permutation array describes an odd permutation
+template<class Cont>
+bool permutation_parity(const Cont &permuts) noexcept{
 	size_t length = len(permuts);
+	size_t words = (length + 63) / 64;
 	size_t oldSize = len(MatrixTempStorage.data);
-	expand_back(MatrixTempStorage.data, (length * sizeof(typename Cont::ValueType) + 7) / 8);
-	typename Cont::ValueType *TempStorage = (typename Cont::ValueType *)beg(MatrixTempStorage.data) + oldSize;
-	
-	for (size_t i=0; i!=length; ++i) TempStorage[i] = beg(permuts)[i];
-	
+	expand_back(MatrixTempStorage.data, words);
+	uint64_t *visited = beg(MatrixTempStorage.data) + oldSize;
+	for (size_t i=0; i!=words; ++i) visited[i] = 0;
+
+	bool odd = false;
+	for (size_t i=0; i!=length; ++i){
+		if (visited[i/64] >> (i%64) & 1) continue;
+		visited[i/64] |= (uint64_t)1 << (i%64);
+		for (size_t j=(size_t)permuts[i]; j!=i; j=(size_t)permuts[j]){	// cycle of length L is L-1 swaps
+			visited[j/64] |= (uint64_t)1 << (j%64);
+			odd = !odd;
+		}
+	}
+
+	resize(MatrixTempStorage.data, oldSize);
+	return odd;
+}
+
+// determinant of row major n x n block, the block is destroyed
+template<class T>
+T lu_determinant(T *data, size_t n) noexcept{
+	T result = (T)1;
+	for (size_t i=0; i!=n; ++i){
+		{
+			size_t j = i;
+			for (size_t k=i+1; k!=n; ++k)	// find row with max value
+				j = abs(data[k*n+i])>abs(data[j*n+i]) ? k : j;
+			if (j != i){
+				for (size_t k=i; k!=n; ++k)	// exchange top row with row with max value
+					swap(data[i*n+k], data[j*n+k]);
+				result = -result;
+			}
+		}
+		T factor1 = data[i*(n+1)];
+		if (factor1 == (T)0) return (T)0;
+		result *= factor1;
+		for (size_t j=i+1; j!=n; ++j){
+			T factor2 = data[j*n+i] / factor1;
+			for (size_t k=i+1; k!=n; ++k)
+				data[j*n+k] -= data[i*n+k] * factor2;
+		}
+	}
+	return result;
+}
+
+// type that holds a product of two elements before the exact division brings it back in range
+template<class T> struct WideOf{ typedef T Type; };
+template<> struct WideOf<int8_t>{ typedef int64_t Type; };
+template<> struct WideOf<int16_t>{ typedef int64_t Type; };
+template<> struct WideOf<int32_t>{ typedef int64_t Type; };
+template<> struct WideOf<uint8_t>{ typedef int64_t Type; };
+template<> struct WideOf<uint16_t>{ typedef int64_t Type; };
+template<> struct WideOf<uint32_t>{ typedef int64_t Type; };
+#ifdef __SIZEOF_INT128__
+template<> struct WideOf<int64_t>{ typedef __int128 Type; };
+template<> struct WideOf<uint64_t>{ typedef __int128 Type; };
+#endif
+
+// fraction-free gauss-jordan elimination of row major n x w block, the left n x n part becomes
+// d*I, where d is the determinant of the row permuted block, and the remaining columns get
+// multiplied by the adjugate of the row permuted block, every division is exact
+// returns d or 0 if the block is singular, odd is set when the rows were permuted oddly
+template<class T>
+T bareiss_gauss_jordan(T *data, size_t n, size_t w, bool &odd) noexcept{
+	typedef typename WideOf<T>::Type Wide;
+	odd = false;
+	Wide prev = (Wide)1;
+	for (size_t k=0; k!=n; ++k){
+		{
+			size_t j = k;
+			while (j!=n && data[j*w+k]==(T)0) ++j;	// find any nonzero pivot
+			if (j == n) return (T)0;
+			if (j != k){
+				for (size_t l=0; l!=w; ++l) swap(data[k*w+l], data[j*w+l]);
+				odd = !odd;
+			}
+		}
+		Wide pivot = data[k*(w+1)];
+		for (size_t i=0; i!=n; ++i){
+			if (i == k) continue;
+			Wide factor = data[i*w+k];
+			for (size_t l=k+1; l!=w; ++l)
+				data[i*w+l] = (T)((pivot*data[i*w+l] - factor*data[k*w+l]) / prev);
+			data[i*w+k] = (T)0;
+			if (i < k) data[i*(w+1)] = (T)pivot;	// left part of eliminated rows is diagonal
+		}
+		prev = pivot;
+	}
+	return (T)prev;
+}
+
+// fraction-free determinant of row major n x n block, the block is destroyed
+template<class T>
+T bareiss_determinant(T *data, size_t n) noexcept{
+	typedef typename WideOf<T>::Type Wide;
+	bool odd = false;
+	Wide prev = (Wide)1;
+	for (size_t k=0; k!=n; ++k){
+		{
+			size_t j = k;
+			while (j!=n && data[j*n+k]==(T)0) ++j;
+			if (j == n) return (T)0;
+			if (j != k){
+				for (size_t l=k; l!=n; ++l) swap(data[k*n+l], data[j*n+l]);
+				odd = !odd;
+			}
+		}
+		Wide pivot = data[k*(n+1)];
+		for (size_t i=k+1; i!=n; ++i){
+			Wide factor = data[i*n+k];
+			for (size_t l=k+1; l!=n; ++l)
+				data[i*n+l] = (T)((pivot*data[i*n+l] - factor*data[k*n+l]) / prev);
+		}
+		prev = pivot;
+	}
+	return odd ? -(T)prev : (T)prev;
+}
+
+// fraction-free null vector of row major n x n block of rank n-1, the block is destroyed, the
+// vector has coprime elements, returns true if the rank is lower
+template<class T>
+bool exact_null_vector(T *data, size_t n, T *x) noexcept{
+	typedef typename WideOf<T>::Type Wide;
+	typedef std::make_unsigned_t<T> UnsT;
+	Wide prev = (Wide)1;
+	size_t free = n;	// the only column without a pivot
+	size_t r = 0;
+	for (size_t c=0; c!=n; ++c){
+		size_t j = r;
+		while (j!=n && data[j*n+c]==(T)0) ++j;
+		if (j == n){
+			if (free != n) return true;
+			free = c;
+			continue;
+		}
+		if (j != r) for (size_t l=0; l!=n; ++l) swap(data[r*n+l], data[j*n+l]);
+		Wide pivot = data[r*n+c];
+		for (size_t i=0; i!=n; ++i){
+			if (i == r) continue;
+			Wide factor = data[i*n+c];
+			for (size_t l=c+1; l!=n; ++l)
+				data[i*n+l] = (T)((pivot*data[i*n+l] - factor*data[r*n+l]) / prev);
+			if (free < c)
+				data[i*n+free] = (T)((pivot*data[i*n+free] - factor*data[r*n+free]) / prev);
+			data[i*n+c] = (T)0;
+		}
+		prev = pivot;
+		++r;
+	}
+	if (free == n) return true;
+
+	// pivot columns are reduced to prev*I, so every row gives prev*x_pivot + a*x_free = 0
+	x[free] = (T)prev;
+	for (size_t i=0; i!=n-1; ++i) x[i<free ? i : i+1] = -data[i*n+free];
+	UnsT divider = 0;
+	for (size_t i=0; i!=n; ++i) divider = gcd(divider, (UnsT)abs(x[i]));
+	for (size_t i=0; i!=n; ++i) x[i] /= (T)divider;
+	return false;
+}
+
+// copies the matrix into the integer block of width w, for rationals every row gets multiplied
+// by the least common multiple of its denominators, which are stored in scales
+template<class T, class M>
+void load_exact(T *data, size_t w, M &&A, T *scales) noexcept{
+	typedef typename std::decay_t<M>::ValueType VT;
+	for (size_t i=0; i!=rows(A); ++i){
+		if constexpr (IsRational<VT>){
+			typedef std::make_unsigned_t<T> UnsT;
+			T scale = (T)1;
+			for (size_t j=0; j!=cols(A); ++j)
+				scale = (T)lcm((UnsT)scale, (UnsT)abs(A(i, j).den));
+			scales[i] = scale;
+			for (size_t j=0; j!=cols(A); ++j)
+				data[i*w+j] = A(i, j).nom * (scale / A(i, j).den);
+		} else{
+			for (size_t j=0; j!=cols(A); ++j)
+				data[i*w+j] = (T)A(i, j);
+		}
+	}
+}
+
+template<class T> struct ExactBase{ typedef T Type; };
+template<class B> struct ExactBase<Rational<B>>{ typedef B Type; };
+
+template<class VT, class T>
+VT make_exact(T nom, T den) noexcept{
+	if constexpr (IsRational<VT>){
+		VT result{nom, den};
+		result.simplify();
+		return result;
+	} else{
+		return (VT)(nom / den);
+	}
+}
+
+// divides the element of the scaled matrix by every row scale except the skipped one, scales
+// are cancelled one at a time, so the denominator overflows only if the reduced one does
+template<class VT, class T>
+VT unscale_exact(T val, const T *scales, size_t length, size_t skip) noexcept{
+	if constexpr (IsRational<VT>){
+		typedef std::make_unsigned_t<T> UnsT;
+		T den = (T)1;
+		for (size_t k=0; k!=length; ++k){
+			if (k == skip) continue;
+			T divider = (T)gcd((UnsT)abs(val), (UnsT)scales[k]);
+			val /= divider;
+			den *= scales[k] / divider;
+		}
+		return make_exact<VT>(val, den);
+	} else{
+		return (VT)val;
+	}
+}
+
+template<bool Transposed, class M1, class M2>
+void exact_adjugate(M1 &dest, M2 &&A) noexcept{
+	typedef typename std::decay_t<M2>::ValueType VT;
+	typedef typename ExactBase<VT>::Type T;
+	typedef typename WideOf<T>::Type Wide;
+	size_t length = rows(A);
+	size_t width = 2*length;
+
+	size_t oldSize = len(MatrixTempStorage.data);
+	expand_back(
+		MatrixTempStorage.data, ((length*width + length + length*length + 2*length) * sizeof(T) + 7) / 8
+	);
+	T *TempStorage = (T *)(beg(MatrixTempStorage.data) + oldSize);
+	T *scales = TempStorage + length*width;
+
+	load_exact(TempStorage, width, A, scales);
+	for (size_t i=0; i!=length; ++i)
+		for (size_t j=0; j!=length; ++j)
+			TempStorage[i*width+length+j] = i==j ? (T)1 : (T)0;
+
+	// adj(A)_ij is a minor of the scaled matrix that skips the row j
+	auto put = [&](size_t i, size_t j, T val){
+		if constexpr (Transposed)
+			dest(j, i) = unscale_exact<VT>(val, scales, length, j);
+		else
+			dest(i, j) = unscale_exact<VT>(val, scales, length, j);
+	};
+
+	resize(dest, length, length);
+	bool odd;
+	T det = bareiss_gauss_jordan(TempStorage, length, width, odd);
+	if (det != (T)0){
+		for (size_t i=0; i!=length; ++i)
+			for (size_t j=0; j!=length; ++j){
+				T val = TempStorage[i*width+length+j];
+				put(i, j, odd ? -val : val);
+			}
+	} else{	// singular, adj(A) is c*x*y^T for null vectors of a rank n-1 matrix and zero otherwise
+		T *src = TempStorage + length*width + length;
+		T *x = src + length*length;
+		T *y = x + length;
+		load_exact(src, length, A, scales);
+		for (size_t r=0; r!=length; ++r)
+			for (size_t c=0; c!=length; ++c)
+				TempStorage[r*length+c] = src[r*length+c];
+		bool deficient = exact_null_vector(TempStorage, length, x);
+		if (!deficient){
+			for (size_t r=0; r!=length; ++r)	// left null vector is the null vector of the transpose
+				for (size_t c=0; c!=length; ++c)
+					TempStorage[r*length+c] = src[c*length+r];
+			deficient = exact_null_vector(TempStorage, length, y);
+		}
+
+		Wide factor = (Wide)0;
+		if (!deficient){
+			size_t p = 0, q = 0;
+			for (size_t i=1; i!=length; ++i){
+				p = abs(x[i])>abs(x[p]) ? i : p;
+				q = abs(y[i])>abs(y[q]) ? i : q;
+			}
+			T *I = TempStorage;	// adj(A)_pq is the cofactor of the element (q, p)
+			for (size_t r=0; r!=length; ++r){
+				if (r == q) continue;
+				for (size_t c=0; c!=length; ++c)
+					if (c != p) *I++ = src[r*length+c];
+			}
+			Wide minor = bareiss_determinant(TempStorage, length-1);
+			if ((p + q) & 1) minor = -minor;
+			// x and y have coprime elements, so c is integral for the integral adjugate
+			factor = minor / ((Wide)x[p] * y[q]);
+		}
+		for (size_t i=0; i!=length; ++i)
+			for (size_t j=0; j!=length; ++j)
+				put(i, j, deficient ? (T)0 : (T)(factor * x[i] * y[j]));
+	}
+
+	resize(MatrixTempStorage.data, oldSize);
+}
+
+template<class M>
+auto exact_determinant(M &&A) noexcept{
+	typedef typename std::decay_t<M>::ValueType VT;
+	typedef typename ExactBase<VT>::Type T;
+	size_t length = rows(A);
+
+	size_t oldSize = len(MatrixTempStorage.data);
+	expand_back(MatrixTempStorage.data, ((length*length + length) * sizeof(T) + 7) / 8);
+	T *TempStorage = (T *)(beg(MatrixTempStorage.data) + oldSize);
+	T *scales = TempStorage + length*length;
+
+	load_exact(TempStorage, length, A, scales);
+	T result = bareiss_determinant(TempStorage, length);
+	VT det = unscale_exact<VT>(result, scales, length, length);
+
+	resize(MatrixTempStorage.data, oldSize);
+	return det;
+}
+
+// inverse of integral matrix is exact only if it is integral, otherwise elements are truncated
+template<class M1, class M2>
+void exact_invert(M1 &dest, M2 &&A) noexcept{
+	typedef typename std::decay_t<M1>::ValueType VT;
+	typedef typename ExactBase<VT>::Type T;
+	typedef std::make_unsigned_t<T> UnsT;
+	size_t length = rows(A);
+	size_t width = 2*length;
+
+	size_t oldSize = len(MatrixTempStorage.data);
+	expand_back(MatrixTempStorage.data, ((length*width + length) * sizeof(T) + 7) / 8);
+	T *TempStorage = (T *)(beg(MatrixTempStorage.data) + oldSize);
+	T *scales = TempStorage + length*width;
+
+	load_exact(TempStorage, width, A, scales);
 	for (size_t i=0; i!=length; ++i)
-		while (TempStorage[i] != i){
-			size_t swapIndex = TempStorage[i];
-			iswap(TempStorage+i, TempStorage+swapIndex);
+		for (size_t j=0; j!=length; ++j)
+			TempStorage[i*width+length+j] = i==j ? (T)1 : (T)0;
 
-			for (size_t j=0; j!=cols(dest); ++j)
-				swap(dest(swapIndex, j), dest(i, j));
+	bool odd;
+	T det = bareiss_gauss_jordan(TempStorage, length, width, odd);
+	SP_MATRIX_ERROR(det == (T)0, "singular matrix cannot be inverted");
+
+	// right part holds det*inv(S*A), where S scales the rows, so inv(A) = inv(S*A)*S
+	resize(dest, length, length);
+	for (size_t i=0; i!=length; ++i)
+		for (size_t j=0; j!=length; ++j){
+			T val = TempStorage[i*width+length+j];
+			if constexpr (IsRational<VT>){
+				T divider = (T)gcd((UnsT)abs(det), (UnsT)scales[j]);
+				dest(i, j) = make_exact<VT>(val * (scales[j]/divider), det / divider);
+			} else{
+				dest(i, j) = make_exact<VT>(val, det);
+			}
 		}
 
-	resize(MatrixTempStorage.data, oldSize);	
+	resize(MatrixTempStorage.data, oldSize);
 }
 
-template<SP_MATRIX_T(M), class Cont>
-void permute_cols(M &&dest, const Cont &permuts) noexcept{
-	static_assert(std::is_integral_v<typename Cont::ValueType>, "permutation array must contain integral values");
-	SP_MATRIX_ERROR(cols(dest) != len(permuts), "columns count of permuted matrix must be the same as size of permutation array");
+// null vector of row major n x n block of rank n-1, the block is destroyed, columns without an
+// element above the tolerance count as dependent, returns true if the rank is lower
+template<class T>
+bool float_null_vector(T *data, size_t n, T *x, T tolerance) noexcept{
+	size_t free = n;	// the only column without a pivot
+	size_t r = 0;
+	for (size_t c=0; c!=n; ++c){
+		size_t j = r;
+		for (size_t k=r+1; k!=n; ++k)	// find row with max value
+			j = abs(data[k*n+c])>abs(data[j*n+c]) ? k : j;
+		if (abs(data[j*n+c]) <= tolerance){
+			if (free != n) return true;
+			free = c;
+			continue;
+		}
+		if (j != r) for (size_t l=0; l!=n; ++l) swap(data[r*n+l], data[j*n+l]);
+		T inv = unit<T>() / data[r*n+c];
+		for (size_t l=c+1; l!=n; ++l) data[r*n+l] *= inv;
+		if (free < c) data[r*n+free] *= inv;
+		for (size_t i=0; i!=n; ++i){
+			if (i == r) continue;
+			T factor = data[i*n+c];
+			for (size_t l=c+1; l!=n; ++l) data[i*n+l] -= factor * data[r*n+l];
+			if (free < c) data[i*n+free] -= factor * data[r*n+free];
+			data[i*n+c] = T{};
+		}
+		++r;
+	}
+	if (free == n) return true;
 
-	size_t length = len(permuts);
-	size_t oldSize = len(MatrixTempStorage.data);
-	expand_back(MatrixTempStorage.data, (length * sizeof(typename Cont::ValueType) + 7) / 8);
-	typename Cont::ValueType *TempStorage = (typename Cont::ValueType *)beg(MatrixTempStorage.data) + oldSize;
-	
-	for (size_t i=0; i!=length; ++i) TempStorage[i] = beg(permuts)[i];
-	
-	for (size_t i=0; i!=length; ++i)
-		while (TempStorage[i] != i){
-			size_t swapIndex = TempStorage[i];
-			iswap(TempStorage+i, TempStorage+swapIndex);
+	// pivot columns are reduced to I, so every row gives x_pivot + a*x_free = 0
+	x[free] = unit<T>();
+	for (size_t i=0; i!=n-1; ++i) x[i<free ? i : i+1] = -data[i*n+free];
+	return false;
+}
 
-			for (size_t j=0; j!=cols(dest); ++j)
-				swap(dest(j, swapIndex), dest(j, i));
+// solves the lu decomposed system for every column of the identity scaled by the determinant
+template<bool Transposed, class M1, class F, class Cont, class T>
+void lu_adjugate_solve(M1 &dest, F &&LU, const Cont &permuts, size_t length, T det) noexcept{
+	for (size_t i=0; i!=length; ++i){
+		auto at = [&](size_t r) -> T &{ return Transposed ? dest(i, r) : dest(r, i); };
+		for (size_t j=0; j!=length; ++j){
+			T val = (size_t)permuts[j]==i ? det : T{};
+			for (size_t k=0; k!=j; ++k)
+				val -= LU(j, k) * at(k);
+			at(j) = val;
 		}
-
-	resize(MatrixTempStorage.data, oldSize);	
+		for (size_t j=length-1; j!=(size_t)-1; --j){
+			T val = at(j);
+			for (size_t k=j+1; k!=length; ++k)
+				val -= LU(j, k) * at(k);
+			at(j) = val / LU(j, j);
+		}
+	}
 }
 
-template<SP_MATRIX_T(M)>
-void invert(M &&dest) noexcept{
-	SP_MATRIX_ERROR(rows(dest) != cols(dest), "only square matrix can be inverted");
-	size_t length = rows(dest);
+template<bool Transposed, class M1, class M2>
+void float_adjugate(M1 &dest, M2 &&A) noexcept{
+	typedef typename std::decay_t<M2>::ValueType T;
+	size_t length = rows(A);
 
 	size_t oldSize = len(MatrixTempStorage.data);
-	expand_back(MatrixTempStorage.data, (length*length * sizeof(typename std::decay_t<M>::ValueType) + 7) / 8);
+	expand_back(MatrixTempStorage.data, (length*length * sizeof(T) + 7) / 8);
 	size_t permutsIndex = len(MatrixTempStorage.data);
 	expand_back(MatrixTempStorage.data, (length * sizeof(uint32_t) + 7) / 8);
-	typename std::decay_t<M>::ValueType *TempStorage = (typename std::decay_t<M>::ValueType *)(beg(MatrixTempStorage.data) + oldSize);
-	uint32_t *permuts = (uint32_t *)(beg(MatrixTempStorage.data) + permutsIndex);
+	T *TempStorage = (T *)(beg(MatrixTempStorage.data) + oldSize);
+	Range<uint32_t> permuts{(uint32_t *)(beg(MatrixTempStorage.data) + permutsIndex), length};
 
 	for (size_t i=0; i!=length; ++i) permuts[i] = i;
+	for (size_t i=0; i!=length; ++i)
+		for (size_t j=0; j!=length; ++j)
+			TempStorage[i*length+j] = A(i, j);
 
-	if constexpr (std::decay_t<M>::RowMajor){
-		typename std::decay_t<M>::ValueType *I = TempStorage;
-		for (size_t i=0; i!=length; ++i)
-			for (size_t j=0; j!=length; ++j, ++I)
-				*I = dest(j, i);
-	} else{
-		typename std::decay_t<M>::ValueType *I = TempStorage;
-		for (size_t i=0; i!=length; ++i)
-			for (size_t j=0; j!=length; ++j, ++I)
-				*I = dest(i, j);
-	}
-
-	typename std::decay_t<M>::ValueType factor1, factor2;
+	T det = unit<T>();
 	for (size_t i=0; i!=length; ++i){
 		{
 			size_t j = i;
@@ -375,120 +1430,255 @@ void invert(M &&dest) noexcept{
 				for (size_t k=0; k!=length; ++k)	// exchange top row with row with max value
 					swap(TempStorage[i*length+k], TempStorage[j*length+k]);
 				swap(permuts[i], permuts[j]);
+				det = -det;
 			}
 		}
-		factor1 = TempStorage[i*(length+1)];
+		T factor1 = TempStorage[i*(length+1)];
+		det *= factor1;
+		if (factor1 == T{}) break;
 		for (size_t j=i+1; j!=length; ++j){
-			factor2 = TempStorage[j*length+i] / factor1;
+			T factor2 = TempStorage[j*length+i] / factor1;
 			TempStorage[j*length+i] = factor2;
 			for (size_t k=i+1; k!=length; ++k)
 				TempStorage[j*length+k] -= TempStorage[i*length+k] * factor2;
 		}
 	}
 
-	if constexpr (std::decay_t<M>::	RowMajor){
-		for (size_t i=0; i!=length; ++i){
-			for (size_t j=0; j!=length; ++j){
-				dest(i, j) = permuts[j]==i ? (typename std::decay_t<M>::ValueType)1 : (typename std::decay_t<M>::ValueType)0;
-
-				for (size_t k=0; k!=j; ++k)
-					dest(i, j) -= TempStorage[j*length+k] * dest(i, k);
+	resize(dest, length, length);
+	if (det != T{}){
+		lu_adjugate_solve<Transposed>(
+			dest, [=](size_t r, size_t c) -> T{ return TempStorage[r*length+c]; },
+			permuts, length, det
+		);
+	} else{	// singular, adj(A) is c*x*y^T for null vectors of a rank n-1 matrix and zero otherwise
+		size_t srcIndex = len(MatrixTempStorage.data);
+		expand_back(MatrixTempStorage.data, ((length*length + 2*length) * sizeof(T) + 7) / 8);
+		T *work = (T *)(beg(MatrixTempStorage.data) + oldSize);
+		T *src = (T *)(beg(MatrixTempStorage.data) + srcIndex);
+		T *x = src + length*length;
+		T *y = x + length;
+		T maxAbs{};
+		for (size_t r=0; r!=length; ++r)
+			for (size_t c=0; c!=length; ++c){
+				work[r*length+c] = src[r*length+c] = A(r, c);
+				maxAbs = max(maxAbs, abs(src[r*length+c]));
 			}
+		// the pivot found zero is usually rounded away, so dependence is judged with a tolerance
+		T tolerance = maxAbs * (T)length * std::numeric_limits<T>::epsilon();
+		bool deficient = float_null_vector(work, length, x, tolerance);
+		if (!deficient){
+			for (size_t r=0; r!=length; ++r)	// left null vector is the null vector of the transpose
+				for (size_t c=0; c!=length; ++c)
+					work[r*length+c] = src[c*length+r];
+			deficient = float_null_vector(work, length, y, tolerance);
+		}
 
-			for (size_t j=length+1; j!=(size_t)-1; --j) {
-				for (size_t k = j+1; k!=length; ++k)
-					dest(i, j) -= TempStorage[j*length+k] * dest(i, k);
-
-				dest(i, j) /= TempStorage[j*(length+1)];
+		T factor{};
+		if (!deficient){
+			size_t p = 0, q = 0;
+			for (size_t i=1; i!=length; ++i){
+				p = abs(x[i])>abs(x[p]) ? i : p;
+				q = abs(y[i])>abs(y[q]) ? i : q;
 			}
+			T *I = work;	// adj(A)_pq is the cofactor of the element (q, p)
+			for (size_t r=0; r!=length; ++r){
+				if (r == q) continue;
+				for (size_t c=0; c!=length; ++c)
+					if (c != p) *I++ = src[r*length+c];
+			}
+			T minor = lu_determinant(work, length-1);
+			if ((p + q) & 1) minor = -minor;
+			factor = minor / (x[p] * y[q]);
 		}
+		for (size_t i=0; i!=length; ++i)
+			for (size_t j=0; j!=length; ++j){
+				T val = deficient ? T{} : factor * x[i] * y[j];
+				if constexpr (Transposed)
+					dest(j, i) = val;
+				else
+					dest(i, j) = val;
+			}
+	}
+
+	resize(MatrixTempStorage.data, oldSize);
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+
+
+template<SP_MATRIX_T(M)>
+void invert(M &&dest) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"invert", 2.0*rows(dest)*rows(dest)*rows(dest),
+		2*rows(dest)*cols(dest)*sizeof(typename std::decay_t<M>::ValueType)
+	);
+	SP_MATRIX_ERROR(rows(dest) != cols(dest), "only square matrix can be inverted");
+	if constexpr (IsExact<typename std::decay_t<M>::ValueType>){
+		priv__::exact_invert(dest, dest);
 	} else{
+		size_t length = rows(dest);
+
+		size_t oldSize = len(MatrixTempStorage.data);
+		expand_back(MatrixTempStorage.data, (length*length * sizeof(typename std::decay_t<M>::ValueType) + 7) / 8);
+		size_t permutsIndex = len(MatrixTempStorage.data);
+		expand_back(MatrixTempStorage.data, (length * sizeof(uint32_t) + 7) / 8);
+		typename std::decay_t<M>::ValueType *TempStorage = (typename std::decay_t<M>::ValueType *)(beg(MatrixTempStorage.data) + oldSize);
+		uint32_t *permuts = (uint32_t *)(beg(MatrixTempStorage.data) + permutsIndex);
+
+		for (size_t i=0; i!=length; ++i) permuts[i] = i;
+
+		if constexpr (std::decay_t<M>::RowMajor){
+			typename std::decay_t<M>::ValueType *I = TempStorage;
+			for (size_t i=0; i!=length; ++i)
+				for (size_t j=0; j!=length; ++j, ++I)
+					*I = dest(j, i);
+		} else{
+			typename std::decay_t<M>::ValueType *I = TempStorage;
+			for (size_t i=0; i!=length; ++i)
+				for (size_t j=0; j!=length; ++j, ++I)
+					*I = dest(i, j);
+		}
+
+		typename std::decay_t<M>::ValueType factor1, factor2;
 		for (size_t i=0; i!=length; ++i){
-			for (size_t j=0; j!=length; ++j){
-				dest(j, i) = permuts[j]==i ? (typename std::decay_t<M>::ValueType)1 : (typename std::decay_t<M>::ValueType)0;
+			{
+				size_t j = i;
+				for (size_t k=i+1; k!=length; ++k)	// find row with max value
+					j = abs(TempStorage[k*length+i])>abs(TempStorage[j*length+i]) ? k : j;
+				if (j != i){
+					for (size_t k=0; k!=length; ++k)	// exchange top row with row with max value
+						swap(TempStorage[i*length+k], TempStorage[j*length+k]);
+					swap(permuts[i], permuts[j]);
+				}
+			}
+			factor1 = TempStorage[i*(length+1)];
+			for (size_t j=i+1; j!=length; ++j){
+				factor2 = TempStorage[j*length+i] / factor1;
+				TempStorage[j*length+i] = factor2;
+				for (size_t k=i+1; k!=length; ++k)
+					TempStorage[j*length+k] -= TempStorage[i*length+k] * factor2;
+			}
+		}
 
-				for (size_t k=0; k!=j; ++k)
-					dest(j, i) -= TempStorage[j*length+k] * dest(k, i);
+		if constexpr (std::decay_t<M>::	RowMajor){
+			for (size_t i=0; i!=length; ++i){
+				for (size_t j=0; j!=length; ++j){
+					dest(i, j) = permuts[j]==i ? (typename std::decay_t<M>::ValueType)1 : (typename std::decay_t<M>::ValueType)0;
+
+					for (size_t k=0; k!=j; ++k)
+						dest(i, j) -= TempStorage[j*length+k] * dest(i, k);
+				}
+
+				for (size_t j=length-1; j!=(size_t)-1; --j){
+					for (size_t k = j+1; k!=length; ++k)
+						dest(i, j) -= TempStorage[j*length+k] * dest(i, k);
+
+					dest(i, j) /= TempStorage[j*(length+1)];
+				}
 			}
+		} else{
+			for (size_t i=0; i!=length; ++i){
+				for (size_t j=0; j!=length; ++j){
+					dest(j, i) = permuts[j]==i ? (typename std::decay_t<M>::ValueType)1 : (typename std::decay_t<M>::ValueType)0;
 
-			for (size_t j=length+1; j!=(size_t)-1; --j) {
-				for (size_t k = j+1; k!=length; ++k)
-					dest(j, i) -= TempStorage[j*length+k] * dest(k, i);
+					for (size_t k=0; k!=j; ++k)
+						dest(j, i) -= TempStorage[j*length+k] * dest(k, i);
+				}
 
-				dest(j, i) /= TempStorage[j*(length+1)];
+				for (size_t j=length-1; j!=(size_t)-1; --j){
+					for (size_t k = j+1; k!=length; ++k)
+						dest(j, i) -= TempStorage[j*length+k] * dest(k, i);
+
+					dest(j, i) /= TempStorage[j*(length+1)];
+				}
 			}
 		}
-	}
 
-	resize(MatrixTempStorage.data, oldSize);
+		resize(MatrixTempStorage.data, oldSize);
+	}
+	SP_MATRIX_PROFILE_END();
 }
 
 template<SP_MATRIX_T(M1), SP_MATRIX_T(M2)>
 void invert(M1 &&dest, M2 &&A) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"invert", 2.0*rows(A)*rows(A)*rows(A),
+		2*rows(A)*cols(A)*sizeof(typename std::decay_t<M1>::ValueType)
+	);
 	SP_MATRIX_ERROR(rows(A) != cols(A), "only square matrix can be inverted");
-	size_t length= rows(A);
+	if constexpr (IsExact<typename std::decay_t<M1>::ValueType>){
+		priv__::exact_invert(dest, A);
+	} else{
+		size_t length= rows(A);
 
-	size_t oldSize = len(MatrixTempStorage.data);
-	expand_back(MatrixTempStorage.data, (length*length * sizeof(typename std::decay_t<M1>::ValueType) + 7) / 8);
-	size_t permutsIndex = len(MatrixTempStorage.data);
-	expand_back(MatrixTempStorage.data, (length* sizeof(uint32_t) + 7) / 8);
-	typename std::decay_t<M1>::ValueType *TempStorage = (typename std::decay_t<M1>::ValueType *)(beg(MatrixTempStorage.data) + oldSize);
-	uint32_t *permuts = (uint32_t *)(beg(MatrixTempStorage.data) + permutsIndex);
+		size_t oldSize = len(MatrixTempStorage.data);
+		expand_back(MatrixTempStorage.data, (length*length * sizeof(typename std::decay_t<M1>::ValueType) + 7) / 8);
+		size_t permutsIndex = len(MatrixTempStorage.data);
+		expand_back(MatrixTempStorage.data, (length* sizeof(uint32_t) + 7) / 8);
+		typename std::decay_t<M1>::ValueType *TempStorage = (typename std::decay_t<M1>::ValueType *)(beg(MatrixTempStorage.data) + oldSize);
+		uint32_t *permuts = (uint32_t *)(beg(MatrixTempStorage.data) + permutsIndex);
 
-	for (size_t i=0; i!=length; ++i) permuts[i] = i;
-	{
-		typename std::decay_t<M2>::ValueType *I = TempStorage;
-		for (size_t i=0; i!=length; ++i)
-			for (size_t j=0; j!=length; ++j, ++I)
-				*I = A(i, j);
-	}
+		for (size_t i=0; i!=length; ++i) permuts[i] = i;
+		{
+			typename std::decay_t<M2>::ValueType *I = TempStorage;
+			for (size_t i=0; i!=length; ++i)
+				for (size_t j=0; j!=length; ++j, ++I)
+					*I = A(i, j);
+		}
 
 
-	// L = F*msqrt(D)
-	// inv(A) = inv(tr(L)) * inv(L) = inv(tr(F*msqrt(D))) * inv(F*msqrt(D)) = tr(inv(F)) * tr(inv(msqrt(D))) * inv(msqrt(D)) * inv(F)
+		// L = F*msqrt(D)
+		// inv(A) = inv(tr(L)) * inv(L) = inv(tr(F*msqrt(D))) * inv(F*msqrt(D)) = tr(inv(F)) * tr(inv(msqrt(D))) * inv(msqrt(D)) * inv(F)
 
-	for (size_t i=0; i!=length; ++i){
-		{
-			size_t j = i;
-			for (size_t k=i+1; k!=length; ++k)	// find row with max value
-				j = abs(TempStorage[k*length+i])>abs(TempStorage[j*length+i]) ? k : j;
-			if (j != i){
-				for (size_t k=0; k!=length; ++k)	// exchange top row with row with max value
-					swap(TempStorage[i*length+k], TempStorage[j*length+k]);
-				swap(permuts[i], permuts[j]);
+		for (size_t i=0; i!=length; ++i){
+			{
+				size_t j = i;
+				for (size_t k=i+1; k!=length; ++k)	// find row with max value
+					j = abs(TempStorage[k*length+i])>abs(TempStorage[j*length+i]) ? k : j;
+				if (j != i){
+					for (size_t k=0; k!=length; ++k)	// exchange top row with row with max value
+						swap(TempStorage[i*length+k], TempStorage[j*length+k]);
+					swap(permuts[i], permuts[j]);
+				}
+			}
+			typename std::decay_t<M2>::ValueType factor1 = TempStorage[i*(length+1)];
+			for (size_t j=i+1; j!=length; ++j){
+				typename std::decay_t<M2>::ValueType factor2 = TempStorage[j*length+i] / factor1;
+				TempStorage[j*length+i] = factor2;
+				for (size_t k=i+1; k!=length; ++k)
+					TempStorage[j*length+k] -= TempStorage[i*length+k] * factor2;
 			}
 		}
-		typename std::decay_t<M2>::ValueType factor1 = TempStorage[i*(length+1)];
-		for (size_t j=i+1; j!=length; ++j){
-			typename std::decay_t<M2>::ValueType factor2 = TempStorage[j*length+i] / factor1;
-			TempStorage[j*length+i] = factor2;
-			for (size_t k=i+1; k!=length; ++k)
-				TempStorage[j*length+k] -= TempStorage[i*length+k] * factor2;
-		}
-	}
 
-	resize(dest, length, length);
-	for (size_t i=0; i!=length; ++i){
-		for (size_t j=0; j!=length; ++j){
-			dest(j, i) = permuts[j]==i ? (typename std::decay_t<M1>::ValueType)1 : (typename std::decay_t<M1>::ValueType)0;
+		resize(dest, length, length);
+		for (size_t i=0; i!=length; ++i){
+			for (size_t j=0; j!=length; ++j){
+				dest(j, i) = permuts[j]==i ? unit<typename std::decay_t<M1>::ValueType>() : typename std::decay_t<M1>::ValueType{};
 
-			for (size_t k=0; k!=j; ++k)
-				dest(j, i) -= TempStorage[j*length+k] * dest(k, i);
-		}
+				for (size_t k=0; k!=j; ++k)
+					dest(j, i) -= TempStorage[j*length+k] * dest(k, i);
+			}
 
-		for (size_t j=length+1; j!=(size_t)-1; --j) {
-			typename std::decay_t<M2>::ValueType factor = (typename std::decay_t<M2>::ValueType)1 / TempStorage[j*(length+1)];
-			for (size_t k = j+1; k!=length; ++k)
-				dest(j, i) -= TempStorage[j*length+k] * dest(k, i);
+			for (size_t j=length-1; j!=(size_t)-1; --j){
+				typename std::decay_t<M2>::ValueType factor = unit<typename std::decay_t<M2>::ValueType>() / TempStorage[j*(length+1)];
+				for (size_t k = j+1; k!=length; ++k)
+					dest(j, i) -= TempStorage[j*length+k] * dest(k, i);
 
-			dest(j, i) *= factor;
+				dest(j, i) *= factor;
+			}
 		}
+		resize(MatrixTempStorage.data, oldSize);
 	}
-	resize(MatrixTempStorage.data, oldSize);
+	SP_MATRIX_PROFILE_END();
 }
 
 template<SP_MATRIX_T(M1), SP_MATRIX_T(M2)>
 void pinvert(M1 &&dest, M2 &&A) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"pinvert", 2.0*rows(A)*cols(A)*min(rows(A), cols(A)) + 2.0*min(rows(A), cols(A))*min(rows(A), cols(A))*min(rows(A), cols(A)),
+		2*rows(A)*cols(A)*sizeof(typename std::decay_t<M1>::ValueType)
+	);
 	if (rows(A) > cols(A)){
 		size_t length= cols(A);
 
@@ -542,7 +1732,7 @@ void pinvert(M1 &&dest, M2 &&A) noexcept{
 		// 				dest(i, j) -= TempStorage[j*length+k] * dest(i, k);
 		// 		}
 
-		// 		for (size_t j=length+1; j!=(size_t)-1; --j) {
+		// 		for (size_t j=length-1; j!=(size_t)-1; --j){
 		// 			for (size_t k = j+1; k!=length; ++k)
 		// 				dest(i, j) -= TempStorage[j*length+k] * dest(i, k);
 
@@ -558,6 +1748,7 @@ void pinvert(M1 &&dest, M2 &&A) noexcept{
 		invert(dest, A*tr(A));
 		dest = tr(A) * cp(dest);
 	}
+	SP_MATRIX_PROFILE_END();
 }
 
 
@@ -573,10 +1764,18 @@ auto trace(M &&A) noexcept{
 
 template<SP_MATRIX_T(M)>
 auto determinant(M &&A) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"determinant", 2.0/3.0*rows(A)*rows(A)*rows(A),
+		rows(A)*cols(A)*sizeof(typename std::decay_t<M>::ValueType)
+	);
 	SP_MATRIX_ERROR(rows(A) != cols(A), "only square matrix can have a determinant");
 	size_t length = rows(A);
 	
-	if constexpr (std::is_rvalue_reference_v<M>){
+	if constexpr (IsExact<typename std::decay_t<M>::ValueType>){
+		auto result = priv__::exact_determinant(A);
+		SP_MATRIX_PROFILE_END();
+		return result;
+	} else if constexpr (std::is_rvalue_reference_v<M>){
 		typename std::decay_t<M>::ValueType result = typename std::decay_t<M>::ValueType{1};
 		typename std::decay_t<M>::ValueType factor1, factor2;
 		if constexpr (std::decay_t<M>::RowMajor){
@@ -620,7 +1819,9 @@ auto determinant(M &&A) noexcept{
 				}
 			}
 		}
-		return result * A(length-1, length-1);
+		result *= A(length-1, length-1);
+		SP_MATRIX_PROFILE_END();
+		return result;
 	} else{
 		size_t oldSize = len(MatrixTempStorage.data);
 		expand_back(
@@ -629,7 +1830,7 @@ auto determinant(M &&A) noexcept{
 		);
 		typename std::decay_t<M>::ValueType *TempStorage = (
 			typename std::decay_t<M>::ValueType *
-		)beg(MatrixTempStorage.data) + oldSize;
+		)(beg(MatrixTempStorage.data) + oldSize);
 
 		{
 			typename std::decay_t<M>::ValueType *I = TempStorage;
@@ -665,10 +1866,108 @@ auto determinant(M &&A) noexcept{
 		result *= TempStorage[length*length-1];
 		
 		resize(MatrixTempStorage.data, oldSize);
+		SP_MATRIX_PROFILE_END();
 		return result;
 	}
 }
 
+template<class T>
+struct LogDeterminantRes{ T value; int8_t sign; };	// determinant equals sign * exp(value)
+
+namespace priv__{
+
+template<class T, class F>
+LogDeterminantRes<T> log_determinant_eliminate(F &&at, size_t length) noexcept{
+	LogDeterminantRes<T> res{(T)0, 1};
+	for (size_t i=0; i!=length; ++i){
+		{
+			size_t j = i;
+			for (size_t k=i+1; k!=length; ++k)	// find row with max value
+				j = abs(at(k, i))>abs(at(j, i)) ? k : j;
+			if (j != i){
+				for (size_t k=i; k!=length; ++k)	// exchange top row with row with max value
+					swap(at(i, k), at(j, k));
+				res.sign = -res.sign;
+			}
+		}
+		T factor1 = at(i, i);
+		if (factor1 == (T)0) return LogDeterminantRes<T>{-(T)INFINITY, 0};
+		if (factor1 < (T)0) res.sign = -res.sign;
+		res.value += log(abs(factor1));
+		for (size_t j=i+1; j!=length; ++j){
+			T factor2 = at(j, i) / factor1;
+			for (size_t k=i+1; k!=length; ++k)
+				at(j, k) -= at(i, k) * factor2;
+		}
+	}
+	return res;
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+template<SP_MATRIX_T(M)>
+auto log_determinant(M &&A) noexcept{
+	SP_MATRIX_PROFILE_BEGIN(
+		"log_determinant", 2.0/3.0*rows(A)*rows(A)*rows(A),
+		rows(A)*cols(A)*sizeof(typename std::decay_t<M>::ValueType)
+	);
+	SP_MATRIX_ERROR(rows(A) != cols(A), "only square matrix can have a determinant");
+	typedef typename std::decay_t<M>::ValueType T;
+	size_t length = rows(A);
+
+	if constexpr (std::is_rvalue_reference_v<M>){
+		LogDeterminantRes<T> res = priv__::log_determinant_eliminate<T>(
+			[&](size_t i, size_t j) -> T &{ return A(i, j); }, length
+		);
+		SP_MATRIX_PROFILE_END();
+		return res;
+	} else{
+		size_t oldSize = len(MatrixTempStorage.data);
+		expand_back(MatrixTempStorage.data, (length*length * sizeof(T) + 7) / 8);
+		T *TempStorage = (T *)(beg(MatrixTempStorage.data) + oldSize);
+
+		for (size_t i=0; i!=length; ++i)
+			for (size_t j=0; j!=length; ++j)
+				TempStorage[i*length+j] = A(i, j);
+		LogDeterminantRes<T> res = priv__::log_determinant_eliminate<T>(
+			[=](size_t i, size_t j) -> T &{ return TempStorage[i*length+j]; }, length
+		);
+
+		resize(MatrixTempStorage.data, oldSize);
+		SP_MATRIX_PROFILE_END();
+		return res;
+	}
+}
+
+template<SP_MATRIX_T(M), class Cont>
+auto lup_log_determinant(M &&LU, const Cont &permuts) noexcept{
+	SP_MATRIX_ERROR(rows(LU) != cols(LU), "only square matrix can have a determinant");
+	SP_MATRIX_ERROR(rows(LU) != len(permuts),
+		"permutaton array's size must be equal to number of rows of decomposed matrix"
+	);
+	typedef typename std::decay_t<M>::ValueType T;
+	LogDeterminantRes<T> res{(T)0, (int8_t)(priv__::permutation_parity(permuts) ? -1 : 1)};
+	for (size_t i=0; i!=rows(LU); ++i){
+		T pivot = LU(i, i);
+		if (pivot == (T)0) return LogDeterminantRes<T>{-(T)INFINITY, 0};
+		if (pivot < (T)0) res.sign = -res.sign;
+		res.value += log(abs(pivot));
+	}
+	return res;
+}
+
+// the decomposed matrix is positive definite, so the sign is always positive
+template<SP_MATRIX_T(M)>
+auto cholesky_log_determinant(M &&L) noexcept{
+	SP_MATRIX_ERROR(rows(L) != cols(L), "only square matrix can have a determinant");
+	typedef typename std::decay_t<M>::ValueType T;
+	LogDeterminantRes<T> res{(T)0, 1};
+	for (size_t i=0; i!=rows(L); ++i)
+		res.value += log(L(i, i));
+	res.value *= (T)2;
+	return res;
+}
+
 template<SP_MATRIX_T(M)>
 auto minor(M &&A, size_t row, size_t col) noexcept{
 	SP_MATRIX_ERROR(rows(A) != cols(A), "only square matrix can have a minor");
@@ -742,7 +2041,7 @@ auto minor(M &&A, size_t row, size_t col) noexcept{
 		);
 		typename std::decay_t<M>::ValueType *TempStorage = (
 			typename std::decay_t<M>::ValueType *
-		)beg(MatrixTempStorage.data) + oldSize;
+		)(beg(MatrixTempStorage.data) + oldSize);
 
 		{
 			typename std::decay_t<M>::ValueType *I = TempStorage;
@@ -798,6 +2097,73 @@ auto cofactor(M &&A, size_t row, size_t col) noexcept{
 
 
 
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2), class Cont>
+void lup_adjugate(M1 &&dest, M2 &&LU, const Cont &permuts) noexcept{
+	SP_MATRIX_ERROR(rows(LU) != cols(LU), "only square matrix can have an adjugate");
+	SP_MATRIX_ERROR(rows(LU) != len(permuts),
+		"permutaton array's size must be equal to number of rows of decomposed matrix"
+	);
+	typedef typename std::decay_t<M1>::ValueType T;
+	size_t length = rows(LU);
+
+	T det = priv__::permutation_parity(permuts) ? (T)-1 : (T)1;
+	for (size_t i=0; i!=length; ++i) det *= LU(i, i);
+	SP_MATRIX_ERROR(det == (T)0, "adjugate of singular matrix cannot be computed from its lu decomposition");
+
+	resize(dest, length, length);
+	priv__::lu_adjugate_solve<false>(dest, LU, permuts, length, det);
+}
+
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2), class Cont>
+void lup_cofactors(M1 &&dest, M2 &&LU, const Cont &permuts) noexcept{
+	SP_MATRIX_ERROR(rows(LU) != cols(LU), "only square matrix can have cofactors");
+	SP_MATRIX_ERROR(rows(LU) != len(permuts),
+		"permutaton array's size must be equal to number of rows of decomposed matrix"
+	);
+	typedef typename std::decay_t<M1>::ValueType T;
+	size_t length = rows(LU);
+
+	T det = priv__::permutation_parity(permuts) ? (T)-1 : (T)1;
+	for (size_t i=0; i!=length; ++i) det *= LU(i, i);
+	SP_MATRIX_ERROR(det == (T)0, "cofactors of singular matrix cannot be computed from its lu decomposition");
+
+	resize(dest, length, length);
+	priv__::lu_adjugate_solve<true>(dest, LU, permuts, length, det);
+}
+
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2)>
+void adjugate(M1 &&dest, M2 &&A) noexcept{
+	SP_MATRIX_ERROR(rows(A) != cols(A), "only square matrix can have an adjugate");
+	typedef typename std::decay_t<M2>::ValueType T;
+	if (rows(A) == 1){
+		resize(dest, 1, 1);
+		dest(0, 0) = unit<T>();
+		return;
+	}
+	if constexpr (IsExact<T>)
+		priv__::exact_adjugate<false>(dest, A);
+	else
+		priv__::float_adjugate<false>(dest, A);
+}
+
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2)>
+void cofactors(M1 &&dest, M2 &&A) noexcept{
+	SP_MATRIX_ERROR(rows(A) != cols(A), "only square matrix can have cofactors");
+	typedef typename std::decay_t<M2>::ValueType T;
+	if (rows(A) == 1){
+		resize(dest, 1, 1);
+		dest(0, 0) = unit<T>();
+		return;
+	}
+	if constexpr (IsExact<T>)
+		priv__::exact_adjugate<true>(dest, A);
+	else
+		priv__::float_adjugate<true>(dest, A);
+}
+
+
+
+
 
 
 template<SP_MATRIX_T(M)>
@@ -940,21 +2306,25 @@ void permute(V &&dest, const Cont &permuts) noexcept{
 		"size of permuted vecror must be the same as the size of permutation array"
 	);
 
-	size_t length= len(permuts);
+	size_t length = len(permuts);
+	size_t words = (length + 63) / 64;
 	size_t oldSize = len(MatrixTempStorage.data);
-	expand_back(MatrixTempStorage.data, (length* sizeof(typename Cont::ValueType) + 7) / 8);
-	typename Cont::ValueType *TempStorage = (typename Cont::ValueType *)beg(MatrixTempStorage.data) + oldSize;
-	
-	for (size_t i=0; i!=length; ++i) TempStorage[i] = beg(permuts)[i];
-	
-	for (size_t i=0; i!=length; ++i)
-		while (TempStorage[i] != i){
-			size_t swapIndex = TempStorage[i];
-			iswap(TempStorage+i, TempStorage+swapIndex);
-			swap(dest[swapIndex], dest[i]);
+	expand_back(MatrixTempStorage.data, words);
+	uint64_t *visited = beg(MatrixTempStorage.data) + oldSize;
+	for (size_t i=0; i!=words; ++i) visited[i] = 0;
+
+	for (size_t i=0; i!=length; ++i){
+		if (visited[i/64] >> (i%64) & 1) continue;
+		visited[i/64] |= (uint64_t)1 << (i%64);
+		typename std::decay_t<V>::ValueType held = dest[i];
+		for (size_t j=(size_t)permuts[i]; j!=i; j=(size_t)permuts[j]){
+			visited[j/64] |= (uint64_t)1 << (j%64);
+			swap(held, dest[j]);
 		}
+		dest[i] = held;
+	}
 
-	resize(MatrixTempStorage.data, oldSize);	
+	resize(MatrixTempStorage.data, oldSize);
 }
 
 
@@ -0,0 +1,236 @@
+#pragma once
+
+#include "Storage.hpp"
+
+namespace sp{
+
+// OUT OF CORE OPERATIONS
+// The operands are row major matrices, usually mapped files, which don't have to fit into
+// memory. They are streamed through tiles copied into workspace of given size, pages of the
+// next tiles are requested with madvise before the current ones are processed and the results
+// are written back tile by tile. Every copied byte is counted in the statistics, so the cost
+// of an operation can be checked against the bandwidth of the storage.
+//
+// The product keeps one tile of each operand. The lu decomposition is left looking: panel of
+// columns is read, the pivots and updates of previous panels are applied to it, then it's
+// factorized in memory and written back, so only the panel and a tile of lower triangle have
+// to fit into the budget.
+
+struct OutOfCoreStats{
+	uint64_t bytesRead = 0;
+	uint64_t bytesWritten = 0;
+};
+
+
+
+namespace priv__{
+
+// asks the kernel to start reading pages of the tile
+template<class T>
+void prefetch_tile(const T *base, size_t ld, size_t height, size_t width) noexcept{
+	if (!height || !width) return;
+	static const uintptr_t PageMask = ~(uintptr_t)(sysconf(_SC_PAGESIZE) - 1);
+	if ((ld - width) * sizeof(T) < ~PageMask + 1){	// gaps are shorter than a page
+		uintptr_t first = (uintptr_t)base & PageMask;
+		uintptr_t last = (uintptr_t)(base + (height-1)*ld + width);
+		madvise((void *)first, last - first, MADV_WILLNEED);
+	} else{
+		for (size_t i=0; i!=height; ++i){
+			uintptr_t first = (uintptr_t)(base + i*ld) & PageMask;
+			uintptr_t last = (uintptr_t)(base + i*ld + width);
+			madvise((void *)first, last - first, MADV_WILLNEED);
+		}
+	}
+}
+
+template<class T>
+void copy_tile(T *dest, size_t ldd, const T *src, size_t lds, size_t height, size_t width) noexcept{
+	for (size_t i=0; i!=height; ++i)
+		memcpy(dest + i*ldd, src + i*lds, width*sizeof(T));
+}
+
+template<class T, class Al>
+T *alloc_workspace_bytes(Al &allocator, Memblock &blk, size_t bytes) noexcept{
+	if constexpr (Al::Alignment)
+		blk = alloc(allocator, bytes);
+	else
+		blk = alloc(allocator, bytes, alignof(T) > alignof(size_t) ? alignof(T) : alignof(size_t));
+	return (T *)blk.ptr;
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+
+
+// puts the product of matrices into the destination matrix, three square tiles of elements
+// fit into specified number of bytes, workspace is taken from the allocator, returns true if
+// the allocation failed
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2), SP_MATRIX_T(M3), class Al>
+bool tiled_mul(
+	M1 &&dest, M2 &&A, M3 &&B, size_t memoryBudget, Al &allocator, OutOfCoreStats &stats
+) noexcept{
+	typedef std::decay_t<M1> D;
+	typedef typename D::ValueType T;
+	static_assert(
+		D::RowMajor && std::decay_t<M2>::RowMajor && std::decay_t<M3>::RowMajor &&
+		priv__::HasLeadDim<D> && priv__::HasLeadDim<std::decay_t<M2>> && priv__::HasLeadDim<std::decay_t<M3>>,
+		"out of core product works on row major matrices stored in memory"
+	);
+	SP_MATRIX_ERROR(cols(A) != rows(B), "multiplied matrices must have matching inner dimensions");
+	resize(dest, rows(A), cols(B));
+	size_t m = rows(A), k = cols(A), n = cols(B);
+	size_t b = int_sqrt(memoryBudget / (3*sizeof(T)));
+	if (b == 0) b = 1;
+
+	Memblock blk;
+	T *At = priv__::alloc_workspace_bytes<T>(allocator, blk, 3*b*b * sizeof(T));
+	if (!At) return true;
+	T *Bt = At + b*b;
+	T *Ct = Bt + b*b;
+
+	const T *pa = beg(A), *pb = beg(B);
+	T *pc = beg(dest);
+	size_t lda = lead_dim(A), ldb = lead_dim(B), ldc = lead_dim(dest);
+
+	for (size_t i0=0; i0<m; i0+=b){
+		size_t h = min(b, m-i0);
+		for (size_t j0=0; j0<n; j0+=b){
+			size_t w = min(b, n-j0);
+			for (size_t i=0; i!=h*w; ++i) Ct[i] = T{};
+
+			for (size_t p0=0; p0<k; p0+=b){
+				size_t d = min(b, k-p0);
+				// next tiles of the same output tile, or the first ones of the next output tile
+				if (p0+b < k){
+					priv__::prefetch_tile(pa + i0*lda + p0+b, lda, h, min(b, k-p0-b));
+					priv__::prefetch_tile(pb + (p0+b)*ldb + j0, ldb, min(b, k-p0-b), w);
+				} else if (j0+b < n){
+					priv__::prefetch_tile(pa + i0*lda, lda, h, min(b, k));
+					priv__::prefetch_tile(pb + j0+b, ldb, min(b, k), min(b, n-j0-b));
+				} else if (i0+b < m){
+					priv__::prefetch_tile(pa + (i0+b)*lda, lda, min(b, m-i0-b), min(b, k));
+					priv__::prefetch_tile(pb, ldb, min(b, k), min(b, n));
+				}
+				priv__::copy_tile(At, d, pa + i0*lda + p0, lda, h, d);
+				priv__::copy_tile(Bt, w, pb + p0*ldb + j0, ldb, d, w);
+				stats.bytesRead += (h*d + d*w) * sizeof(T);
+				priv__::gemm_acc(Ct, w, At, d, Bt, w, h, d, w);
+			}
+
+			priv__::copy_tile(pc + i0*ldc + j0, ldc, Ct, w, h, w);
+			stats.bytesWritten += h*w * sizeof(T);
+		}
+	}
+
+	free(allocator, blk);
+	return false;
+}
+
+
+
+// applies in place lu decomposition with partial pivoting, the result and permutations are the
+// same as from lup_decompose, panel of all rows and square tile of elements fit into specified
+// number of bytes, workspace is taken from the allocator, returns true if the allocation failed
+template<SP_MATRIX_T(M), class Cont, class Al>
+bool tiled_lup_decompose(
+	M &&dest, Cont &permuts, size_t memoryBudget, Al &allocator, OutOfCoreStats &stats
+) noexcept{
+	typedef std::decay_t<M> D;
+	typedef typename D::ValueType T;
+	static_assert(
+		D::RowMajor && priv__::HasLeadDim<D>,
+		"out of core lu decomposition works on row major matrix stored in memory"
+	);
+	SP_MATRIX_ERROR(rows(dest) != cols(dest), "only square matrix can be decomposed out of core");
+	size_t n = rows(dest);
+	resize(permuts, n);
+	for (size_t i=0; i!=n; ++i) permuts[i] = i;
+	if (!n) return false;
+
+	// panel of n x b and tile of b x b: b*b + n*b <= budget
+	size_t budget = memoryBudget / sizeof(T);
+	size_t b = (int_sqrt(n*n + 4*budget) - n) / 2;
+	if (b == 0) b = 1;
+	if (b > n) b = n;
+
+	Memblock blk;
+	size_t swapsOffset = ((n*b + b*b)*sizeof(T) + alignof(size_t) - 1) & ~(alignof(size_t) - 1);
+	T *panel = priv__::alloc_workspace_bytes<T>(allocator, blk, swapsOffset + n*sizeof(size_t));
+	if (!panel) return true;
+	T *tile = panel + n*b;
+	size_t *swaps = (size_t *)(blk.ptr + swapsOffset);	// row exchanged with i-th row
+
+	T *data = beg(dest);
+	size_t ld = lead_dim(dest);
+
+	for (size_t j0=0; j0<n; j0+=b){
+		size_t w = min(b, n-j0);
+		priv__::copy_tile(panel, w, data + j0, ld, n, w);
+		stats.bytesRead += n*w * sizeof(T);
+		if (j0+w < n) priv__::prefetch_tile(data + j0+w, ld, n, min(b, n-j0-w));
+
+		for (size_t i=0; i!=j0; ++i)
+			if (swaps[i] != i)
+				for (size_t c=0; c!=w; ++c) swap(panel[i*w + c], panel[swaps[i]*w + c]);
+
+		// updates of previous panels
+		for (size_t k0=0; k0<j0; k0+=b){
+			priv__::copy_tile(tile, b, data + k0*ld + k0, ld, b, b);
+			stats.bytesRead += b*b * sizeof(T);
+			for (size_t r=1; r!=b; ++r)
+				for (size_t q=0; q!=r; ++q){
+					T l = tile[r*b + q];
+					for (size_t c=0; c!=w; ++c) panel[(k0+r)*w + c] -= l * panel[(k0+q)*w + c];
+				}
+
+			for (size_t r0=k0+b; r0<n; r0+=b){
+				size_t h = min(b, n-r0);
+				if (r0+b < n)
+					priv__::prefetch_tile(data + (r0+b)*ld + k0, ld, min(b, n-r0-b), b);
+				else if (k0+b < j0)
+					priv__::prefetch_tile(data + (k0+b)*ld + k0+b, ld, b, b);
+				priv__::copy_tile(tile, b, data + r0*ld + k0, ld, h, b);
+				stats.bytesRead += h*b * sizeof(T);
+				priv__::gemm_acc(panel + r0*w, w, tile, b, panel + k0*w, w, h, b, w, -unit<T>());
+			}
+		}
+
+		// factorization of the panel
+		for (size_t c=0; c!=w; ++c){
+			size_t col = j0 + c;
+			size_t p = col;
+			for (size_t r=col+1; r!=n; ++r)
+				if (abs(panel[r*w + c]) > abs(panel[p*w + c])) p = r;
+			swaps[col] = p;
+			if (p != col){
+				for (size_t q=0; q!=w; ++q) swap(panel[col*w + q], panel[p*w + q]);
+				swap(permuts[col], permuts[p]);
+			}
+			T pivot = panel[col*w + c];
+			for (size_t r=col+1; r!=n; ++r){
+				T l = panel[r*w + c] / pivot;
+				panel[r*w + c] = l;
+				for (size_t q=c+1; q!=w; ++q) panel[r*w + q] -= l * panel[col*w + q];
+			}
+		}
+
+		priv__::copy_tile(data + j0, ld, panel, w, n, w);
+		stats.bytesWritten += n*w * sizeof(T);
+
+		// pivots of the panel are applied to columns of previous panels
+		if (j0)
+			for (size_t i=j0; i!=j0+w; ++i)
+				if (swaps[i] != i){
+					T *r1 = data + i*ld;
+					T *r2 = data + swaps[i]*ld;
+					for (size_t c=0; c!=j0; ++c) swap(r1[c], r2[c]);
+					stats.bytesRead += 2*j0 * sizeof(T);
+					stats.bytesWritten += 2*j0 * sizeof(T);
+				}
+	}
+
+	free(allocator, blk);
+	return false;
+}
+
+} // END OF NAMESPACE ///////////////////////////////////////////////////////////////////////////////////////
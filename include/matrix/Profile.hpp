@@ -0,0 +1,310 @@
+#pragma once
+
+#include "SPL/Utils.hpp"
+#include "SPL/Allocators.hpp"
+#include "SPL/Arrays.hpp"
+
+#include <stdio.h>
+#include <inttypes.h>
+
+// PROFILING
+// When SP_MATRIX_PROFILE is defined before the library is included, operations count their
+// calls, floating point operations, bytes of operands and results, and wall time, expression
+// assignments are counted under the type of the expression. Temporary storage of expressions
+// counts its reallocations and the largest size it reached, and every operation records how
+// much of it was used during the call. Every call is also kept as an event, profile_trace
+// writes them in chrome trace format, which can be opened in chrome://tracing or perfetto.
+// Without the macro nothing is counted and the reporting functions do nothing.
+//
+// Times are inclusive, operation which calls other ones counts their time too. Flops of
+// expression assignments aren't known, they are counted as zero.
+//
+// An operation opens its counter with SP_MATRIX_PROFILE_BEGIN (SP_MATRIX_PROFILE_ASSIGN_BEGIN for
+// expression assignments) and has to close it with SP_MATRIX_PROFILE_END before every return.
+
+#ifdef SP_MATRIX_PROFILE
+	#include <string.h>
+	#include <time.h>
+	#include <pthread.h>
+	#define SP_MATRIX_PROFILE_BEGIN(name, flops, bytes) \
+		static const uint32_t spProfileId__ = ::sp::priv__::profile_register("", name); \
+		::sp::priv__::ProfileScope spProfileScope__ = \
+			::sp::priv__::profile_begin(spProfileId__, (double)(flops), (double)(bytes), SIZE_MAX)
+	#define SP_MATRIX_PROFILE_ASSIGN_BEGIN(op, M, bytes) \
+		static const uint32_t spProfileId__ = \
+			::sp::priv__::profile_register(op, ::sp::priv__::profile_type_name<M>()); \
+		::sp::priv__::ProfileScope spProfileScope__ = ::sp::priv__::profile_begin( \
+			spProfileId__, 0.0, (double)(bytes), ::sp::MatrixTempStorage.stack_pos \
+		)
+	#define SP_MATRIX_PROFILE_END() ::sp::priv__::profile_end(spProfileScope__)
+	#define SP_MATRIX_PROFILE_FLOPS(count) spProfileScope__.flops += (double)(count)
+#else
+	#define SP_MATRIX_PROFILE_BEGIN(name, flops, bytes)
+	#define SP_MATRIX_PROFILE_ASSIGN_BEGIN(op, M, bytes)
+	#define SP_MATRIX_PROFILE_END()
+	#define SP_MATRIX_PROFILE_FLOPS(count)
+#endif
+
+namespace sp{
+
+constexpr size_t ProfileMaxEvents = 1 << 20;	// later events are dropped, the counters still run
+
+
+
+#ifdef SP_MATRIX_PROFILE
+
+namespace priv__{
+
+struct ProfileCounter{
+	char *name;
+	uint64_t calls;
+	double flops;
+	double bytes;
+	double seconds;
+	uint64_t scratch;	// the largest number of bytes of temporary storage used by a call
+};
+
+struct ProfileEvent{
+	uint32_t id;
+	uint32_t thread;
+	double begin;	// microseconds since the start of the program
+	double duration;
+	double flops;
+	double bytes;
+	uint64_t scratch;
+};
+
+inline double profile_clock() noexcept{	// microseconds of the monotonic clock
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec*1e6 + t.tv_nsec*1e-3;
+}
+
+struct ProfileState{
+	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	DynamicArray<ProfileCounter, MallocAllocator<>> counters = {{nullptr, 0}, 0, nullptr};
+	DynamicArray<ProfileEvent, MallocAllocator<>> events = {{nullptr, 0}, 0, nullptr};
+	uint64_t droppedEvents = 0;
+	uint32_t threadCount = 0;
+	uint64_t tempReallocations = 0;
+	uint64_t tempHighWater = 0;
+	size_t tempLen = 0;
+	size_t tempPeak = 0;	// largest length of temporary storage since the innermost call began
+	double start = profile_clock();
+};
+
+inline ProfileState profileState;
+inline thread_local uint32_t profileThread = UINT32_MAX;
+
+
+
+inline void *temp_storage_realloc(void *ptr, size_t size) noexcept{
+	++profileState.tempReallocations;
+	if (size > profileState.tempHighWater) profileState.tempHighWater = size;
+	return ::realloc(ptr, size);
+}
+
+inline void *temp_storage_malloc(size_t size) noexcept{ return temp_storage_realloc(nullptr, size); }
+
+inline void temp_storage_free(void *ptr) noexcept{ ::free(ptr); }
+
+} // END OF NAMESPACE PRIV //////////
+
+using TempStorageAllocator = MallocAllocator<
+	priv__::temp_storage_malloc, priv__::temp_storage_free, priv__::temp_storage_realloc
+>;
+
+// every change of length of temporary storage passes through these two, so calls can see how
+// much of it they used
+inline bool expand_back(DynamicArray<uint64_t, TempStorageAllocator> &arr, size_t amount) noexcept{
+	bool res = expand_back<uint64_t, TempStorageAllocator>(arr, amount);
+	priv__::profileState.tempLen = len(arr);
+	if (len(arr) > priv__::profileState.tempPeak) priv__::profileState.tempPeak = len(arr);
+	return res;
+}
+
+inline bool resize(DynamicArray<uint64_t, TempStorageAllocator> &arr, size_t size) noexcept{
+	bool res = resize<uint64_t, TempStorageAllocator>(arr, size);
+	priv__::profileState.tempLen = len(arr);
+	if (len(arr) > priv__::profileState.tempPeak) priv__::profileState.tempPeak = len(arr);
+	return res;
+}
+
+
+
+namespace priv__{
+
+// name of the type, taken out of the signature of this function
+template<class M>
+const char *profile_type_name() noexcept{
+	const char *name = strstr(__PRETTY_FUNCTION__, "M = ");
+	return name ? name + 4 : __PRETTY_FUNCTION__;
+}
+
+inline uint32_t profile_register(const char *prefix, const char *name) noexcept{
+	size_t prefixLen = strlen(prefix);
+	size_t nameLen = strcspn(name, ";]");
+	uint32_t id = UINT32_MAX;
+	pthread_mutex_lock(&profileState.mutex);
+	for (size_t i=0; i!=len(profileState.counters); ++i){
+		const char *s = profileState.counters[i].name;
+		if (!strncmp(s, prefix, prefixLen) && !strncmp(s+prefixLen, name, nameLen) && !s[prefixLen+nameLen]){
+			id = i;
+			break;
+		}
+	}
+	if (id == UINT32_MAX && !push(profileState.counters)){
+		char *copy = (char *)::malloc(prefixLen + nameLen + 1);
+		memcpy(copy, prefix, prefixLen);
+		memcpy(copy+prefixLen, name, nameLen);
+		copy[prefixLen + nameLen] = '\0';
+		back(profileState.counters) = ProfileCounter{copy, 0, 0.0, 0.0, 0.0, 0};
+		id = len(profileState.counters) - 1;
+	}
+	pthread_mutex_unlock(&profileState.mutex);
+	return id;
+}
+
+struct ProfileScope{
+	uint32_t id;
+	double flops;
+	double bytes;
+	size_t outerPeak;
+	size_t tempBase;
+	double begin;
+};
+
+// temporary storage above the base counts as used by the call, assignments pass the bottom of the
+// stack, so buffers of the expression filled before the assignment are counted too
+inline ProfileScope profile_begin(uint32_t id, double flops, double bytes, size_t tempBase) noexcept{
+	ProfileScope scope{
+		id, flops, bytes, profileState.tempPeak,
+		tempBase == SIZE_MAX ? profileState.tempLen : tempBase, 0.0
+	};
+	profileState.tempPeak = profileState.tempLen;
+	scope.begin = profile_clock() - profileState.start;
+	return scope;
+}
+
+inline void profile_end(const ProfileScope &scope) noexcept{
+	double duration = profile_clock() - profileState.start - scope.begin;
+	size_t peak = profileState.tempPeak;
+	uint64_t scratch = peak > scope.tempBase ? (peak - scope.tempBase) * sizeof(uint64_t) : 0;
+	profileState.tempPeak = max(scope.outerPeak, peak);
+	if (scope.id == UINT32_MAX) return;
+
+	pthread_mutex_lock(&profileState.mutex);
+	if (profileThread == UINT32_MAX) profileThread = profileState.threadCount++;
+	ProfileCounter &c = profileState.counters[scope.id];
+	++c.calls;
+	c.flops += scope.flops;
+	c.bytes += scope.bytes;
+	c.seconds += duration * 1e-6;
+	if (scratch > c.scratch) c.scratch = scratch;
+
+	if (len(profileState.events) == ProfileMaxEvents || push(profileState.events)){
+		++profileState.droppedEvents;
+	} else{
+		back(profileState.events) = ProfileEvent{
+			scope.id, profileThread, scope.begin, duration, scope.flops, scope.bytes, scratch
+		};
+	}
+	pthread_mutex_unlock(&profileState.mutex);
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+
+
+// prints counters of all operations, sorted by the total time
+inline void profile_report(FILE *out = stdout) noexcept{
+	using priv__::profileState;
+	pthread_mutex_lock(&profileState.mutex);
+	size_t count = len(profileState.counters);
+	uint32_t *order = (uint32_t *)::malloc(count * sizeof(uint32_t) + 1);
+	if (!order){
+		pthread_mutex_unlock(&profileState.mutex);
+		return;
+	}
+	for (size_t i=0; i!=count; ++i) order[i] = i;
+	for (size_t i=1; i<count; ++i)
+		for (size_t j=i; j && profileState.counters[order[j-1]].seconds<profileState.counters[order[j]].seconds; --j)
+			swap(order[j-1], order[j]);
+
+	fprintf(
+		out, "%10s %12s %10s %10s %10s %12s  %s\n",
+		"calls", "time [ms]", "GFLOP/s", "GB/s", "GFLOP", "scratch [B]", "operation"
+	);
+	for (size_t i=0; i!=count; ++i){
+		const priv__::ProfileCounter &c = profileState.counters[order[i]];
+		if (!c.calls) continue;
+		double seconds = c.seconds > 0.0 ? c.seconds : 1e-12;
+		fprintf(
+			out, "%10" PRIu64 " %12.3f %10.3f %10.3f %10.3f %12" PRIu64 "  %s\n",
+			c.calls, c.seconds*1e3, c.flops/seconds*1e-9,
+			c.bytes/seconds*1e-9, c.flops*1e-9, c.scratch, c.name
+		);
+	}
+	fprintf(
+		out, "temporary storage: %" PRIu64 " bytes at most, %" PRIu64 " reallocations\n",
+		profileState.tempHighWater, profileState.tempReallocations
+	);
+	if (profileState.droppedEvents)
+		fprintf(out, "%" PRIu64 " events were dropped\n", profileState.droppedEvents);
+	pthread_mutex_unlock(&profileState.mutex);
+	::free(order);
+}
+
+// writes recorded calls as chrome trace json, returns true if the file couldn't be written
+inline bool profile_trace(const char *path) noexcept{
+	using priv__::profileState;
+	FILE *file = fopen(path, "w");
+	if (!file) return true;
+	pthread_mutex_lock(&profileState.mutex);
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+	for (size_t i=0; i!=len(profileState.events); ++i){
+		const priv__::ProfileEvent &e = profileState.events[i];
+		fputs("{\"name\":\"", file);
+		for (const char *s=profileState.counters[e.id].name; *s; ++s){
+			if (*s=='"' || *s=='\\') fputc('\\', file);
+			fputc(*s, file);
+		}
+		fprintf(
+			file,
+			"\",\"cat\":\"matrix\",\"ph\":\"X\",\"pid\":0,\"tid\":%" PRIu32 ",\"ts\":%.3f,\"dur\":%.3f,"
+			"\"args\":{\"flops\":%.0f,\"bytes\":%.0f,\"scratch\":%" PRIu64 "}}%s\n",
+			e.thread, e.begin, e.duration, e.flops, e.bytes, e.scratch,
+			i+1 == len(profileState.events) ? "" : ","
+		);
+	}
+	fputs("]}\n", file);
+	pthread_mutex_unlock(&profileState.mutex);
+	return fclose(file) != 0;
+}
+
+// clears counters and recorded events, names of operations are kept
+inline void profile_reset() noexcept{
+	using priv__::profileState;
+	pthread_mutex_lock(&profileState.mutex);
+	for (size_t i=0; i!=len(profileState.counters); ++i){
+		priv__::ProfileCounter &c = profileState.counters[i];
+		c = priv__::ProfileCounter{c.name, 0, 0.0, 0.0, 0.0, 0};
+	}
+	resize(profileState.events, 0);
+	profileState.droppedEvents = 0;
+	profileState.tempReallocations = 0;
+	profileState.tempHighWater = 0;
+	pthread_mutex_unlock(&profileState.mutex);
+}
+
+#else
+
+using TempStorageAllocator = MallocAllocator<>;
+
+inline void profile_report(FILE *out = stdout) noexcept{}
+inline bool profile_trace(const char *path) noexcept{ return false; }
+inline void profile_reset() noexcept{}
+
+#endif
+
+} // END OF NAMESPACE ///////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,624 @@
+#pragma once
+
+#include "MixedExpr.hpp"
+
+#include <string.h>
+
+namespace sp{
+
+// EXPRESSION PROGRAMS
+// evaluate(assign(x, A*v + b), assign(y, apply<f>(A*v))) runs several assignments together.
+// Products in the expressions become cached nodes. Product which appears more than once, with
+// the same operands, or which is an operand of another product is computed once into the
+// temporary storage before the assignments run, other ones are computed per element as in
+// ordinary assignments. Assignments whose results have the same dimensions are then done in
+// a single pass over the elements.
+//
+// Assignment which reads destination of an earlier one, or writes what an earlier one reads,
+// starts a new stage. Stages run one after another, so every assignment sees the results of
+// the previous ones. Expressions keep their operands by reference, so an expression reads a
+// matrix if the address of the matrix is stored in it. Cached nodes are compared the same way,
+// byte by byte, equal products can be missed, but different ones are never taken as equal.
+//
+// Nodes of arithmetic expressions are looked into: sums, differences, element wise, scalar and
+// outer operations, transposes, products and reinterpretations of vectors. Products under
+// other nodes are evaluated as usual.
+
+
+
+template<class M>
+struct MatrixExprCached{
+	static constexpr StupidMatrixFlagType MatrixFlag{};
+	M arg;
+	size_t data_index;	// SIZE_MAX while the product isn't computed into the temporary storage
+
+	typedef std::remove_reference_t<M> Arg;
+
+	typedef typename Arg::ValueType ValueType;
+	constexpr static bool RowMajor = Arg::RowMajor;
+	constexpr static bool UndefMajor = Arg::UndefMajor;
+	constexpr static bool UsesBuffer = true;
+	constexpr static size_t StaticRows = priv__::StaticRowsOf<Arg>;
+	constexpr static size_t StaticCols = priv__::StaticColsOf<Arg>;
+
+	SP_CI ValueType operator ()(size_t r, size_t c) const noexcept{
+		if (data_index == SIZE_MAX) return arg(r, c);
+		return ((const ValueType *)(beg(MatrixTempStorage.data) + data_index))[r*cols(arg) + c];
+	}
+};
+
+template<class M>
+SP_CSI size_t rows(const MatrixExprCached<M> &m) noexcept{ return rows(m.arg); }
+
+template<class M>
+SP_CSI size_t cols(const MatrixExprCached<M> &m) noexcept{ return cols(m.arg); }
+
+template<class M>
+SP_CSI size_t len(const MatrixExprCached<M> &m) noexcept{ return rows(m.arg) * cols(m.arg); }
+
+
+
+template<class V>
+struct VectorExprCached{
+	static constexpr StupidVectorFlagType VectorFlag{};
+	V arg;
+	size_t data_index;
+
+	typedef std::remove_reference_t<V> Arg;
+
+	typedef typename Arg::ValueType ValueType;
+	constexpr static bool UsesBuffer = true;
+	constexpr static size_t StaticLen = priv__::StaticLenOf<Arg>;
+
+	SP_CI ValueType operator [](size_t i) const noexcept{
+		if (data_index == SIZE_MAX) return arg[i];
+		return ((const ValueType *)(beg(MatrixTempStorage.data) + data_index))[i];
+	}
+};
+
+template<class V>
+SP_CSI size_t len(const VectorExprCached<V> &v) noexcept{ return len(v.arg); }
+
+
+
+namespace priv__{
+
+template<class T, class = void>
+constexpr bool IsVectorNode = false;
+
+template<class T>
+constexpr bool IsVectorNode<T, std::void_t<decltype(T::VectorFlag)>> = true;
+
+// expression with products replaced by cached nodes, types without products are kept
+template<class E>
+struct ProgramRewrite{
+	typedef E Type;
+
+	template<class F>
+	SP_SI void visit(Type &, F &&, bool) noexcept{}
+};
+
+template<class C>
+constexpr bool ProgramChanged =
+		!std::is_same_v<typename ProgramRewrite<std::decay_t<C>>::Type, std::decay_t<C>>;
+
+// operand of rewritten node, unchanged operands are kept as they were, also by reference
+template<class C>
+using ProgramMember = std::conditional_t<
+	ProgramChanged<C>, typename ProgramRewrite<std::decay_t<C>>::Type, C
+>;
+
+template<class C, class X>
+SP_SI ProgramMember<C> program_member(const X &x) noexcept{
+	if constexpr (ProgramChanged<C>)
+		return ProgramRewrite<std::decay_t<C>>::apply(x);
+	else
+		return (C)x;
+}
+
+// calls the function for every cached node below, children first, the flag tells if the node
+// is an operand of a product
+template<class C, class F>
+SP_SI void program_visit(ProgramMember<C> &x, F &&f, bool inProduct) noexcept{
+	if constexpr (ProgramChanged<C>) ProgramRewrite<std::decay_t<C>>::visit(x, f, inProduct);
+}
+
+
+
+// nodes whose members are their operands, in the order of the template arguments
+
+template<template<class, class> class N, class A, class B>
+struct ProgramRewrite2{
+	typedef N<ProgramMember<A>, ProgramMember<B>> Type;
+
+	SP_SI Type apply(const N<A, B> &e) noexcept{
+		const auto &[a, b] = e;
+		return Type{program_member<A>(a), program_member<B>(b)};
+	}
+
+	template<class F>
+	SP_SI void visit(Type &e, F &&f, bool inProduct) noexcept{
+		auto &[a, b] = e;
+		program_visit<A>(a, f, inProduct);
+		program_visit<B>(b, f, inProduct);
+	}
+};
+
+template<template<class, class, class> class N, class A, class B, class C>
+struct ProgramRewrite3{
+	typedef N<ProgramMember<A>, ProgramMember<B>, ProgramMember<C>> Type;
+
+	SP_SI Type apply(const N<A, B, C> &e) noexcept{
+		const auto &[a, b, c] = e;
+		return Type{program_member<A>(a), program_member<B>(b), program_member<C>(c)};
+	}
+
+	template<class F>
+	SP_SI void visit(Type &e, F &&f, bool inProduct) noexcept{
+		auto &[a, b, c] = e;
+		program_visit<A>(a, f, inProduct);
+		program_visit<B>(b, f, inProduct);
+		program_visit<C>(c, f, inProduct);
+	}
+};
+
+template<template<class, auto> class N, class A, auto Op>
+struct ProgramRewriteStat1{
+	typedef N<ProgramMember<A>, Op> Type;
+
+	SP_SI Type apply(const N<A, Op> &e) noexcept{ return Type{program_member<A>(e.arg)}; }
+
+	template<class F>
+	SP_SI void visit(Type &e, F &&f, bool inProduct) noexcept{
+		program_visit<A>(e.arg, f, inProduct);
+	}
+};
+
+template<template<class, class, auto> class N, class A, class B, auto Op>
+struct ProgramRewriteStat2{
+	typedef N<ProgramMember<A>, ProgramMember<B>, Op> Type;
+
+	SP_SI Type apply(const N<A, B, Op> &e) noexcept{
+		const auto &[a, b] = e;
+		return Type{program_member<A>(a), program_member<B>(b)};
+	}
+
+	template<class F>
+	SP_SI void visit(Type &e, F &&f, bool inProduct) noexcept{
+		auto &[a, b] = e;
+		program_visit<A>(a, f, inProduct);
+		program_visit<B>(b, f, inProduct);
+	}
+};
+
+// products are kept in cached nodes
+template<template<class, class> class N, class A, class B, template<class> class Cached>
+struct ProgramRewriteProduct{
+	typedef ProgramRewrite2<N, A, B> Product;
+	typedef Cached<typename Product::Type> Type;
+
+	SP_SI Type apply(const N<A, B> &e) noexcept{ return Type{Product::apply(e), SIZE_MAX}; }
+
+	template<class F>
+	SP_SI void visit(Type &e, F &&f, bool inProduct) noexcept{
+		Product::visit(e.arg, f, true);
+		f(e, inProduct);
+	}
+};
+
+
+
+template<class B>
+struct ProgramRewrite<MatrixWrapper<B>>{
+	typedef std::conditional_t<
+		ProgramChanged<B>, typename ProgramRewrite<B>::Type, MatrixWrapper<B>
+	> Type;
+
+	SP_SI Type apply(const MatrixWrapper<B> &e) noexcept{ return ProgramRewrite<B>::apply(e); }
+
+	template<class F>
+	SP_SI void visit(Type &e, F &&f, bool inProduct) noexcept{
+		ProgramRewrite<B>::visit(e, f, inProduct);
+	}
+};
+
+template<class B>
+struct ProgramRewrite<VectorWrapper<B>>{
+	typedef std::conditional_t<
+		ProgramChanged<B>, typename ProgramRewrite<B>::Type, VectorWrapper<B>
+	> Type;
+
+	SP_SI Type apply(const VectorWrapper<B> &e) noexcept{ return ProgramRewrite<B>::apply(e); }
+
+	template<class F>
+	SP_SI void visit(Type &e, F &&f, bool inProduct) noexcept{
+		ProgramRewrite<B>::visit(e, f, inProduct);
+	}
+};
+
+template<class M, bool LV>
+struct ProgramRewrite<MatrixExprTranspose<M, LV>>{
+	typedef MatrixExprTranspose<ProgramMember<M>, LV> Type;
+
+	SP_SI Type apply(const MatrixExprTranspose<M, LV> &e) noexcept{
+		return Type{program_member<M>(e.arg)};
+	}
+
+	template<class F>
+	SP_SI void visit(Type &e, F &&f, bool inProduct) noexcept{
+		program_visit<M>(e.arg, f, inProduct);
+	}
+};
+
+template<class M, auto Op>
+struct ProgramRewrite<MatrixExprElStatUnaryOp<M, Op>> :
+	ProgramRewriteStat1<MatrixExprElStatUnaryOp, M, Op>{};
+
+template<class M, class O>
+struct ProgramRewrite<MatrixExprElDynUnaryOp<M, O>> : ProgramRewrite2<MatrixExprElDynUnaryOp, M, O>{};
+
+template<class L, class R>
+struct ProgramRewrite<MatrixExprAdd<L, R>> : ProgramRewrite2<MatrixExprAdd, L, R>{};
+
+template<class L, class R>
+struct ProgramRewrite<MatrixExprSubtract<L, R>> : ProgramRewrite2<MatrixExprSubtract, L, R>{};
+
+template<class L, class R>
+struct ProgramRewrite<MatrixExprElMul<L, R>> : ProgramRewrite2<MatrixExprElMul, L, R>{};
+
+template<class L, class R>
+struct ProgramRewrite<MatrixExprElDiv<L, R>> : ProgramRewrite2<MatrixExprElDiv, L, R>{};
+
+template<class L, class R, auto Op>
+struct ProgramRewrite<MatrixExprElStatOp<L, R, Op>> : ProgramRewriteStat2<MatrixExprElStatOp, L, R, Op>{};
+
+template<class L, class R, class O>
+struct ProgramRewrite<MatrixExprElDynOp<L, R, O>> : ProgramRewrite3<MatrixExprElDynOp, L, R, O>{};
+
+template<class L, class R>
+struct ProgramRewrite<MatrixExprMultiply<L, R>> :
+	ProgramRewriteProduct<MatrixExprMultiply, L, R, MatrixExprCached>{};
+
+template<class M>
+struct ProgramRewrite<MatrixExprScalarMultiply<M>>{
+	typedef MatrixExprScalarMultiply<ProgramMember<M>> Type;
+
+	SP_SI Type apply(const MatrixExprScalarMultiply<M> &e) noexcept{
+		return Type{program_member<M>(e.lhs), e.rhs};
+	}
+
+	template<class F>
+	SP_SI void visit(Type &e, F &&f, bool inProduct) noexcept{
+		program_visit<M>(e.lhs, f, inProduct);
+	}
+};
+
+template<class V, auto Op>
+struct ProgramRewrite<VectorExprElStatUnaryOp<V, Op>> :
+	ProgramRewriteStat1<VectorExprElStatUnaryOp, V, Op>{};
+
+template<class V, class O>
+struct ProgramRewrite<VectorExprElDynUnaryOp<V, O>> : ProgramRewrite2<VectorExprElDynUnaryOp, V, O>{};
+
+template<class L, class R>
+struct ProgramRewrite<VectorExprAdd<L, R>> : ProgramRewrite2<VectorExprAdd, L, R>{};
+
+template<class L, class R>
+struct ProgramRewrite<VectorExprSubtract<L, R>> : ProgramRewrite2<VectorExprSubtract, L, R>{};
+
+template<class L, class R>
+struct ProgramRewrite<VectorExprElMul<L, R>> : ProgramRewrite2<VectorExprElMul, L, R>{};
+
+template<class L, class R>
+struct ProgramRewrite<VectorExprElDiv<L, R>> : ProgramRewrite2<VectorExprElDiv, L, R>{};
+
+template<class L, class R, auto Op>
+struct ProgramRewrite<VectorExprElStatOp<L, R, Op>> : ProgramRewriteStat2<VectorExprElStatOp, L, R, Op>{};
+
+template<class L, class R, class O>
+struct ProgramRewrite<VectorExprElDynOp<L, R, O>> : ProgramRewrite3<VectorExprElDynOp, L, R, O>{};
+
+template<class V>
+struct ProgramRewrite<VectorExprScalarMultiply<V>>{
+	typedef VectorExprScalarMultiply<ProgramMember<V>> Type;
+
+	SP_SI Type apply(const VectorExprScalarMultiply<V> &e) noexcept{
+		return Type{program_member<V>(e.lhs), e.rhs};
+	}
+
+	template<class F>
+	SP_SI void visit(Type &e, F &&f, bool inProduct) noexcept{
+		program_visit<V>(e.lhs, f, inProduct);
+	}
+};
+
+template<class V, bool CVec, bool LV>
+struct ProgramRewrite<MatrixExprAsMatrix<V, CVec, LV>>{
+	typedef MatrixExprAsMatrix<ProgramMember<V>, CVec, LV> Type;
+
+	SP_SI Type apply(const MatrixExprAsMatrix<V, CVec, LV> &e) noexcept{
+		return Type{program_member<V>(e.arg)};
+	}
+
+	template<class F>
+	SP_SI void visit(Type &e, F &&f, bool inProduct) noexcept{
+		program_visit<V>(e.arg, f, inProduct);
+	}
+};
+
+template<class V, bool LV>
+struct ProgramRewrite<MatrixExprAsDiagonalMatrix<V, LV>>{
+	typedef MatrixExprAsDiagonalMatrix<ProgramMember<V>, LV> Type;
+
+	SP_SI Type apply(const MatrixExprAsDiagonalMatrix<V, LV> &e) noexcept{
+		return Type{program_member<V>(e.arg)};
+	}
+
+	template<class F>
+	SP_SI void visit(Type &e, F &&f, bool inProduct) noexcept{
+		program_visit<V>(e.arg, f, inProduct);
+	}
+};
+
+template<class M, bool LV>
+struct ProgramRewrite<VectorExprAsRowVector<M, LV>>{
+	typedef VectorExprAsRowVector<ProgramMember<M>, LV> Type;
+
+	SP_SI Type apply(const VectorExprAsRowVector<M, LV> &e) noexcept{
+		return Type{program_member<M>(e.arg), e.rowIndex};
+	}
+
+	template<class F>
+	SP_SI void visit(Type &e, F &&f, bool inProduct) noexcept{
+		program_visit<M>(e.arg, f, inProduct);
+	}
+};
+
+template<class M, bool LV>
+struct ProgramRewrite<VectorExprAsColumnVector<M, LV>>{
+	typedef VectorExprAsColumnVector<ProgramMember<M>, LV> Type;
+
+	SP_SI Type apply(const VectorExprAsColumnVector<M, LV> &e) noexcept{
+		return Type{program_member<M>(e.arg), e.columnIndex};
+	}
+
+	template<class F>
+	SP_SI void visit(Type &e, F &&f, bool inProduct) noexcept{
+		program_visit<M>(e.arg, f, inProduct);
+	}
+};
+
+template<class M, class V>
+struct ProgramRewrite<VectorExprMatrixVertMultiply<M, V>> :
+	ProgramRewriteProduct<VectorExprMatrixVertMultiply, M, V, VectorExprCached>{};
+
+template<class V, class M>
+struct ProgramRewrite<VectorExprMatrixHoriMultiply<V, M>> :
+	ProgramRewriteProduct<VectorExprMatrixHoriMultiply, V, M, VectorExprCached>{};
+
+template<class V1, class V2>
+struct ProgramRewrite<MatrixExprOuterProd<V1, V2>> : ProgramRewrite2<MatrixExprOuterProd, V1, V2>{};
+
+template<class V1, class V2, auto Op>
+struct ProgramRewrite<MatrixExprOuterStatOp<V1, V2, Op>> :
+	ProgramRewriteStat2<MatrixExprOuterStatOp, V1, V2, Op>{};
+
+template<class V1, class V2, class O>
+struct ProgramRewrite<MatrixExprOuterDynOp<V1, V2, O>> : ProgramRewrite3<MatrixExprOuterDynOp, V1, V2, O>{};
+
+
+
+template<class D, class E>
+struct ProgramAssign{
+	D &dest;
+	E expr;
+};
+
+template<class D, class E>
+struct ProgramStatement{
+	D &dest;
+	ProgramMember<E> expr;
+};
+
+template<class D, class E>
+SP_SI ProgramStatement<D, E> program_statement(const ProgramAssign<D, E> &s) noexcept{
+	return ProgramStatement<D, E>{s.dest, program_member<E>(s.expr)};
+}
+
+struct ProgramNode{
+	const void *type;
+	void *node;
+	size_t *data_index;
+	void (*compute)(void *) noexcept;
+	size_t first;	// index of the first node equal to this one
+	bool needed;
+};
+
+template<class N>
+constexpr char ProgramTag = 0;	// address identifies the type
+
+// computes the cached node into the temporary storage, it stays uncomputed if allocation fails
+template<class N>
+void program_compute(void *node) noexcept{
+	typedef typename N::ValueType T;
+	N &n = *(N *)node;
+	size_t index = len(MatrixTempStorage.data);
+	if constexpr (IsVectorNode<N>){
+		if (expand_back(MatrixTempStorage.data, (len(n.arg)*sizeof(T) + 7) / 8)) return;
+		T *dest = (T *)(beg(MatrixTempStorage.data) + index);
+		for (size_t i=0; i!=len(n.arg); ++i) dest[i] = n.arg[i];
+	} else{
+		size_t height = rows(n.arg), width = cols(n.arg);
+		if (expand_back(MatrixTempStorage.data, (height*width*sizeof(T) + 7) / 8)) return;
+		T *dest = (T *)(beg(MatrixTempStorage.data) + index);
+		for (size_t i=0; i!=height; ++i)
+			for (size_t j=0; j!=width; ++j)
+				dest[i*width + j] = n.arg(i, j);
+	}
+	n.data_index = index;
+}
+
+// true if the expression is the object at the address or keeps a reference to it
+SP_SI bool program_reads(const void *expr, size_t size, const void *address) noexcept{
+	if (expr == address) return true;
+	for (size_t i=0; i+sizeof(void *)<=size; i+=alignof(void *)){
+		const void *ptr;
+		memcpy(&ptr, (const char *)expr + i, sizeof(void *));
+		if (ptr == address) return true;
+	}
+	return false;
+}
+
+template<class D, class E>
+SP_SI void program_resize(ProgramStatement<D, E> &s, size_t &height, size_t &width) noexcept{
+	if constexpr (IsVectorNode<D>){
+		resize(s.dest, len(s.expr));
+		height = len(s.dest);
+		width = 1;
+	} else{
+		resize(s.dest, rows(s.expr), cols(s.expr));
+		height = rows(s.dest);
+		width = cols(s.dest);
+	}
+}
+
+template<class D, class E>
+SP_SI void program_put(ProgramStatement<D, E> &s, size_t i, size_t j) noexcept{
+	if constexpr (IsVectorNode<D>)
+		s.dest[i] = s.expr[i];
+	else
+		s.dest(i, j) = s.expr(i, j);
+}
+
+template<class D, class E>
+SP_SI void program_single(ProgramStatement<D, E> &s, size_t height, size_t width) noexcept{
+	if constexpr (IsVectorNode<D>)
+		for (size_t i=0; i!=height; ++i) s.dest[i] = s.expr[i];
+	else
+		traverse<D, std::decay_t<ProgramMember<E>>>(
+			height, width, [&](size_t i, size_t j){ s.dest(i, j) = s.expr(i, j); }
+		);
+}
+
+template<class D, class E, class F>
+SP_SI void program_collect(ProgramStatement<D, E> &s, F &f) noexcept{
+	program_visit<E>(s.expr, f, false);
+}
+
+template<class D>
+SP_CSI bool program_row_major() noexcept{
+	if constexpr (IsVectorNode<D>)
+		return true;
+	else
+		return D::RowMajor;
+}
+
+// runs the statements from begin to end, the other ones are skipped
+template<class... S>
+void program_stage(size_t begin, size_t end, S &...s) noexcept{
+	constexpr size_t Count = sizeof...(S);
+	size_t base = len(MatrixTempStorage.data);
+	DynamicArray<ProgramNode, MallocAllocator<>> nodes = {{nullptr, 0}, 0, nullptr};
+
+	auto collect = [&]<class N>(N &node, bool inProduct){
+		size_t first = len(nodes);
+		for (size_t i=0; i!=len(nodes); ++i)
+			if (nodes[i].type == &ProgramTag<N> && !memcmp(nodes[i].node, &node, sizeof(N))){
+				first = nodes[i].first;
+				break;
+			}
+		if (push(nodes)) return;
+		back(nodes) = ProgramNode{
+			&ProgramTag<N>, &node, &node.data_index, program_compute<N>, first, false
+		};
+		if (first != len(nodes)-1 || inProduct) nodes[first].needed = true;
+	};
+	size_t k = 0;
+	((k>=begin && k<end ? program_collect(s, collect) : void(), ++k), ...);
+
+	for (size_t i=0; i!=len(nodes); ++i){
+		if (nodes[i].first != i)
+			*nodes[i].data_index = *nodes[nodes[i].first].data_index;
+		else if (nodes[i].needed)
+			nodes[i].compute(nodes[i].node);
+	}
+	free(MallocAllocator<>{}, nodes.data);
+
+	size_t heights[Count], widths[Count];
+	k = 0;
+	((k>=begin && k<end ? program_resize(s, heights[k], widths[k]) : void(), ++k), ...);
+	bool fused = end-begin > 1;
+	for (size_t i=begin+1; i<end; ++i)
+		if (heights[i] != heights[begin] || widths[i] != widths[begin]) fused = false;
+
+	if (fused){
+		bool rowMajor[Count] = {program_row_major<std::remove_reference_t<decltype(s.dest)>>()...};
+		size_t height = heights[begin], width = widths[begin];
+		auto put = [&](size_t i, size_t j){
+			size_t n = 0;
+			((n>=begin && n<end ? program_put(s, i, j) : void(), ++n), ...);
+		};
+		if (rowMajor[begin]){
+			for (size_t i=0; i!=height; ++i)
+				for (size_t j=0; j!=width; ++j)
+					put(i, j);
+		} else{
+			for (size_t j=0; j!=width; ++j)
+				for (size_t i=0; i!=height; ++i)
+					put(i, j);
+		}
+	} else{
+		k = 0;
+		((k>=begin && k<end ? program_single(s, heights[k], widths[k]) : void(), ++k), ...);
+	}
+	resize(MatrixTempStorage.data, base);
+}
+
+template<class... S>
+void program_run(S &&...s) noexcept{
+	constexpr size_t Count = sizeof...(S);
+	const void *dests[Count] = {(const void *)&s.dest...};
+	const void *exprs[Count] = {(const void *)&s.expr...};
+	size_t sizes[Count] = {sizeof(s.expr)...};
+
+	size_t begin = 0;
+	for (size_t k=1; k!=Count; ++k)
+		for (size_t j=begin; j!=k; ++j)
+			if (
+				dests[j] == dests[k] || program_reads(exprs[k], sizes[k], dests[j]) ||
+				program_reads(exprs[j], sizes[j], dests[k])
+			){
+				program_stage(begin, k, s...);
+				begin = k;
+				break;
+			}
+	program_stage(begin, Count, s...);
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+
+
+// assignment recorded for evaluate
+template<SP_MATRIX_T(D), SP_MATRIX_T(E)>
+constexpr auto assign(D &dest, E &&expr) noexcept{
+	return priv__::ProgramAssign<D, CRemRRef<E>>{dest, expr};
+}
+
+template<SP_VECTOR_T(D), SP_VECTOR_T(E)>
+constexpr auto assign(D &dest, E &&expr) noexcept{
+	return priv__::ProgramAssign<D, CRemRRef<E>>{dest, expr};
+}
+
+// runs the assignments in order, products shared by them are computed once
+template<class... A>
+void evaluate(const A &...assignments) noexcept{
+	SP_MATRIX_PROFILE_BEGIN("evaluate", 0, 0);
+	size_t oldSize = len(MatrixTempStorage.data);
+	priv__::program_run(priv__::program_statement(assignments)...);
+	bool usesBuffer = (std::remove_reference_t<decltype(assignments.expr)>::UsesBuffer || ...);
+	resize(MatrixTempStorage.data, usesBuffer ? MatrixTempStorage.stack_pos : oldSize);
+	SP_MATRIX_PROFILE_END();
+}
+
+} // END OF NAMESPACE ///////////////////////////////////////////////////////////////////////////////////////
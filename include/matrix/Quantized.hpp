@@ -0,0 +1,410 @@
+#pragma once
+
+#include "Expr.hpp"
+#include "SPL/FixedPoint.hpp"
+#include <math.h>
+#include <limits>
+
+#ifdef __AVX2__
+	#include <immintrin.h>
+#endif
+
+namespace sp{
+
+// QUANTIZED MATRICES
+// elements of int8 matrices are multiplied with int32 accumulation and elements of int16
+// matrices with int64 accumulation, every row of quantized matrix has its own scale and zero
+// point, it represents real values scale[i] * (A(i, j) - zeroPoint[i])
+// right hand side matrix of products is given transposed, so that both operands are read along
+// their rows, operands must be row major leaves
+// vpmaddwd wraps a pair of -32768 * -32768 products, so int16 quantization stops at -32767
+
+
+template<class T> constexpr bool IsFixedPoint = false;
+template<size_t B, class T> constexpr bool IsFixedPoint<FixedPoint<B, T>> = true;
+
+template<class T> constexpr bool IsQuantized = std::is_same_v<T, int8_t> || std::is_same_v<T, int16_t>;
+
+template<class T> using QuantizedAcc = std::conditional_t<std::is_same_v<T, int8_t>, int32_t, int64_t>;
+
+
+namespace priv__{
+
+template<class T>
+SP_CSI float to_real(T x) noexcept{
+	if constexpr (IsFixedPoint<T>)
+		return (float)x.data * (1.f / (float)((uint64_t)1 << T::FracBits));
+	else
+		return (float)x;
+}
+
+template<class T>
+SP_CSI T from_real(float x) noexcept{
+	if constexpr (IsFixedPoint<T>)
+		return T{(typename T::Base)lrintf(x * (float)((uint64_t)1 << T::FracBits))};
+	else
+		return (T)x;
+}
+
+template<class M>
+SP_CSI auto *row_ptr(M &m, size_t row) noexcept{ return beg(m) + row*lead_dim(m); }
+
+#ifdef __AVX2__
+// elements are sign extended to 16 bits and multiplied with vpmaddwd, vpmaddubsw would need
+// one unsigned operand and it saturates sums of pairs of products
+SP_SI __m256i load_widened(const int8_t *ptr) noexcept{
+	return _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)ptr));
+}
+
+SP_SI __m256i load_widened(const int16_t *ptr) noexcept{
+	return _mm256_loadu_si256((const __m256i *)ptr);
+}
+
+SP_SI int32_t hsum(__m256i x) noexcept{
+	__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+	return _mm_cvtsi128_si32(sum);
+}
+
+SP_SI int64_t hsum64(__m256i x) noexcept{
+	__m128i sum = _mm_add_epi64(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+	sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+	return _mm_cvtsi128_si64(sum);
+}
+
+// pairs of int16 products nearly fill int32 lanes, so they are sign extended to int64 at once
+template<class E>
+SP_SI __m256i accumulate(__m256i acc, __m256i pairs) noexcept{
+	if constexpr (std::is_same_v<E, int8_t>) return _mm256_add_epi32(acc, pairs);
+	acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(pairs)));
+	return _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(pairs, 1)));
+}
+
+template<class E>
+SP_SI QuantizedAcc<E> hsum_acc(__m256i acc) noexcept{
+	if constexpr (std::is_same_v<E, int8_t>) return hsum(acc);
+	else return hsum64(acc);
+}
+#endif
+
+// dot products of one row with four other rows, the first row is loaded only once
+template<class E>
+SP_SI void dot_1x4(
+	QuantizedAcc<E> *res, const E *a, const E *b0, const E *b1, const E *b2, const E *b3, size_t len
+) noexcept{
+	typedef QuantizedAcc<E> R;
+	size_t i = 0;
+	R r0 = 0, r1 = 0, r2 = 0, r3 = 0;
+#ifdef __AVX2__
+	__m256i acc0 = _mm256_setzero_si256();
+	__m256i acc1 = _mm256_setzero_si256();
+	__m256i acc2 = _mm256_setzero_si256();
+	__m256i acc3 = _mm256_setzero_si256();
+	for (; i+16<=len; i+=16){
+		__m256i va = load_widened(a + i);
+		acc0 = accumulate<E>(acc0, _mm256_madd_epi16(va, load_widened(b0 + i)));
+		acc1 = accumulate<E>(acc1, _mm256_madd_epi16(va, load_widened(b1 + i)));
+		acc2 = accumulate<E>(acc2, _mm256_madd_epi16(va, load_widened(b2 + i)));
+		acc3 = accumulate<E>(acc3, _mm256_madd_epi16(va, load_widened(b3 + i)));
+	}
+	r0 = hsum_acc<E>(acc0);
+	r1 = hsum_acc<E>(acc1);
+	r2 = hsum_acc<E>(acc2);
+	r3 = hsum_acc<E>(acc3);
+#endif
+	for (; i!=len; ++i){
+		R va = a[i];
+		r0 += va * (R)b0[i];
+		r1 += va * (R)b1[i];
+		r2 += va * (R)b2[i];
+		r3 += va * (R)b3[i];
+	}
+	res[0] = r0;
+	res[1] = r1;
+	res[2] = r2;
+	res[3] = r3;
+}
+
+template<class E>
+SP_SI QuantizedAcc<E> dot(const E *a, const E *b, size_t len) noexcept{
+	typedef QuantizedAcc<E> R;
+	size_t i = 0;
+	R res = 0;
+#ifdef __AVX2__
+	__m256i acc = _mm256_setzero_si256();
+	for (; i+16<=len; i+=16)
+		acc = accumulate<E>(acc, _mm256_madd_epi16(load_widened(a + i), load_widened(b + i)));
+	res = hsum_acc<E>(acc);
+#endif
+	for (; i!=len; ++i) res += (R)a[i] * (R)b[i];
+	return res;
+}
+
+template<class E>
+SP_SI QuantizedAcc<E> row_sum(const E *a, size_t len) noexcept{
+	QuantizedAcc<E> res = 0;
+	for (size_t i=0; i!=len; ++i) res += a[i];
+	return res;
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+
+
+// dest = A * tr(Bt), accumulated in int32 for int8 and in int64 for int16
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2), SP_MATRIX_T(M3)>
+void quantized_mul(M1 &&dest, M2 &&A, M3 &&Bt) noexcept{
+	typedef typename std::decay_t<M2>::ValueType E;
+	static_assert(IsQuantized<E>, "quantized product is defined for int8 and int16 matrices");
+	static_assert(std::is_same_v<E, typename std::decay_t<M3>::ValueType>, "operands must have the same type");
+	static_assert(std::decay_t<M2>::RowMajor && std::decay_t<M3>::RowMajor, "operands must be row major");
+	SP_MATRIX_ERROR(cols(A) != cols(Bt), "multiplied matrices must have matching inner dimensions");
+	size_t m = rows(A), n = rows(Bt), k = cols(A);
+
+	resize(dest, m, n);
+	size_t blockRows = max(matrixTuning.mulBytes / (k*sizeof(E) + 1), (size_t)4) & ~(size_t)3;
+	for (size_t jj=0; jj<n; jj+=blockRows){	// block of Bt rows stays in cache for all rows of A
+		size_t jEnd = min(jj+blockRows, n);
+		for (size_t i=0; i!=m; ++i){
+			const E *a = priv__::row_ptr(A, i);
+			size_t j = jj;
+			for (; j+4<=jEnd; j+=4){
+				QuantizedAcc<E> res[4];
+				priv__::dot_1x4(
+					res, a, priv__::row_ptr(Bt, j), priv__::row_ptr(Bt, j+1),
+					priv__::row_ptr(Bt, j+2), priv__::row_ptr(Bt, j+3), k
+				);
+				dest(i, j) = res[0];
+				dest(i, j+1) = res[1];
+				dest(i, j+2) = res[2];
+				dest(i, j+3) = res[3];
+			}
+			for (; j!=jEnd; ++j)
+				dest(i, j) = priv__::dot(a, priv__::row_ptr(Bt, j), k);
+		}
+	}
+}
+
+// dest = real(A) * tr(real(Bt)), dest can hold floating point or fixed point values
+template<
+	SP_MATRIX_T(M1), SP_MATRIX_T(M2), class S1, class Z1, SP_MATRIX_T(M3), class S2, class Z2
+>
+void quantized_mul(
+	M1 &&dest,
+	M2 &&A, const S1 &scalesA, const Z1 &zeroPointsA,
+	M3 &&Bt, const S2 &scalesB, const Z2 &zeroPointsB
+) noexcept{
+	typedef typename std::decay_t<M1>::ValueType T;
+	typedef typename std::decay_t<M2>::ValueType E;
+	static_assert(IsQuantized<E>, "quantized product is defined for int8 and int16 matrices");
+	static_assert(std::is_same_v<E, typename std::decay_t<M3>::ValueType>, "operands must have the same type");
+	static_assert(std::decay_t<M2>::RowMajor && std::decay_t<M3>::RowMajor, "operands must be row major");
+	SP_MATRIX_ERROR(cols(A) != cols(Bt), "multiplied matrices must have matching inner dimensions");
+	SP_MATRIX_ERROR(len(scalesA)!=rows(A) || len(zeroPointsA)!=rows(A), "every row needs a scale and zero point");
+	SP_MATRIX_ERROR(len(scalesB)!=rows(Bt) || len(zeroPointsB)!=rows(Bt), "every row needs a scale and zero point");
+	size_t m = rows(A), n = rows(Bt), k = cols(A);
+
+	size_t oldSize = len(MatrixTempStorage.data);
+	expand_back(MatrixTempStorage.data, m+n);
+	int64_t *sumsA = (int64_t *)(beg(MatrixTempStorage.data) + oldSize);
+	int64_t *sumsB = sumsA + m;
+	for (size_t i=0; i!=m; ++i) sumsA[i] = priv__::row_sum(priv__::row_ptr(A, i), k);
+	for (size_t j=0; j!=n; ++j) sumsB[j] = priv__::row_sum(priv__::row_ptr(Bt, j), k);
+
+	// sum (a - za)*(b - zb) = sum a*b - zb*sum a - za*sum b + k*za*zb
+	auto write = [&](size_t i, size_t j, int64_t acc){
+		int64_t za = zeroPointsA[i], zb = zeroPointsB[j];
+		int64_t res = acc - zb*sumsA[i] - za*sumsB[j] + (int64_t)k*za*zb;
+		dest(i, j) = priv__::from_real<T>((float)scalesA[i] * (float)scalesB[j] * (float)res);
+	};
+
+	resize(dest, m, n);
+	size_t blockRows = max(matrixTuning.mulBytes / (k*sizeof(E) + 1), (size_t)4) & ~(size_t)3;
+	for (size_t jj=0; jj<n; jj+=blockRows){
+		size_t jEnd = min(jj+blockRows, n);
+		for (size_t i=0; i!=m; ++i){
+			const E *a = priv__::row_ptr(A, i);
+			size_t j = jj;
+			for (; j+4<=jEnd; j+=4){
+				QuantizedAcc<E> res[4];
+				priv__::dot_1x4(
+					res, a, priv__::row_ptr(Bt, j), priv__::row_ptr(Bt, j+1),
+					priv__::row_ptr(Bt, j+2), priv__::row_ptr(Bt, j+3), k
+				);
+				for (size_t l=0; l!=4; ++l) write(i, j+l, res[l]);
+			}
+			for (; j!=jEnd; ++j)
+				write(i, j, priv__::dot(a, priv__::row_ptr(Bt, j), k));
+		}
+	}
+
+	resize(MatrixTempStorage.data, oldSize);
+}
+
+// dest = A * x, accumulated in int32 for int8 and in int64 for int16
+template<SP_VECTOR_T(V1), SP_MATRIX_T(M), SP_VECTOR_T(V2)>
+void quantized_mul(V1 &&dest, M &&A, V2 &&x) noexcept{
+	typedef typename std::decay_t<M>::ValueType E;
+	static_assert(IsQuantized<E>, "quantized product is defined for int8 and int16 matrices");
+	static_assert(std::is_same_v<E, typename std::decay_t<V2>::ValueType>, "operands must have the same type");
+	static_assert(std::decay_t<M>::RowMajor, "quantized matrix must be row major");
+	SP_MATRIX_ERROR(cols(A) != len(x), "vector's size must be equal to number of columns of the matrix");
+	size_t m = rows(A), k = cols(A);
+	const E *vx = beg(x);
+
+	resize(dest, m);
+	size_t i = 0;
+	for (; i+4<=m; i+=4){	// the vector is loaded once for four rows
+		QuantizedAcc<E> res[4];
+		priv__::dot_1x4(
+			res, vx, priv__::row_ptr(A, i), priv__::row_ptr(A, i+1),
+			priv__::row_ptr(A, i+2), priv__::row_ptr(A, i+3), k
+		);
+		for (size_t l=0; l!=4; ++l) dest[i+l] = res[l];
+	}
+	for (; i!=m; ++i) dest[i] = priv__::dot(priv__::row_ptr(A, i), vx, k);
+}
+
+// dest = real(A) * real(x), the vector has single scale and zero point
+template<SP_VECTOR_T(V1), SP_MATRIX_T(M), class S, class Z, SP_VECTOR_T(V2)>
+void quantized_mul(
+	V1 &&dest,
+	M &&A, const S &scalesA, const Z &zeroPointsA,
+	V2 &&x, float scaleX, int32_t zeroPointX
+) noexcept{
+	typedef typename std::decay_t<V1>::ValueType T;
+	typedef typename std::decay_t<M>::ValueType E;
+	static_assert(IsQuantized<E>, "quantized product is defined for int8 and int16 matrices");
+	static_assert(std::is_same_v<E, typename std::decay_t<V2>::ValueType>, "operands must have the same type");
+	static_assert(std::decay_t<M>::RowMajor, "quantized matrix must be row major");
+	SP_MATRIX_ERROR(cols(A) != len(x), "vector's size must be equal to number of columns of the matrix");
+	SP_MATRIX_ERROR(len(scalesA)!=rows(A) || len(zeroPointsA)!=rows(A), "every row needs a scale and zero point");
+	size_t m = rows(A), k = cols(A);
+	const E *vx = beg(x);
+	int64_t sumX = priv__::row_sum(vx, k);
+
+	auto write = [&](size_t i, int64_t acc){
+		int64_t za = zeroPointsA[i];
+		int64_t sumA = priv__::row_sum(priv__::row_ptr(A, i), k);
+		int64_t res = acc - zeroPointX*sumA - za*sumX + (int64_t)k*za*zeroPointX;
+		dest[i] = priv__::from_real<T>((float)scalesA[i] * scaleX * (float)res);
+	};
+
+	resize(dest, m);
+	size_t i = 0;
+	for (; i+4<=m; i+=4){
+		QuantizedAcc<E> res[4];
+		priv__::dot_1x4(
+			res, vx, priv__::row_ptr(A, i), priv__::row_ptr(A, i+1),
+			priv__::row_ptr(A, i+2), priv__::row_ptr(A, i+3), k
+		);
+		for (size_t l=0; l!=4; ++l) write(i+l, res[l]);
+	}
+	for (; i!=m; ++i) write(i, priv__::dot(priv__::row_ptr(A, i), vx, k));
+}
+
+
+
+namespace priv__{
+
+// lowest quantized value, -32768 is left out of int16 range for vpmaddwd
+template<class E>
+constexpr float QuantizedMin = std::is_same_v<E, int8_t> ? -128.f : -32767.f;
+
+// affine mapping of [lo, hi] (always containing zero) onto the whole range of E
+template<class E>
+SP_CSI void choose_quantization(float lo, float hi, float &scale, int32_t &zeroPoint) noexcept{
+	constexpr float qmin = QuantizedMin<E>;
+	constexpr float qmax = (float)std::numeric_limits<E>::max();
+	lo = min(lo, 0.f);
+	hi = max(hi, 0.f);
+	scale = (hi - lo) / (qmax - qmin);
+	if (scale == 0.f) scale = 1.f;
+	zeroPoint = (int32_t)lrintf(min(max(qmin - lo/scale, qmin), qmax));
+}
+
+template<class E>
+SP_CSI E quantize_value(float x, float scale, int32_t zeroPoint) noexcept{
+	constexpr float qmin = QuantizedMin<E>;
+	constexpr float qmax = (float)std::numeric_limits<E>::max();
+	return (E)lrintf(min(max(x/scale + (float)zeroPoint, qmin), qmax));
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+// source can hold floating point or fixed point values, scales and zero points are chosen
+// for every row separately
+template<SP_MATRIX_T(M1), class S, class Z, SP_MATRIX_T(M2)>
+void quantize(M1 &&dest, S &scales, Z &zeroPoints, M2 &&src) noexcept{
+	typedef typename std::decay_t<M1>::ValueType E;
+	static_assert(IsQuantized<E>, "quantized matrix must hold int8 or int16 values");
+	size_t m = rows(src), n = cols(src);
+
+	resize(dest, m, n);
+	resize(scales, m);
+	resize(zeroPoints, m);
+	for (size_t i=0; i!=m; ++i){
+		float lo = 0.f, hi = 0.f;
+		for (size_t j=0; j!=n; ++j){
+			float x = priv__::to_real(src(i, j));
+			lo = min(lo, x);
+			hi = max(hi, x);
+		}
+		float scale;
+		int32_t zeroPoint;
+		priv__::choose_quantization<E>(lo, hi, scale, zeroPoint);
+		scales[i] = scale;
+		zeroPoints[i] = zeroPoint;
+		for (size_t j=0; j!=n; ++j)
+			dest(i, j) = priv__::quantize_value<E>(priv__::to_real(src(i, j)), scale, zeroPoint);
+	}
+}
+
+template<SP_VECTOR_T(V1), SP_VECTOR_T(V2)>
+void quantize(V1 &&dest, float &scale, int32_t &zeroPoint, V2 &&src) noexcept{
+	typedef typename std::decay_t<V1>::ValueType E;
+	static_assert(IsQuantized<E>, "quantized vector must hold int8 or int16 values");
+	size_t n = len(src);
+
+	resize(dest, n);
+	float lo = 0.f, hi = 0.f;
+	for (size_t i=0; i!=n; ++i){
+		float x = priv__::to_real(src[i]);
+		lo = min(lo, x);
+		hi = max(hi, x);
+	}
+	priv__::choose_quantization<E>(lo, hi, scale, zeroPoint);
+	for (size_t i=0; i!=n; ++i)
+		dest[i] = priv__::quantize_value<E>(priv__::to_real(src[i]), scale, zeroPoint);
+}
+
+// destination can hold floating point or fixed point values
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2), class S, class Z>
+void dequantize(M1 &&dest, M2 &&src, const S &scales, const Z &zeroPoints) noexcept{
+	typedef typename std::decay_t<M1>::ValueType T;
+	SP_MATRIX_ERROR(len(scales)!=rows(src) || len(zeroPoints)!=rows(src), "every row needs a scale and zero point");
+	size_t m = rows(src), n = cols(src);
+
+	resize(dest, m, n);
+	for (size_t i=0; i!=m; ++i){
+		float scale = scales[i];
+		int32_t zeroPoint = zeroPoints[i];
+		for (size_t j=0; j!=n; ++j)
+			dest(i, j) = priv__::from_real<T>(scale * (float)((int32_t)src(i, j) - zeroPoint));
+	}
+}
+
+template<SP_VECTOR_T(V1), SP_VECTOR_T(V2)>
+void dequantize(V1 &&dest, V2 &&src, float scale, int32_t zeroPoint) noexcept{
+	typedef typename std::decay_t<V1>::ValueType T;
+	size_t n = len(src);
+
+	resize(dest, n);
+	for (size_t i=0; i!=n; ++i)
+		dest[i] = priv__::from_real<T>(scale * (float)((int32_t)src[i] - zeroPoint));
+}
+
+
+
+} // END OF NAMESPACE ///////////////////////////////////////////////////////////////////
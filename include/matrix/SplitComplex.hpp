@@ -0,0 +1,393 @@
+#pragma once
+
+#include "Expr.hpp"
+#include "SPL/Complex.hpp"
+
+namespace sp{
+
+// SPLIT COMPLEX MATRICES
+// real and imaginary parts are stored in two separate row major planes, so that kernels can
+// process each plane with plain vector arithmetic instead of shuffling interleaved pairs
+// mutable element access goes through a reference proxy, constant access returns a Complex
+
+
+template<class T>
+struct SplitComplexRef{
+	SP_CI operator Complex<T>() const noexcept{ return Complex<T>{*re, *im}; }
+
+	SP_CI const SplitComplexRef &operator =(Complex<T> rhs) const noexcept{
+		*re = rhs.real;
+		*im = rhs.imag;
+		return *this;
+	}
+	SP_CI const SplitComplexRef &operator =(const SplitComplexRef &rhs) const noexcept{
+		return *this = (Complex<T>)rhs;
+	}
+	SP_CI const SplitComplexRef &operator +=(Complex<T> rhs) const noexcept{
+		*re += rhs.real;
+		*im += rhs.imag;
+		return *this;
+	}
+	SP_CI const SplitComplexRef &operator -=(Complex<T> rhs) const noexcept{
+		*re -= rhs.real;
+		*im -= rhs.imag;
+		return *this;
+	}
+	SP_CI const SplitComplexRef &operator *=(Complex<T> rhs) const noexcept{
+		return *this = (Complex<T>)*this * rhs;
+	}
+
+	T *re;
+	T *im;
+};
+
+
+
+template<class T, class A>
+struct MatrixSplitComplex{
+	typedef Complex<T> ValueType;
+	static constexpr StupidMatrixFlagType MatrixFlag{};
+	constexpr static bool RowMajor = true;
+	constexpr static bool UndefMajor = false;
+	constexpr static bool UsesBuffer = false;
+
+	SP_CI SplitComplexRef<T> operator ()(size_t r, size_t c) noexcept{
+		SP_MATRIX_ERROR(r>=rows || c>=cols, "out of bounds matrix indecies");
+		size_t index = r*cols + c;
+		return SplitComplexRef<T>{(T *)data.ptr + index, (T *)data.ptr + (size_t)rows*cols + index};
+	}
+
+	SP_CI Complex<T> operator ()(size_t r, size_t c) const noexcept{
+		SP_MATRIX_ERROR(r>=rows || c>=cols, "out of bounds matrix indecies");
+		size_t index = r*cols + c;
+		return Complex<T>{*((const T *)data.ptr + index), *((const T *)data.ptr + (size_t)rows*cols + index)};
+	}
+
+	Memblock data = {nullptr, 0};
+	uint32_t rows = 0;
+	uint32_t cols = 0;
+	A *allocator = nullptr;
+};
+
+template<class T, class A>
+SP_CSI size_t rows(const MatrixSplitComplex<T, A> &m) noexcept{ return m.rows; }
+
+template<class T, class A>
+SP_CSI size_t cols(const MatrixSplitComplex<T, A> &m) noexcept{ return m.cols; }
+
+template<class T, class A>
+SP_CSI size_t len(const MatrixSplitComplex<T, A> &m) noexcept{ return m.rows * m.cols; }
+
+template<class T, class A>
+SP_CSI size_t cap(const MatrixSplitComplex<T, A> &m) noexcept{ return m.data.size / (2*sizeof(T)); }
+
+template<class T, class A>
+SP_CSI T *beg_real(const MatrixSplitComplex<T, A> &m) noexcept{ return (T *)m.data.ptr; }
+
+template<class T, class A>
+SP_CSI T *beg_imag(const MatrixSplitComplex<T, A> &m) noexcept{
+	return (T *)m.data.ptr + (size_t)m.rows*m.cols;
+}
+
+template<class T, class A>
+SP_SI bool resize(MatrixSplitComplex<T, A> &m, size_t r, size_t c) noexcept{
+	size_t size = 2 * r * c * sizeof(T);
+	if (m.data.size < size){
+		Memblock blk;
+		if constexpr (A::Alignment)
+			blk = realloc(*m.allocator, m.data, size);
+		else
+			blk = realloc(*m.allocator, m.data, size, alignof(T));
+		if (blk.ptr == nullptr) return true;
+		m.data = blk;
+	}
+
+	m.rows = r;
+	m.cols = c;
+	return false;
+}
+
+
+
+template<class T, class A>
+struct VectorSplitComplex{
+	typedef Complex<T> ValueType;
+	static constexpr StupidVectorFlagType VectorFlag{};
+	constexpr static bool UsesBuffer = false;
+
+	SP_CI SplitComplexRef<T> operator [](size_t i) noexcept{
+		SP_MATRIX_ERROR(i >= size, "out of bounds vector index");
+		return SplitComplexRef<T>{(T *)data.ptr + i, (T *)data.ptr + size + i};
+	}
+
+	SP_CI Complex<T> operator [](size_t i) const noexcept{
+		SP_MATRIX_ERROR(i >= size, "out of bounds vector index");
+		return Complex<T>{*((const T *)data.ptr + i), *((const T *)data.ptr + size + i)};
+	}
+
+	Memblock data = {nullptr, 0};
+	size_t size = 0;
+	A *allocator = nullptr;
+};
+
+template<class T, class A>
+SP_CSI size_t len(const VectorSplitComplex<T, A> &v) noexcept{ return v.size; }
+
+template<class T, class A>
+SP_CSI size_t cap(const VectorSplitComplex<T, A> &v) noexcept{ return v.data.size / (2*sizeof(T)); }
+
+template<class T, class A>
+SP_CSI T *beg_real(const VectorSplitComplex<T, A> &v) noexcept{ return (T *)v.data.ptr; }
+
+template<class T, class A>
+SP_CSI T *beg_imag(const VectorSplitComplex<T, A> &v) noexcept{ return (T *)v.data.ptr + v.size; }
+
+template<class T, class A>
+SP_SI bool resize(VectorSplitComplex<T, A> &v, size_t n) noexcept{
+	size_t size = 2 * n * sizeof(T);
+	if (v.data.size < size){
+		Memblock blk;
+		if constexpr (A::Alignment)
+			blk = realloc(*v.allocator, v.data, size);
+		else
+			blk = realloc(*v.allocator, v.data, size, alignof(T));
+		if (blk.ptr == nullptr) return true;
+		v.data = blk;
+	}
+	v.size = n;
+	return false;
+}
+
+
+template<class T, class A = sp::MallocAllocator<>>
+using SplitComplexMatrix = MatrixWrapper<MatrixSplitComplex<T, A>>;
+
+template<class T, class A = sp::MallocAllocator<>>
+using SplitComplexVector = VectorWrapper<VectorSplitComplex<T, A>>;
+
+
+
+// CONVERSIONS
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2)>
+void split(M1 &&dest, M2 &&src) noexcept{
+	size_t r = rows(src), c = cols(src);
+	resize(dest, r, c);
+	auto *re = beg_real(dest);
+	auto *im = beg_imag(dest);
+	for (size_t i=0; i!=r; ++i)
+		for (size_t j=0; j!=c; ++j){
+			auto x = src(i, j);
+			re[i*c+j] = x.real;
+			im[i*c+j] = x.imag;
+		}
+}
+
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2)>
+void interleave(M1 &&dest, M2 &&src) noexcept{
+	typedef typename std::decay_t<M1>::ValueType C;
+	size_t r = rows(src), c = cols(src);
+	resize(dest, r, c);
+	const auto *re = beg_real(src);
+	const auto *im = beg_imag(src);
+	for (size_t i=0; i!=r; ++i)
+		for (size_t j=0; j!=c; ++j)
+			dest(i, j) = C{re[i*c+j], im[i*c+j]};
+}
+
+template<SP_VECTOR_T(V1), SP_VECTOR_T(V2)>
+void split(V1 &&dest, V2 &&src) noexcept{
+	size_t n = len(src);
+	resize(dest, n);
+	auto *re = beg_real(dest);
+	auto *im = beg_imag(dest);
+	for (size_t i=0; i!=n; ++i){
+		auto x = src[i];
+		re[i] = x.real;
+		im[i] = x.imag;
+	}
+}
+
+template<SP_VECTOR_T(V1), SP_VECTOR_T(V2)>
+void interleave(V1 &&dest, V2 &&src) noexcept{
+	typedef typename std::decay_t<V1>::ValueType C;
+	size_t n = len(src);
+	resize(dest, n);
+	const auto *re = beg_real(src);
+	const auto *im = beg_imag(src);
+	for (size_t i=0; i!=n; ++i) dest[i] = C{re[i], im[i]};
+}
+
+
+
+namespace priv__{
+
+// complex dot product of split rows, partial sums are kept in independent lanes, so the loop
+// vectorizes without reassociating floating point additions
+template<class T>
+SP_SI Complex<T> split_dot(const T *ar, const T *ai, const T *br, const T *bi, size_t len) noexcept{
+	constexpr size_t Lanes = 32 / sizeof(T);
+	T accR[Lanes] = {};
+	T accI[Lanes] = {};
+	size_t i = 0;
+	for (; i+Lanes<=len; i+=Lanes)
+		for (size_t l=0; l!=Lanes; ++l){
+			accR[l] += ar[i+l]*br[i+l] - ai[i+l]*bi[i+l];
+			accI[l] += ar[i+l]*bi[i+l] + ai[i+l]*br[i+l];
+		}
+	Complex<T> res{(T)0, (T)0};
+	for (size_t l=0; l!=Lanes; ++l){
+		res.real += accR[l];
+		res.imag += accI[l];
+	}
+	for (; i!=len; ++i){
+		res.real += ar[i]*br[i] - ai[i]*bi[i];
+		res.imag += ar[i]*bi[i] + ai[i]*br[i];
+	}
+	return res;
+}
+
+// (dr, di) += (sr, si) * (xr, xi) over a contiguous range
+template<class T>
+SP_SI void split_axpy(T *dr, T *di, T sr, T si, const T *xr, const T *xi, size_t len) noexcept{
+	for (size_t i=0; i!=len; ++i){
+		dr[i] += sr*xr[i] - si*xi[i];
+		di[i] += sr*xi[i] + si*xr[i];
+	}
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+
+
+// KERNELS
+// dest must not alias any of the arguments
+template<SP_MATRIX_T(M1), SP_MATRIX_T(M2), SP_MATRIX_T(M3)>
+void split_mul(M1 &&dest, M2 &&A, M3 &&B) noexcept{
+	SP_MATRIX_ERROR(cols(A) != rows(B), "multiplied matrices must have matching inner dimensions");
+	typedef typename std::decay_t<M1>::ValueType::ValueType T;
+	const size_t blockSize = mul_block_len<T>();
+	size_t m = rows(A), k = cols(A), n = cols(B);
+
+	resize(dest, m, n);
+	T *cr = beg_real(dest), *ci = beg_imag(dest);
+	const T *ar = beg_real(A), *ai = beg_imag(A);
+	const T *br = beg_real(B), *bi = beg_imag(B);
+	for (size_t i=0; i!=m*n; ++i){
+		cr[i] = (T)0;
+		ci[i] = (T)0;
+	}
+
+	for (size_t ii=0; ii<m; ii+=blockSize)
+		for (size_t pp=0; pp<k; pp+=blockSize)
+			for (size_t jj=0; jj<n; jj+=blockSize){
+				size_t iEnd = min(ii+blockSize, m);
+				size_t pEnd = min(pp+blockSize, k);
+				size_t jLen = min(jj+blockSize, n) - jj;
+				for (size_t i=ii; i!=iEnd; ++i)
+					for (size_t p=pp; p!=pEnd; ++p)
+						priv__::split_axpy(
+							cr + i*n + jj, ci + i*n + jj, ar[i*k+p], ai[i*k+p],
+							br + p*n + jj, bi + p*n + jj, jLen
+						);
+			}
+}
+
+template<SP_VECTOR_T(V1), SP_MATRIX_T(M), SP_VECTOR_T(V2)>
+void split_mul(V1 &&dest, M &&A, V2 &&x) noexcept{
+	SP_MATRIX_ERROR(cols(A) != len(x), "vector's size must be equal to number of columns of the matrix");
+	size_t m = rows(A), k = cols(A);
+
+	resize(dest, m);
+	auto *yr = beg_real(dest);
+	auto *yi = beg_imag(dest);
+	for (size_t i=0; i!=m; ++i){
+		auto res = priv__::split_dot(
+			beg_real(A) + i*k, beg_imag(A) + i*k, beg_real(x), beg_imag(x), k
+		);
+		yr[i] = res.real;
+		yi[i] = res.imag;
+	}
+}
+
+template<SP_MATRIX_T(M), class Cont>
+void split_lup_decompose(M &&dest, Cont &permuts) noexcept{
+	SP_MATRIX_ERROR(rows(dest) != cols(dest), "only square matrix can be lu decomposed");
+	typedef typename std::decay_t<M>::ValueType::ValueType T;
+	size_t length = rows(dest);
+	T *re = beg_real(dest);
+	T *im = beg_imag(dest);
+
+	resize(permuts, length);
+	for (size_t i=0; i!=length; ++i) permuts[i] = i;
+
+	for (size_t i=0; i!=length; ++i){
+		{
+			size_t j = i;
+			T maxAbs = re[i*length+i]*re[i*length+i] + im[i*length+i]*im[i*length+i];
+			for (size_t k=i+1; k!=length; ++k){	// find row with max value
+				T currAbs = re[k*length+i]*re[k*length+i] + im[k*length+i]*im[k*length+i];
+				if (currAbs > maxAbs){
+					j = k;
+					maxAbs = currAbs;
+				}
+			}
+			if (j != i){
+				for (size_t k=0; k!=length; ++k){	// exchange top row with row with max value
+					swap(re[i*length+k], re[j*length+k]);
+					swap(im[i*length+k], im[j*length+k]);
+				}
+				swap(permuts[i], permuts[j]);
+			}
+		}
+		T pr = re[i*(length+1)], pi = im[i*(length+1)];
+		T inv = (T)1 / (pr*pr + pi*pi);
+		for (size_t j=i+1; j!=length; ++j){
+			T ar = re[j*length+i], ai = im[j*length+i];
+			T fr = (ar*pr + ai*pi) * inv;
+			T fi = (ai*pr - ar*pi) * inv;
+			re[j*length+i] = fr;
+			im[j*length+i] = fi;
+			priv__::split_axpy(
+				re + j*length + i+1, im + j*length + i+1, -fr, -fi,
+				re + i*length + i+1, im + i*length + i+1, length-i-1
+			);
+		}
+	}
+}
+
+// dest must not alias the right hand side
+template<SP_VECTOR_T(V1), SP_MATRIX_T(M), class Cont, SP_VECTOR_T(V2)>
+void split_lup_solve(V1 &&dest, M &&LU, const Cont &permuts, V2 &&b) noexcept{
+	SP_MATRIX_ERROR(rows(LU) != cols(LU), "only square matrix can be used as set of linear equations");
+	SP_MATRIX_ERROR(rows(LU) != len(permuts),
+		"permutaton array's size must be equal to number of rows of permuted matrix"
+	);
+	typedef typename std::decay_t<M>::ValueType::ValueType T;
+	size_t length = rows(LU);
+	const T *re = beg_real(LU);
+	const T *im = beg_imag(LU);
+
+	resize(dest, length);
+	T *xr = beg_real(dest);
+	T *xi = beg_imag(dest);
+	for (size_t i=0; i!=length; ++i){
+		Complex<T> val = b[(size_t)permuts[i]];
+		Complex<T> sum = priv__::split_dot(re + i*length, im + i*length, xr, xi, i);
+		xr[i] = val.real - sum.real;
+		xi[i] = val.imag - sum.imag;
+	}
+	for (size_t i=length-1; i!=(size_t)-1; --i){
+		Complex<T> sum = priv__::split_dot(
+			re + i*length + i+1, im + i*length + i+1, xr + i+1, xi + i+1, length-i-1
+		);
+		T vr = xr[i] - sum.real, vi = xi[i] - sum.imag;
+		T pr = re[i*(length+1)], pi = im[i*(length+1)];
+		T inv = (T)1 / (pr*pr + pi*pi);
+		xr[i] = (vr*pr + vi*pi) * inv;
+		xi[i] = (vi*pr - vr*pi) * inv;
+	}
+}
+
+
+
+} // END OF NAMESPACE ///////////////////////////////////////////////////////////////////
@@ -0,0 +1,395 @@
+#pragma once
+
+#include "Operations.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace sp{
+
+// BINARY MATRIX FILES
+// The file starts with 64 byte header, which is followed by elements stored line after line in
+// the layout of saved matrix, without any padding. The data starts at multiple of the alignment
+// recorded in header (page size by default), so the file can be mapped and used in place.
+// Elements are written in native byte order, files with different order are rejected.
+
+constexpr size_t MatrixFileAlign = 4096;
+constexpr uint32_t MatrixFileByteOrder = 0x01020304;
+constexpr uint8_t MatrixFileVersion = 1;
+
+enum class MatrixElemType : uint8_t{
+	Other, Int8, Int16, Int32, Int64, Uint8, Uint16, Uint32, Uint64, Float32, Float64
+};
+
+template<class T>
+constexpr MatrixElemType ElemTypeOf = std::is_floating_point_v<T> ? (
+	sizeof(T) == 4 ? MatrixElemType::Float32 : sizeof(T) == 8 ? MatrixElemType::Float64 : MatrixElemType::Other
+) : std::is_integral_v<T> ? (
+	sizeof(T) == 1 ? (std::is_signed_v<T> ? MatrixElemType::Int8 : MatrixElemType::Uint8) :
+	sizeof(T) == 2 ? (std::is_signed_v<T> ? MatrixElemType::Int16 : MatrixElemType::Uint16) :
+	sizeof(T) == 4 ? (std::is_signed_v<T> ? MatrixElemType::Int32 : MatrixElemType::Uint32) :
+	sizeof(T) == 8 ? (std::is_signed_v<T> ? MatrixElemType::Int64 : MatrixElemType::Uint64) :
+	MatrixElemType::Other
+) : MatrixElemType::Other;
+
+struct MatrixFileHeader{
+	char magic[4];
+	uint32_t byteOrder;
+	uint8_t version;
+	MatrixElemType elemType;
+	uint8_t elemSize;
+	uint8_t flags;
+	uint32_t alignment;
+	uint64_t rows;
+	uint64_t cols;
+	uint64_t offset;
+	uint8_t reserved[24];
+
+	constexpr static uint8_t RowMajorFlag = 1;
+	constexpr static uint8_t VectorFlag = 2;
+};
+
+static_assert(sizeof(MatrixFileHeader) == 64, "matrix file header must have 64 bytes");
+
+
+
+namespace priv__{
+
+template<class T>
+MatrixFileHeader make_header(size_t rows, size_t cols, uint8_t flags) noexcept{
+	MatrixFileHeader h = {};
+	memcpy(h.magic, "SPMF", 4);
+	h.byteOrder = MatrixFileByteOrder;
+	h.version = MatrixFileVersion;
+	h.elemType = ElemTypeOf<T>;
+	h.elemSize = sizeof(T);
+	h.flags = flags;
+	h.alignment = MatrixFileAlign;
+	h.rows = rows;
+	h.cols = cols;
+	h.offset = MatrixFileAlign;
+	return h;
+}
+
+// checks if the header describes elements of specified type and if their size fits into the file
+template<class T>
+bool check_header(const MatrixFileHeader &h, size_t fileSize, bool isVector) noexcept{
+	return memcmp(h.magic, "SPMF", 4) || h.byteOrder != MatrixFileByteOrder ||
+		h.version != MatrixFileVersion || h.elemType != ElemTypeOf<T> || h.elemSize != sizeof(T) ||
+		(bool)(h.flags & MatrixFileHeader::VectorFlag) != isVector ||
+		h.rows > UINT32_MAX || h.cols > UINT32_MAX || h.offset < sizeof(MatrixFileHeader) ||
+		h.offset > fileSize || (fileSize - h.offset) / sizeof(T) < h.rows * h.cols;
+}
+
+// resizes the destination, which may not report failures
+template<class M, class... Dims>
+SP_SI bool try_resize(M &dest, Dims... dims) noexcept{
+	if constexpr (std::is_same_v<decltype(resize(dest, dims...)), bool>)
+		return resize(dest, dims...);
+	else{
+		resize(dest, dims...);
+		return false;
+	}
+}
+
+template<class V, class = void>
+constexpr bool IsContiguous = false;
+
+template<class V>
+constexpr bool IsContiguous<V, std::enable_if_t<
+	std::is_same_v<decltype(beg(std::declval<const V &>())), typename V::ValueType *>
+>> = true;
+
+SP_SI size_t file_size(FILE *file) noexcept{
+	struct stat st;
+	if (fstat(fileno(file), &st)) return 0;
+	return st.st_size;
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+
+
+// writes the matrix into binary file, matrices of undefined layout are written by rows,
+// returns true if the file couldn't be written
+template<SP_MATRIX_T(M)>
+bool save(const char *path, M &&A) noexcept{
+	typedef std::decay_t<M> S;
+	typedef typename S::ValueType T;
+	constexpr bool RowMaj = S::UndefMajor || S::RowMajor;
+	size_t lineCount = RowMaj ? rows(A) : cols(A);
+	size_t lineLen = RowMaj ? cols(A) : rows(A);
+
+	FILE *file = fopen(path, "wb");
+	if (!file) return true;
+	MatrixFileHeader h = priv__::make_header<T>(rows(A), cols(A), RowMaj ? MatrixFileHeader::RowMajorFlag : 0);
+	bool failed = fwrite(&h, sizeof(h), 1, file) != 1 || fseek(file, h.offset, SEEK_SET);
+
+	if constexpr (priv__::HasLeadDim<S> && !S::UndefMajor){
+		const T *data = beg(A);
+		size_t ld = lead_dim(A);
+		if (ld == lineLen){
+			failed = failed || fwrite(data, sizeof(T), lineCount*lineLen, file) != lineCount*lineLen;
+		} else{
+			for (size_t i=0; i!=lineCount && !failed; ++i)
+				failed = fwrite(data + i*ld, sizeof(T), lineLen, file) != lineLen;
+		}
+	} else{
+		size_t oldSize = len(MatrixTempStorage.data);
+		expand_back(MatrixTempStorage.data, (lineLen*sizeof(T) + 7) / 8);
+		T *line = (T *)(beg(MatrixTempStorage.data) + oldSize);
+		for (size_t i=0; i!=lineCount && !failed; ++i){
+			for (size_t j=0; j!=lineLen; ++j) line[j] = RowMaj ? A(i, j) : A(j, i);
+			failed = fwrite(line, sizeof(T), lineLen, file) != lineLen;
+		}
+		resize(MatrixTempStorage.data, oldSize);
+		if constexpr (S::UsesBuffer)
+			resize(MatrixTempStorage.data, MatrixTempStorage.stack_pos);
+	}
+
+	return fclose(file) || failed;
+}
+
+// reads the matrix from binary file, element type must be the same as in the file, layout
+// may differ, returns true if the file couldn't be read or the matrix couldn't be resized
+template<SP_MATRIX_T(M)>
+bool load(M &&dest, const char *path) noexcept{
+	typedef std::decay_t<M> D;
+	typedef typename D::ValueType T;
+
+	FILE *file = fopen(path, "rb");
+	if (!file) return true;
+	MatrixFileHeader h;
+	if (
+		fread(&h, sizeof(h), 1, file) != 1 || priv__::check_header<T>(h, priv__::file_size(file), false) ||
+		fseek(file, h.offset, SEEK_SET) || priv__::try_resize(dest, h.rows, h.cols)
+	){
+		fclose(file);
+		return true;
+	}
+	bool fileRowMaj = h.flags & MatrixFileHeader::RowMajorFlag;
+	size_t lineCount = fileRowMaj ? h.rows : h.cols;
+	size_t lineLen = fileRowMaj ? h.cols : h.rows;
+	bool failed = false;
+
+	bool direct = false;
+	if constexpr (priv__::HasLeadDim<D>){
+		if (D::RowMajor == fileRowMaj){
+			direct = true;
+			T *data = beg(dest);
+			size_t ld = lead_dim(dest);
+			if (ld == lineLen){
+				failed = fread(data, sizeof(T), lineCount*lineLen, file) != lineCount*lineLen;
+			} else{
+				for (size_t i=0; i!=lineCount && !failed; ++i)
+					failed = fread(data + i*ld, sizeof(T), lineLen, file) != lineLen;
+			}
+		}
+	}
+	if (!direct){
+		size_t oldSize = len(MatrixTempStorage.data);
+		expand_back(MatrixTempStorage.data, (lineLen*sizeof(T) + 7) / 8);
+		T *line = (T *)(beg(MatrixTempStorage.data) + oldSize);
+		for (size_t i=0; i!=lineCount && !failed; ++i){
+			failed = fread(line, sizeof(T), lineLen, file) != lineLen;
+			if (fileRowMaj)
+				for (size_t j=0; j!=lineLen; ++j) dest(i, j) = line[j];
+			else
+				for (size_t j=0; j!=lineLen; ++j) dest(j, i) = line[j];
+		}
+		resize(MatrixTempStorage.data, oldSize);
+	}
+
+	fclose(file);
+	return failed;
+}
+
+// writes the vector into binary file, returns true if the file couldn't be written
+template<SP_VECTOR_T(V)>
+bool save(const char *path, V &&A) noexcept{
+	typedef std::decay_t<V> S;
+	typedef typename S::ValueType T;
+	size_t n = len(A);
+
+	FILE *file = fopen(path, "wb");
+	if (!file) return true;
+	MatrixFileHeader h = priv__::make_header<T>(n, 1, MatrixFileHeader::VectorFlag);
+	bool failed = fwrite(&h, sizeof(h), 1, file) != 1 || fseek(file, h.offset, SEEK_SET);
+
+	if constexpr (priv__::IsContiguous<S>){
+		failed = failed || fwrite(beg(A), sizeof(T), n, file) != n;
+	} else{
+		constexpr size_t ChunkLen = CacheAvalible / sizeof(T);
+		size_t oldSize = len(MatrixTempStorage.data);
+		expand_back(MatrixTempStorage.data, (ChunkLen*sizeof(T) + 7) / 8);
+		T *chunk = (T *)(beg(MatrixTempStorage.data) + oldSize);
+		for (size_t i=0; i<n && !failed; i+=ChunkLen){
+			size_t count = n-i < ChunkLen ? n-i : ChunkLen;
+			for (size_t j=0; j!=count; ++j) chunk[j] = A[i+j];
+			failed = fwrite(chunk, sizeof(T), count, file) != count;
+		}
+		resize(MatrixTempStorage.data, oldSize);
+		if constexpr (S::UsesBuffer)
+			resize(MatrixTempStorage.data, MatrixTempStorage.stack_pos);
+	}
+
+	return fclose(file) || failed;
+}
+
+// reads the vector from binary file, element type must be the same as in the file, returns
+// true if the file couldn't be read or the vector couldn't be resized
+template<SP_VECTOR_T(V)>
+bool load(V &&dest, const char *path) noexcept{
+	typedef typename std::decay_t<V>::ValueType T;
+
+	FILE *file = fopen(path, "rb");
+	if (!file) return true;
+	MatrixFileHeader h;
+	if (
+		fread(&h, sizeof(h), 1, file) != 1 || priv__::check_header<T>(h, priv__::file_size(file), true) ||
+		fseek(file, h.offset, SEEK_SET) || priv__::try_resize(dest, h.rows)
+	){
+		fclose(file);
+		return true;
+	}
+	bool failed = false;
+	if constexpr (priv__::IsContiguous<std::decay_t<V>>){
+		failed = fread(beg(dest), sizeof(T), h.rows, file) != h.rows;
+	} else{
+		constexpr size_t ChunkLen = CacheAvalible / sizeof(T);
+		size_t oldSize = len(MatrixTempStorage.data);
+		expand_back(MatrixTempStorage.data, (ChunkLen*sizeof(T) + 7) / 8);
+		T *chunk = (T *)(beg(MatrixTempStorage.data) + oldSize);
+		for (size_t i=0; i<h.rows && !failed; i+=ChunkLen){
+			size_t count = h.rows-i < ChunkLen ? h.rows-i : ChunkLen;
+			failed = fread(chunk, sizeof(T), count, file) != count;
+			for (size_t j=0; j!=count; ++j) dest[i+j] = chunk[j];
+		}
+		resize(MatrixTempStorage.data, oldSize);
+	}
+	fclose(file);
+	return failed;
+}
+
+
+
+// MEMORY MAPPED MATRIX
+// The elements are used directly from the mapped file, so nothing is read at startup and pages
+// are loaded only when they are touched. Layout of the file must match the matrix type.
+template<class T, bool rowMaj>
+struct MatrixMapped{
+	typedef T ValueType;
+	static constexpr StupidMatrixFlagType MatrixFlag{};
+	constexpr static bool RowMajor = rowMaj;
+	constexpr static bool UndefMajor = false;
+	constexpr static bool UsesBuffer = false;
+
+	SP_CI T &operator ()(size_t r, size_t c) noexcept{
+		SP_MATRIX_ERROR(r>=rows || c>=cols, "out of bounds matrix indecies");
+		if constexpr (RowMajor)
+			return ptr[r*cols + c];
+		else
+			return ptr[r + c*rows];
+	}
+
+	SP_CI const T &operator ()(size_t r, size_t c) const noexcept{
+		SP_MATRIX_ERROR(r>=rows || c>=cols, "out of bounds matrix indecies");
+		if constexpr (RowMajor)
+			return ptr[r*cols + c];
+		else
+			return ptr[r + c*rows];
+	}
+
+	T *ptr = nullptr;
+	uint32_t rows = 0;
+	uint32_t cols = 0;
+	Memblock map = {nullptr, 0};
+};
+
+template<class T, bool rowMaj>
+SP_CSI size_t rows(const MatrixMapped<T, rowMaj> &m) noexcept{ return m.rows; }
+
+template<class T, bool rowMaj>
+SP_CSI size_t cols(const MatrixMapped<T, rowMaj> &m) noexcept{ return m.cols; }
+
+template<class T, bool rowMaj>
+SP_CSI size_t len(const MatrixMapped<T, rowMaj> &m) noexcept{ return (size_t)m.rows * m.cols; }
+
+template<class T, bool rowMaj>
+SP_CSI size_t cap(const MatrixMapped<T, rowMaj> &m) noexcept{ return 0; }
+
+template<class T, bool rowMaj>
+SP_CSI size_t lead_dim(const MatrixMapped<T, rowMaj> &m) noexcept{ return rowMaj ? m.cols : m.rows; }
+
+template<class T, bool rowMaj>
+SP_CSI T *beg(const MatrixMapped<T, rowMaj> &m) noexcept{ return m.ptr; }
+
+template<class T, bool rowMaj>
+SP_CSI T *end(const MatrixMapped<T, rowMaj> &m) noexcept{ return m.ptr + (size_t)m.rows*m.cols - 1; }
+
+template<class T, bool rowMaj>
+SP_SI void resize(MatrixMapped<T, rowMaj> &m, size_t r, size_t c) noexcept{
+	SP_MATRIX_ERROR(r!=m.rows || c!=m.cols, "mapped matrix cannot be resized");
+}
+
+template<class T, bool RowMajor = true>
+using MappedMatrix = MatrixWrapper<MatrixMapped<T, RowMajor>>;
+
+
+// maps the binary matrix file, writable mapping stores all changes in the file, returns true
+// if the file couldn't be mapped or its element type or layout doesn't match the matrix
+template<class T, bool rowMaj>
+bool map_file(MatrixMapped<T, rowMaj> &dest, const char *path, bool writable = false) noexcept{
+	int32_t fd = open(path, writable ? O_RDWR : O_RDONLY);
+	if (fd < 0) return true;
+	struct stat st;
+	MatrixFileHeader h;
+	if (
+		fstat(fd, &st) || pread(fd, &h, sizeof(h), 0) != sizeof(h) ||
+		priv__::check_header<T>(h, st.st_size, false) ||
+		(bool)(h.flags & MatrixFileHeader::RowMajorFlag) != rowMaj
+	){
+		close(fd);
+		return true;
+	}
+
+	size_t size = h.offset + h.rows*h.cols*sizeof(T);
+	void *map = mmap(
+		nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, writable ? MAP_SHARED : MAP_PRIVATE, fd, 0
+	);
+	close(fd);
+	if (map == MAP_FAILED) return true;
+
+	dest.map = {(uint8_t *)map, size};
+	dest.ptr = (T *)((uint8_t *)map + h.offset);
+	dest.rows = h.rows;
+	dest.cols = h.cols;
+	return false;
+}
+
+// creates the binary matrix file of specified size filled with zeros and maps it for writing,
+// returns true if the file couldn't be created or mapped
+template<class T, bool rowMaj>
+bool map_new_file(MatrixMapped<T, rowMaj> &dest, const char *path, size_t rows, size_t cols) noexcept{
+	int32_t fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) return true;
+	MatrixFileHeader h = priv__::make_header<T>(rows, cols, rowMaj ? MatrixFileHeader::RowMajorFlag : 0);
+	bool failed = pwrite(fd, &h, sizeof(h), 0) != sizeof(h) || ftruncate(fd, h.offset + rows*cols*sizeof(T));
+	close(fd);
+	return failed || map_file(dest, path, true);
+}
+
+// unmaps the matrix, changes of writable mapping are written back to the file
+template<class T, bool rowMaj>
+void unmap(MatrixMapped<T, rowMaj> &m) noexcept{
+	if (m.map.ptr) munmap(m.map.ptr, m.map.size);
+	m.map = {nullptr, 0};
+	m.ptr = nullptr;
+	m.rows = 0;
+	m.cols = 0;
+}
+
+} // END OF NAMESPACE ///////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "Bases.hpp"
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace sp{
+
+
+// compile time defaults, used where sizes must be constant and when nothing better is known
+constexpr size_t CacheSize = 32768;
+constexpr size_t CachePage = 64;
+
+constexpr size_t CacheAvalible = CacheSize / 2;
+constexpr size_t CacheBlockLen = int_sqrt(CacheAvalible);
+template<class T>
+constexpr size_t MulBlockLen = int_sqrt(CacheAvalible / (3*sizeof(T)));	// three blocks of a product fit
+constexpr size_t StrassenCrossover = 256;
+template<class T>
+constexpr size_t TraverseBlockLen = int_sqrt(CacheAvalible / (2*sizeof(T)));	// source and destination tiles fit
+constexpr size_t LuPanelLen = 64;
+constexpr size_t Cache2Size = 262144;
+
+
+
+// TUNING
+// Block sizes used by the kernels at runtime. At startup they are read from the tuning file,
+// which is named by SP_MATRIX_TUNING environment variable or is .sp_matrix_tuning in the home
+// directory. Without the file they are derived from the size of level 1 data cache, taken from
+// sysconf or /sys/devices/system/cpu, and the compile time defaults are the last resort. The
+// file holds "name value" lines, it's written by save_tuning, usually after autotune.
+//
+// Working sets are stored in bytes, so one file serves all element types.
+
+struct MatrixTuning{
+	size_t cacheL1;	// bytes of data caches
+	size_t cacheL2;
+	size_t cacheL3;
+	size_t mulBytes;	// bytes of three tiles of blocked product
+	size_t traverseBytes;	// bytes of two tiles of transpose and mixed layout traversal
+	size_t luPanel;	// columns of panel of blocked lu decomposition, used above level 2 cache
+};
+
+
+
+namespace priv__{
+
+// size of data or unified cache of given level in bytes, or zero if it's unknown
+inline size_t cache_size(uint32_t level) noexcept{
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+	int64_t res = sysconf(
+		level == 1 ? _SC_LEVEL1_DCACHE_SIZE : level == 2 ? _SC_LEVEL2_CACHE_SIZE : _SC_LEVEL3_CACHE_SIZE
+	);
+	if (res > 0) return res;
+#endif
+	char path[64];
+	for (uint32_t i=0; i!=8; ++i){
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%" PRIu32 "/level", i);
+		FILE *file = fopen(path, "r");
+		if (!file) break;
+		uint32_t fileLevel = 0;
+		bool ok = fscanf(file, "%" SCNu32, &fileLevel) == 1;
+		fclose(file);
+		if (!ok || fileLevel != level) continue;
+
+		char type[16] = "";
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%" PRIu32 "/type", i);
+		if ((file = fopen(path, "r"))){
+			ok = fscanf(file, "%15s", type) == 1;
+			fclose(file);
+		}
+		if (!strcmp(type, "Instruction")) continue;
+
+		size_t size = 0;
+		char unit = 0;
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%" PRIu32 "/size", i);
+		if ((file = fopen(path, "r"))){
+			ok = fscanf(file, "%zu%c", &size, &unit) >= 1;
+			fclose(file);
+		}
+		if (unit == 'K') size <<= 10;
+		if (unit == 'M') size <<= 20;
+		if (size) return size;
+	}
+	return 0;
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+
+
+// path of the tuning file read at startup, null if there is no home directory
+inline const char *default_tuning_path() noexcept{
+	static char path[512];
+	const char *env = getenv("SP_MATRIX_TUNING");
+	if (env) return env;
+	const char *home = getenv("HOME");
+	if (!home) return nullptr;
+	snprintf(path, sizeof(path), "%s/.sp_matrix_tuning", home);
+	return path;
+}
+
+
+
+// block sizes derived from the sizes of caches of this machine
+inline MatrixTuning detect_tuning() noexcept{
+	MatrixTuning res;
+	res.cacheL1 = priv__::cache_size(1);
+	res.cacheL2 = priv__::cache_size(2);
+	if (!res.cacheL2) res.cacheL2 = Cache2Size;
+	res.cacheL3 = priv__::cache_size(3);
+	size_t available = res.cacheL1 ? res.cacheL1 / 2 : CacheAvalible;
+	res.mulBytes = available;
+	res.traverseBytes = available;
+	res.luPanel = LuPanelLen;
+	return res;
+}
+
+// reads block sizes from the tuning file, values missing from the file are left unchanged,
+// returns true if the file couldn't be read
+inline bool load_tuning(MatrixTuning &dest, const char *path) noexcept{
+	if (!path) return true;
+	FILE *file = fopen(path, "r");
+	if (!file) return true;
+	char name[64];
+	size_t value;
+	int32_t res;
+	while ((res = fscanf(file, "%63s %zu", name, &value)) != EOF){
+		if (res != 2){
+			if (fscanf(file, "%*[^\n]") == EOF) break;	// comment or broken line
+			continue;
+		}
+		if (!value) continue;
+		if (!strcmp(name, "cache_l1")) dest.cacheL1 = value;
+		else if (!strcmp(name, "cache_l2")) dest.cacheL2 = value;
+		else if (!strcmp(name, "cache_l3")) dest.cacheL3 = value;
+		else if (!strcmp(name, "mul_bytes")) dest.mulBytes = value;
+		else if (!strcmp(name, "traverse_bytes")) dest.traverseBytes = value;
+		else if (!strcmp(name, "lu_panel")) dest.luPanel = value;
+	}
+	fclose(file);
+	return false;
+}
+
+// writes block sizes into the tuning file, returns true if it couldn't be written
+inline bool save_tuning(const char *path, const MatrixTuning &src) noexcept{
+	if (!path) return true;
+	FILE *file = fopen(path, "w");
+	if (!file) return true;
+	fprintf(
+		file,
+		"# block sizes of sp matrix kernels\n"
+		"cache_l1 %zu\ncache_l2 %zu\ncache_l3 %zu\nmul_bytes %zu\ntraverse_bytes %zu\nlu_panel %zu\n",
+		src.cacheL1, src.cacheL2, src.cacheL3, src.mulBytes, src.traverseBytes, src.luPanel
+	);
+	return fclose(file) != 0;
+}
+
+
+
+namespace priv__{
+
+inline MatrixTuning startup_tuning() noexcept{
+	MatrixTuning res = detect_tuning();
+	load_tuning(res, default_tuning_path());
+	return res;
+}
+
+} // END OF NAMESPACE PRIV //////////
+
+
+
+// block sizes used by the kernels, can be changed at any time
+inline MatrixTuning matrixTuning = priv__::startup_tuning();
+
+template<class T>
+size_t mul_block_len() noexcept{
+	size_t res = int_sqrt(matrixTuning.mulBytes / (3*sizeof(T)));
+	return res ? res : 1;
+}
+
+template<class T>
+size_t traverse_block_len() noexcept{
+	size_t res = int_sqrt(matrixTuning.traverseBytes / (2*sizeof(T)));
+	return res ? res : 1;
+}
+
+} // END OF NAMESPACE ///////////////////////////////////////////////////////////////////////////////////////
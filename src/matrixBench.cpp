@@ -0,0 +1,267 @@
+#include "matrix/Matrix.hpp"
+#include "matrix/Autotune.hpp"
+#include "SPL/Complex.hpp"
+#include "SPL/FixedPoint.hpp"
+
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include <thread>
+
+// Benchmark of the matrix kernels. Every kernel is run for every size, element type, layout
+// and (where it is parallel) thread count, the median time and its variance are printed with
+// rates derived from them. The results are also written as csv into the file given as first
+// argument, the second argument limits the largest size. With --tune block sizes of the kernels
+// are tuned for this machine and written into given file or the default tuning file.
+//
+//     matrixBench [results.csv] [max size]
+//     matrixBench --tune [tuning file]
+
+using Mallocator = sp::MallocAllocator<>;
+using Permutations = sp::DynamicArray<uint32_t, Mallocator>;
+
+template<class T, bool RowMajor, bool Padded>
+using BenchMatrix = sp::MatrixWrapper<sp::MatrixDynamic<T, RowMajor, Mallocator, Padded>>;
+template<class T>
+using BenchVector = sp::VectorWrapper<sp::VectorDynamic<T, Mallocator>>;
+
+constexpr size_t Sizes[] = {32, 64, 128, 256, 512, 1024, 2048};
+constexpr size_t Repetitions = 9;
+constexpr double MinSeconds = 0.2;	// fewer repetitions of kernels slower than that
+
+Mallocator allocator;
+FILE *csv = nullptr;
+
+
+
+template<class T> constexpr bool IsComplex = false;
+template<class T> constexpr bool IsComplex<sp::Complex<T>> = true;
+
+template<class T> constexpr bool IsFixed = false;
+template<size_t B, class T> constexpr bool IsFixed<sp::FixedPoint<B, T>> = true;
+
+template<class T> constexpr const char *TypeName = "";
+template<> constexpr const char *TypeName<float> = "float";
+template<> constexpr const char *TypeName<double> = "double";
+template<> constexpr const char *TypeName<sp::Complex<double>> = "complex";
+template<> constexpr const char *TypeName<sp::FixedPoint<16, int32_t>> = "fixed16";
+
+// real operations done by one multiply add of elements
+template<class T> constexpr double MulAddFlops = IsComplex<T> ? 8.0 : 2.0;
+
+template<class T>
+T make_value(double x, double y) noexcept{
+	if constexpr (IsComplex<T>)
+		return T{x, y};
+	else if constexpr (IsFixed<T>)
+		return T{(int32_t)(x * 65536.0)};
+	else
+		return (T)x;
+}
+
+template<class M>
+void fill_random(M &m, size_t r, size_t c, uint32_t seed, double diagonal = 0.0){
+	typedef typename std::decay_t<M>::ValueType T;
+	sp::Philox32 rng{seed};
+	sp::resize(m, r, c);
+	for (size_t i=0; i!=r; ++i)
+		for (size_t j=0; j!=c; ++j){
+			uint64_t bits = rng((uint32_t)i, (uint32_t)j);
+			double x = sp::unit_real<double>(bits) - 0.5;
+			double y = sp::unit_real<double>(bits << 32) - 0.5;
+			m(i, j) = make_value<T>(x + (i==j ? diagonal : 0.0), y);
+		}
+}
+
+double now() noexcept{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+
+
+struct BenchRes{
+	double median;
+	double variance;
+	size_t reps;
+};
+
+// times the kernel after a warm up run, setup is run before every repetition and isn't timed
+template<class S, class F>
+BenchRes measure(S &&setup, F &&kernel){
+	double times[Repetitions];
+	setup();
+	double t0 = now();
+	kernel();
+	double first = now() - t0;
+	size_t reps = first > MinSeconds ? 3 : Repetitions;
+
+	for (size_t i=0; i!=reps; ++i){
+		setup();
+		t0 = now();
+		kernel();
+		times[i] = now() - t0;
+	}
+	for (size_t i=1; i<reps; ++i)
+		for (size_t j=i; j && times[j-1]>times[j]; --j) sp::swap(times[j-1], times[j]);
+
+	BenchRes res;
+	res.median = times[reps/2];
+	double mean = 0.0;
+	for (size_t i=0; i!=reps; ++i) mean += times[i];
+	mean /= reps;
+	res.variance = 0.0;
+	for (size_t i=0; i!=reps; ++i) res.variance += (times[i]-mean) * (times[i]-mean);
+	res.variance /= reps;
+	res.reps = reps;
+	return res;
+}
+
+void report(
+	const char *kernel, const char *type, const char *layout, size_t threads, size_t n,
+	BenchRes res, double flops, double bytes
+){
+	double gflops = flops / res.median * 1e-9;
+	double gbytes = bytes / res.median * 1e-9;
+	printf(
+		"%-10s %-8s %-6s %3zu %5zu  %10.4f ms  var %9.3e ms^2  %8.3f GFLOP/s  %8.3f GB/s\n",
+		kernel, type, layout, threads, n, res.median*1e3, res.variance*1e6, gflops, gbytes
+	);
+	if (csv){
+		fprintf(
+			csv, "%s,%s,%s,%zu,%zu,%zu,%.6e,%.6e,%.6f,%.6f\n",
+			kernel, type, layout, threads, n, res.reps, res.median, res.variance, gflops, gbytes
+		);
+		fflush(csv);
+	}
+}
+
+
+
+template<class T, bool RowMajor, bool Padded>
+void bench_layout(const char *layout, size_t maxSize){
+	typedef BenchMatrix<T, RowMajor, Padded> M;
+	const char *type = TypeName<T>;
+	constexpr bool IsReal = std::is_floating_point_v<T>;
+	size_t hardwareThreads = std::thread::hardware_concurrency();
+	if (!hardwareThreads) hardwareThreads = 1;
+	auto none = [](){};
+
+	for (size_t n : Sizes){
+		if (n > maxSize) break;
+		double n2 = (double)n * n;
+		double n3 = n2 * n;
+		double s = sizeof(T);
+		M A, B, C, W;
+		fill_random(A, n, n, 1, IsFixed<T> ? 0.0 : (double)n);
+		fill_random(B, n, n, 2);
+		sp::resize(C, n, n);
+
+		// products
+		if (n <= 512){
+			BenchRes r = measure(none, [&](){ C = A * B; });
+			report("mul_expr", type, layout, 1, n, r, MulAddFlops<T>*n3, 3*n2*s);
+		}
+		{
+			BenchRes r = measure(none, [&](){ sp::mat_mul(C, A, B); });
+			report("mat_mul", type, layout, 1, n, r, MulAddFlops<T>*n3, 3*n2*s);
+		}
+		{
+			BenchRes r = measure(none, [&](){ sp::strassen_mul(C, A, B, allocator, sp::StrassenCrossover); });
+			report("strassen", type, layout, 1, n, r, MulAddFlops<T>*n3, 3*n2*s);
+		}
+		if (n <= 512)
+			for (size_t t=2; t<=hardwareThreads; t*=2){	// stop once par_assign caps the thread count
+				size_t used = 0;
+				BenchRes r = measure(none, [&](){ used = sp::par_assign(C, A * B, t); });
+				if (used != t) break;
+				report("mul_expr", type, layout, used, n, r, MulAddFlops<T>*n3, 3*n2*s);
+			}
+
+		// matrix vector product
+		{
+			BenchVector<T> v, w;
+			sp::resize(v, n);
+			for (size_t i=0; i!=n; ++i) v[i] = make_value<T>(1.0 / (i+1), 0.5);
+			BenchRes r = measure(none, [&](){ w = A * v; });
+			report("gemv", type, layout, 1, n, r, MulAddFlops<T>*n2, (n2 + 2*n)*s);
+		}
+
+		// decompositions
+		if constexpr (!IsFixed<T>){
+			Permutations permuts;
+			BenchRes r = measure([&](){ W = A; }, [&](){ sp::lup_decompose(W, permuts); });
+			report("lu", type, layout, 1, n, r, MulAddFlops<T>*n3/3.0, 2*n2*s);
+
+			r = measure(none, [&](){ sp::invert(C, A); });
+			report("invert", type, layout, 1, n, r, MulAddFlops<T>*n3, 2*n2*s);
+		}
+		if constexpr (IsReal){
+			M S;
+			S = A * sp::tr(A);
+			BenchRes r = measure([&](){ W = S; }, [&](){ sp::cholesky_decompose(W); });
+			report("cholesky", type, layout, 1, n, r, MulAddFlops<T>*n3/6.0, n2*s);
+		}
+
+		// memory bound kernels
+		{
+			BenchRes r = measure(none, [&](){ sp::transpose(C, A); });
+			report("transpose", type, layout, 1, n, r, 0.0, 2*n2*s);
+		}
+		for (size_t t=1; t<=hardwareThreads; t*=2){
+			size_t used = 0;
+			BenchRes r = measure(none, [&](){ used = sp::par_assign(C, A + sp::elwise_mul(A, B), t); });
+			if (used != t) break;
+			report("elwise", type, layout, used, n, r, 2*n2*(IsComplex<T> ? 4 : 1), 3*n2*s);
+		}
+	}
+}
+
+template<class T>
+void bench_type(size_t maxSize){
+	bench_layout<T, true, false>("row", maxSize);
+	bench_layout<T, false, false>("col", maxSize);
+	bench_layout<T, true, true>("padded", maxSize);
+}
+
+
+
+int main(int argc, char **argv){
+	if (argc > 1 && !strcmp(argv[1], "--tune")){
+		sp::MatrixTuning tuning;
+		if (sp::autotune(tuning)){
+			fputs("not enough memory for tuning\n", stderr);
+			return 1;
+		}
+		const char *path = argc > 2 ? argv[2] : sp::default_tuning_path();
+		printf(
+			"caches: %zu %zu %zu\nmul_bytes %zu\ntraverse_bytes %zu\nlu_panel %zu\n",
+			tuning.cacheL1, tuning.cacheL2, tuning.cacheL3,
+			tuning.mulBytes, tuning.traverseBytes, tuning.luPanel
+		);
+		if (sp::save_tuning(path, tuning)){
+			fprintf(stderr, "cannot write %s\n", path ? path : "tuning file");
+			return 1;
+		}
+		printf("written into %s\n", path);
+		return 0;
+	}
+	if (argc > 1){
+		csv = fopen(argv[1], "w");
+		if (!csv){
+			fprintf(stderr, "cannot open %s\n", argv[1]);
+			return 1;
+		}
+		fputs("kernel,type,layout,threads,size,repetitions,median_s,variance_s2,gflops,gbps\n", csv);
+	}
+	size_t maxSize = argc > 2 ? (size_t)atol(argv[2]) : 512;
+
+	bench_type<float>(maxSize);
+	bench_type<double>(maxSize);
+	bench_type<sp::Complex<double>>(maxSize);
+	bench_type<sp::FixedPoint<16, int32_t>>(maxSize);
+
+	if (csv) fclose(csv);
+	return 0;
+}
@@ -35,9 +35,9 @@ int main(){
 	float learning_rate = 0.1f;
 	sp::Rand32 rng(clock());
 	
-	set_random_weights(input_layer, rng, 0.f, 1.f);
-	set_random_weights(hidden_layer, rng, 0.f, 1.f);
-	set_random_weights(output_layer, rng, 0.f, 1.f);
+	set_random_weights(input_layer, rng(), 0.f, 1.f);
+	set_random_weights(hidden_layer, rng(), 0.f, 1.f);
+	set_random_weights(output_layer, rng(), 0.f, 1.f);
 
 	input_layer.learning_rate = learning_rate;
 	hidden_layer.learning_rate = learning_rate;